@@ -1,18 +1,20 @@
 #include "ScenePanel.h"
 
+#include "../Scene/Importer/MeshImporter.h"
+
 #include "Walnut/UI/UI.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
-ScenePanel::ScenePanel(Camera& camera, Scene& scene, Scene& loadedScene, bool& showScenePanel)
-	: m_Camera(camera), m_Scene(scene), m_LoadedScene(loadedScene), m_ShowScenePanel(showScenePanel)
+#include <cstring>
+
+ScenePanel::ScenePanel(Camera& camera, Scene& scene, const uint64_t& savedSceneRevision, bool& showScenePanel)
+	: m_Camera(camera), m_Scene(scene), m_SavedSceneRevision(savedSceneRevision), m_ShowScenePanel(showScenePanel)
 {}
 
 bool ScenePanel::OnUIRender() {
-	bool resetFrameIndex = false;
-
 	if (m_ShowScenePanel) {
-		m_UnsavedChanges = CheckForChanges();
+		m_UnsavedChanges = m_Scene.GetRevision() != m_SavedSceneRevision;
 
 		ImGuiWindowFlags windowFlags = 0;
 		if (m_UnsavedChanges) {
@@ -48,8 +50,12 @@ bool ScenePanel::OnUIRender() {
 
 		ImGui::BeginChild("Sky##Settings", ImVec2(0, 90), true);
 		Sky& sky = m_Scene.Sky;
-		ImGui::Checkbox("Enabled", &sky.Enabled);
-		ImGui::ColorEdit3("Color", glm::value_ptr(sky.Color));
+		if (ImGui::Checkbox("Enabled", &sky.Enabled)) {
+			m_Scene.MarkSkyChanged();
+		}
+		if (ImGui::ColorEdit3("Color", glm::value_ptr(sky.Color))) {
+			m_Scene.MarkSkyChanged();
+		}
 		ImGui::EndChild();
 
 		// Lights
@@ -60,7 +66,6 @@ bool ScenePanel::OnUIRender() {
 		Walnut::UI::ShiftCursorX(ImGui::GetColumnWidth() - 50.0f);
 		if (ImGui::Button("Add##Light")) {
 			AddLight();
-			resetFrameIndex = true;
 		}
 		ImGui::Separator();
 
@@ -69,11 +74,14 @@ bool ScenePanel::OnUIRender() {
 
 			ImGui::BeginChild("Light", ImVec2(0, 128), true);
 			Light& light = m_Scene.Lights[i];
-			ImGui::Checkbox("Enabled", &light.Enabled);
-			ImGui::DragFloat3("Position", glm::value_ptr(light.Position), 0.01f);
+			if (ImGui::Checkbox("Enabled", &light.Enabled)) {
+				m_Scene.MarkLightsChanged();
+			}
+			if (ImGui::DragFloat3("Position", glm::value_ptr(light.Position), 0.01f)) {
+				m_Scene.MarkLightsChanged();
+			}
 			if (ImGui::Button("Remove", ImGui::GetContentRegionAvail())) {
 				RemoveLight(i);
-				resetFrameIndex = true;
 			}
 			ImGui::EndChild();
 
@@ -88,7 +96,6 @@ bool ScenePanel::OnUIRender() {
 		Walnut::UI::ShiftCursorX(ImGui::GetColumnWidth() - 50.0f);
 		if (ImGui::Button("Add##Sphere")) {
 			AddSphere();
-			resetFrameIndex = true;
 		}
 		ImGui::Separator();
 
@@ -96,27 +103,11 @@ bool ScenePanel::OnUIRender() {
 			ImGui::PushID(i);
 
 			ImGui::BeginChild("Sphere", ImVec2(0, 204), true);
-			Sphere& sphere = m_Scene.Spheres[i];
-			ImGui::Checkbox("Enabled", &sphere.Enabled);
-			ImGui::DragFloat3("Position", glm::value_ptr(sphere.Position), 0.01f);
-			ImGui::DragFloat("Radius", &sphere.Radius, 0.01f);
-			if (m_Scene.Materials.size() > 0) {
-				if (ImGui::BeginCombo("Material", m_Scene.Materials[sphere.MaterialIndex].Name.c_str())) {
-					for (size_t j = 0; j < m_Scene.Materials.size(); j++) {
-						bool isSelected = m_Scene.Materials[sphere.MaterialIndex] == m_Scene.Materials[j];
-						if (ImGui::Selectable(m_Scene.Materials[j].Name.c_str(), isSelected)) {
-							sphere.MaterialIndex = j;
-						}
-						if (isSelected) {
-							ImGui::SetItemDefaultFocus();
-						}
-					}
-					ImGui::EndCombo();
-				}
+			if (UI_DrawSphere(m_Scene.Spheres[i])) {
+				m_Scene.MarkSpheresChanged();
 			}
 			if (ImGui::Button("Remove", ImGui::GetContentRegionAvail())) {
 				RemoveSphere(i);
-				resetFrameIndex = true;
 			}
 			ImGui::EndChild();
 
@@ -131,7 +122,6 @@ bool ScenePanel::OnUIRender() {
 		Walnut::UI::ShiftCursorX(ImGui::GetColumnWidth() - 50.0f);
 		if (ImGui::Button("Add##Material")) {
 			AddMaterial();
-			resetFrameIndex = true;
 		}
 		ImGui::Separator();
 
@@ -140,89 +130,343 @@ bool ScenePanel::OnUIRender() {
 
 			ImGui::BeginChild("Material", ImVec2(0, 280), true);
 			Material& material = m_Scene.Materials[i];
-			ImGui::InputText("Name", material.Name.data(), sizeof(std::string) * 8);
-			ImGui::ColorEdit3("Albedo", glm::value_ptr(material.Albedo));
-			ImGui::SliderFloat("Roughness", &material.Roughness, 0.0f, 1.0f);
-			ImGui::SliderFloat("Metallic", &material.Metallic, 0.0f, 1.0f);
-			ImGui::ColorEdit3("Emission Color", glm::value_ptr(material.EmissionColor));
-			ImGui::DragFloat("Emission Power", &material.EmissionPower, 0.01f, 0.0f, std::numeric_limits<float>::max());
+			if (ImGui::InputText("Name", material.Name.data(), sizeof(std::string) * 8)) {
+				m_Scene.MarkMaterialsChanged();
+			}
+			if (ImGui::ColorEdit3("Albedo", glm::value_ptr(material.Albedo))) {
+				m_Scene.MarkMaterialsChanged();
+			}
+			if (ImGui::SliderFloat("Roughness", &material.Roughness, 0.0f, 1.0f)) {
+				m_Scene.MarkMaterialsChanged();
+			}
+			if (ImGui::SliderFloat("Metallic", &material.Metallic, 0.0f, 1.0f)) {
+				m_Scene.MarkMaterialsChanged();
+			}
+			if (ImGui::ColorEdit3("Emission Color", glm::value_ptr(material.EmissionColor))) {
+				m_Scene.MarkMaterialsChanged();
+			}
+			if (ImGui::DragFloat("Emission Power", &material.EmissionPower, 0.01f, 0.0f, std::numeric_limits<float>::max())) {
+				m_Scene.MarkMaterialsChanged();
+			}
 			if (ImGui::Button("Remove", ImGui::GetContentRegionAvail())) {
 				RemoveMaterial(i);
-				resetFrameIndex = true;
 			}
 			ImGui::EndChild();
 
 			ImGui::PopID();
 		}
 
-		ImGui::End();
-	}
+		// Prototypes
+		ImGui::Separator();
+		ImGui::AlignTextToFramePadding();
+		ImGui::Text("Prototypes");
+		ImGui::SameLine();
+		Walnut::UI::ShiftCursorX(ImGui::GetColumnWidth() - 50.0f);
+		if (ImGui::Button("Add##Prototype")) {
+			AddPrototype();
+		}
+		ImGui::Separator();
 
-	return resetFrameIndex;
-}
+		for (size_t i = 0; i < m_Scene.Prototypes.size(); i++) {
+			ImGui::PushID(i);
 
-bool ScenePanel::CheckForChanges() {
-	if (m_LoadedScene.Name != m_Scene.Name) {
-		return true;
-	}
+			Prototype& prototype = m_Scene.Prototypes[i];
+			ImGui::BeginChild("Prototype", ImVec2(0, 104 + 212 * (float)prototype.Spheres.size()), true);
+			if (ImGui::InputText("Name", prototype.Name.data(), sizeof(std::string) * 8)) {
+				m_Scene.MarkPrototypesChanged();
+			}
 
-	if (!(m_LoadedScene.Sky == m_Scene.Sky)) {
-		return true;
-	}
+			for (size_t j = 0; j < prototype.Spheres.size(); j++) {
+				ImGui::PushID(j);
 
-	if (m_LoadedScene.Lights.size() != m_Scene.Lights.size()) {
-		return true;
-	}
+				ImGui::BeginChild("Sphere", ImVec2(0, 204), true);
+				if (UI_DrawSphere(prototype.Spheres[j])) {
+					m_Scene.MarkPrototypesChanged();
+				}
+				if (ImGui::Button("Remove Sphere", ImGui::GetContentRegionAvail())) {
+					prototype.Spheres.erase(prototype.Spheres.begin() + j--);
+					m_Scene.MarkPrototypesChanged();
+				}
+				ImGui::EndChild();
+
+				ImGui::PopID();
+			}
+
+			if (ImGui::Button("Add Sphere", ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
+				prototype.Spheres.emplace_back();
+				m_Scene.MarkPrototypesChanged();
+			}
+			if (ImGui::Button("Remove", ImGui::GetContentRegionAvail())) {
+				RemovePrototype(i);
+			}
+			ImGui::EndChild();
 
-	for (size_t i = 0; i < m_LoadedScene.Lights.size(); i++) {
-		if (!(m_LoadedScene.Lights[i] == m_Scene.Lights[i])) {
-			return true;
+			ImGui::PopID();
 		}
-	}
 
-	if (m_LoadedScene.Spheres.size() != m_Scene.Spheres.size()) {
-		return true;
-	}
+		// Instances
+		ImGui::Separator();
+		ImGui::AlignTextToFramePadding();
+		ImGui::Text("Instances");
+		ImGui::SameLine();
+		Walnut::UI::ShiftCursorX(ImGui::GetColumnWidth() - 50.0f);
+		if (ImGui::Button("Add##Instance")) {
+			AddInstance();
+		}
+		ImGui::Separator();
+
+		for (size_t i = 0; i < m_Scene.Instances.size(); i++) {
+			ImGui::PushID(i);
+
+			ImGui::BeginChild("Instance", ImVec2(0, 256), true);
+			Instance& instance = m_Scene.Instances[i];
+			if (ImGui::Checkbox("Enabled", &instance.Enabled)) {
+				m_Scene.MarkInstancesChanged();
+			}
+			bool validPrototype = instance.PrototypeIndex >= 0 && instance.PrototypeIndex < (int)m_Scene.Prototypes.size();
+			if (ImGui::BeginCombo("Prototype", validPrototype ? m_Scene.Prototypes[instance.PrototypeIndex].Name.c_str() : "None")) {
+				for (size_t j = 0; j < m_Scene.Prototypes.size(); j++) {
+					bool isSelected = instance.PrototypeIndex == (int)j;
+					if (ImGui::Selectable(m_Scene.Prototypes[j].Name.c_str(), isSelected)) {
+						instance.PrototypeIndex = (int)j;
+						m_Scene.MarkInstancesChanged();
+					}
+					if (isSelected) {
+						ImGui::SetItemDefaultFocus();
+					}
+				}
+				ImGui::EndCombo();
+			}
+			if (ImGui::DragFloat3("Position", glm::value_ptr(instance.Position), 0.01f)) {
+				m_Scene.MarkInstancesChanged();
+			}
+			if (ImGui::DragFloat3("Rotation", glm::value_ptr(instance.Rotation), 0.5f)) {
+				m_Scene.MarkInstancesChanged();
+			}
+			if (ImGui::DragFloat3("Scale", glm::value_ptr(instance.Scale), 0.01f)) {
+				m_Scene.MarkInstancesChanged();
+			}
+			bool hasOverride = instance.MaterialIndex >= 0 && instance.MaterialIndex < (int)m_Scene.Materials.size();
+			if (ImGui::BeginCombo("Material", hasOverride ? m_Scene.Materials[instance.MaterialIndex].Name.c_str() : "From Prototype")) {
+				if (ImGui::Selectable("From Prototype", !hasOverride)) {
+					instance.MaterialIndex = -1;
+					m_Scene.MarkInstancesChanged();
+				}
+				for (size_t j = 0; j < m_Scene.Materials.size(); j++) {
+					bool isSelected = instance.MaterialIndex == (int)j;
+					if (ImGui::Selectable(m_Scene.Materials[j].Name.c_str(), isSelected)) {
+						instance.MaterialIndex = (int)j;
+						m_Scene.MarkInstancesChanged();
+					}
+					if (isSelected) {
+						ImGui::SetItemDefaultFocus();
+					}
+				}
+				ImGui::EndCombo();
+			}
+			if (ImGui::Button("Remove", ImGui::GetContentRegionAvail())) {
+				RemoveInstance(i);
+			}
+			ImGui::EndChild();
 
-	for (size_t i = 0; i < m_LoadedScene.Spheres.size(); i++) {
-		if (!(m_LoadedScene.Spheres[i] == m_Scene.Spheres[i])) {
-			return true;
+			ImGui::PopID();
 		}
-	}
 
-	if (m_LoadedScene.Materials.size() != m_Scene.Materials.size()) {
-		return true;
-	}
+		// Meshes
+		ImGui::Separator();
+		ImGui::AlignTextToFramePadding();
+		ImGui::Text("Meshes");
+		ImGui::SameLine();
+		Walnut::UI::ShiftCursorX(ImGui::GetColumnWidth() - 50.0f);
+		if (ImGui::Button("Add##Mesh")) {
+			AddMesh();
+		}
+		ImGui::Separator();
+
+		for (size_t i = 0; i < m_Scene.Meshes.size(); i++) {
+			ImGui::PushID(i);
+
+			ImGui::BeginChild("Mesh", ImVec2(0, 280), true);
+			Mesh& mesh = m_Scene.Meshes[i];
+			if (ImGui::Checkbox("Enabled", &mesh.Enabled)) {
+				m_Scene.MarkMeshesChanged();
+			}
+
+			// The file is only imported once the path is confirmed with enter, not on every keystroke
+			char filepath[256] = {};
+			strncpy(filepath, mesh.Filepath.c_str(), sizeof(filepath) - 1);
+			if (ImGui::InputText("File", filepath, sizeof(filepath), ImGuiInputTextFlags_EnterReturnsTrue)) {
+				mesh.Filepath = filepath;
+				mesh.Geometry = nullptr;
+				MeshImporter::ImportSceneMeshes(m_Scene);
+				m_Scene.MarkMeshesChanged();
+			}
+			if (mesh.Geometry) {
+				ImGui::Text("%u triangles, %zu vertices", mesh.Geometry->GetTriangleCount(), mesh.Geometry->Positions.size());
+			} else {
+				ImGui::TextDisabled("Not loaded (.obj or .ply)");
+			}
+
+			if (ImGui::DragFloat3("Position", glm::value_ptr(mesh.Position), 0.01f)) {
+				m_Scene.MarkMeshesChanged();
+			}
+			if (ImGui::DragFloat3("Rotation", glm::value_ptr(mesh.Rotation), 0.5f)) {
+				m_Scene.MarkMeshesChanged();
+			}
+			if (ImGui::DragFloat3("Scale", glm::value_ptr(mesh.Scale), 0.01f)) {
+				m_Scene.MarkMeshesChanged();
+			}
+			if (m_Scene.Materials.size() > 0) {
+				bool validMaterial = mesh.MaterialIndex >= 0 && mesh.MaterialIndex < (int)m_Scene.Materials.size();
+				if (ImGui::BeginCombo("Material", validMaterial ? m_Scene.Materials[mesh.MaterialIndex].Name.c_str() : "None")) {
+					for (size_t j = 0; j < m_Scene.Materials.size(); j++) {
+						bool isSelected = mesh.MaterialIndex == (int)j;
+						if (ImGui::Selectable(m_Scene.Materials[j].Name.c_str(), isSelected)) {
+							mesh.MaterialIndex = (int)j;
+							m_Scene.MarkMeshesChanged();
+						}
+						if (isSelected) {
+							ImGui::SetItemDefaultFocus();
+						}
+					}
+					ImGui::EndCombo();
+				}
+			}
+			if (ImGui::Button("Remove", ImGui::GetContentRegionAvail())) {
+				RemoveMesh(i);
+			}
+			ImGui::EndChild();
 
-	for (size_t i = 0; i < m_LoadedScene.Materials.size(); i++) {
-		if (!(m_LoadedScene.Materials[i] == m_Scene.Materials[i])) {
-			return true;
+			ImGui::PopID();
 		}
+
+		ImGui::End();
 	}
 
+	// Edits mark the scene revisions instead, the renderer resets accumulation when it sees them
 	return false;
 }
 
+bool ScenePanel::UI_DrawSphere(Sphere& sphere) {
+	bool changed = false;
+
+	if (ImGui::Checkbox("Enabled", &sphere.Enabled)) {
+		changed = true;
+	}
+	if (ImGui::DragFloat3("Position", glm::value_ptr(sphere.Position), 0.01f)) {
+		changed = true;
+	}
+	if (ImGui::DragFloat("Radius", &sphere.Radius, 0.01f)) {
+		changed = true;
+	}
+	if (m_Scene.Materials.size() > 0) {
+		if (ImGui::BeginCombo("Material", m_Scene.Materials[sphere.MaterialIndex].Name.c_str())) {
+			for (size_t j = 0; j < m_Scene.Materials.size(); j++) {
+				bool isSelected = m_Scene.Materials[sphere.MaterialIndex] == m_Scene.Materials[j];
+				if (ImGui::Selectable(m_Scene.Materials[j].Name.c_str(), isSelected)) {
+					sphere.MaterialIndex = j;
+					changed = true;
+				}
+				if (isSelected) {
+					ImGui::SetItemDefaultFocus();
+				}
+			}
+			ImGui::EndCombo();
+		}
+	}
+
+	return changed;
+}
+
 void ScenePanel::AddLight() {
 	m_Scene.Lights.emplace_back();
+	m_Scene.MarkLightsChanged();
 }
 
 void ScenePanel::AddSphere() {
 	m_Scene.Spheres.emplace_back();
+	m_Scene.MarkSpheresChanged();
 }
 
 void ScenePanel::AddMaterial() {
 	m_Scene.Materials.emplace_back();
+	m_Scene.MarkMaterialsChanged();
+}
+
+void ScenePanel::AddPrototype() {
+	m_Scene.Prototypes.emplace_back();
+	m_Scene.MarkPrototypesChanged();
+}
+
+void ScenePanel::AddInstance() {
+	m_Scene.Instances.emplace_back();
+	m_Scene.MarkInstancesChanged();
+}
+
+void ScenePanel::AddMesh() {
+	m_Scene.Meshes.emplace_back();
+	m_Scene.MarkMeshesChanged();
 }
 
 void ScenePanel::RemoveLight(size_t& index) {
 	m_Scene.Lights.erase(m_Scene.Lights.begin() + index);
+	m_Scene.MarkLightsChanged();
 }
 
 void ScenePanel::RemoveSphere(size_t& index) {
 	m_Scene.Spheres.erase(m_Scene.Spheres.begin() + index);
+	m_Scene.MarkSpheresChanged();
 }
 
 void ScenePanel::RemoveMaterial(size_t& index) {
 	m_Scene.Materials.erase(m_Scene.Materials.begin() + index);
+
+	// Instances that used the removed material go back to their prototype's, meshes to none
+	for (Instance& instance : m_Scene.Instances) {
+		if (instance.MaterialIndex == (int)index) {
+			instance.MaterialIndex = -1;
+		} else if (instance.MaterialIndex > (int)index) {
+			instance.MaterialIndex--;
+		}
+	}
+
+	for (Mesh& mesh : m_Scene.Meshes) {
+		if (mesh.MaterialIndex == (int)index) {
+			mesh.MaterialIndex = -1;
+		} else if (mesh.MaterialIndex > (int)index) {
+			mesh.MaterialIndex--;
+		}
+	}
+
+	m_Scene.MarkMaterialsChanged();
+	m_Scene.MarkInstancesChanged();
+	m_Scene.MarkMeshesChanged();
 }
+
+void ScenePanel::RemovePrototype(size_t& index) {
+	m_Scene.Prototypes.erase(m_Scene.Prototypes.begin() + index);
+
+	// Instances of the removed prototype go with it, the ones after it move down by one
+	for (size_t i = 0; i < m_Scene.Instances.size(); i++) {
+		Instance& instance = m_Scene.Instances[i];
+		if (instance.PrototypeIndex == (int)index) {
+			RemoveInstance(i);
+			i--;
+		} else if (instance.PrototypeIndex > (int)index) {
+			instance.PrototypeIndex--;
+		}
+	}
+
+	m_Scene.MarkPrototypesChanged();
+	m_Scene.MarkInstancesChanged();
+}
+
+void ScenePanel::RemoveInstance(size_t& index) {
+	m_Scene.Instances.erase(m_Scene.Instances.begin() + index);
+	m_Scene.MarkInstancesChanged();
+}
+
+void ScenePanel::RemoveMesh(size_t& index) {
+	m_Scene.Meshes.erase(m_Scene.Meshes.begin() + index);
+	m_Scene.MarkMeshesChanged();
+}
\ No newline at end of file
@@ -7,24 +7,31 @@
 
 class ScenePanel : public Panel {
 public:
-	ScenePanel(Camera& camera, Scene& scene, Scene& loadedScene, bool& showScenePanel);
+	ScenePanel(Camera& camera, Scene& scene, const uint64_t& savedSceneRevision, bool& showScenePanel);
 
 	virtual bool OnUIRender() override;
 
 	const bool& GetUnsavedChanges() const { return m_UnsavedChanges; }
 private:
-	bool CheckForChanges();
+	// Shared by the scene's spheres and the spheres of prototypes, true when the sphere was edited
+	bool UI_DrawSphere(Sphere& sphere);
 
 	void AddLight();
 	void AddSphere();
 	void AddMaterial();
+	void AddPrototype();
+	void AddInstance();
+	void AddMesh();
 
 	void RemoveLight(size_t& index);
 	void RemoveSphere(size_t& index);
 	void RemoveMaterial(size_t& index);
+	void RemovePrototype(size_t& index);
+	void RemoveInstance(size_t& index);
+	void RemoveMesh(size_t& index);
 private:
 	Scene& m_Scene;
-	Scene& m_LoadedScene;
+	const uint64_t& m_SavedSceneRevision;
 	Camera& m_Camera;
 
 	bool& m_ShowScenePanel;
@@ -2,20 +2,17 @@
 
 #include "Walnut/UI/UI.h"
 
-#include "../Renderer/Serializer/RendererSettingsSerializer.h"
+#include <filesystem>
+#include <thread>
 
-SettingsPanel::SettingsPanel(Renderer& renderer, bool& showSettingsPanel)
-	: m_Renderer(renderer), m_ShowSettingsPanel(showSettingsPanel)
-{
-	LoadRendererSettings();
-}
+SettingsPanel::SettingsPanel(Renderer::Settings& settings, bool& showSettingsPanel)
+	: m_Settings(settings), m_ShowSettingsPanel(showSettingsPanel)
+{}
 
 bool SettingsPanel::OnUIRender() {
 	bool resetFrameIndex = false;
 
 	if (m_ShowSettingsPanel) {
-		LoadRendererSettings();
-
 		ImGui::Begin("Settings", &m_ShowSettingsPanel);
 
 		ImGui::Separator();
@@ -23,30 +20,114 @@ bool SettingsPanel::OnUIRender() {
 		Walnut::UI::TextCentered("Renderer Settings");
 		ImGui::Separator();
 
-		ImGui::BeginChild("Boolean Settings", ImVec2(0, 128), true);
-		ImGui::Checkbox("Accumulate", &m_Renderer.GetSettings().Accumulate);
-		ImGui::Checkbox("Multithreading", &m_Renderer.GetSettings().Multithreading);
-		ImGui::Checkbox("Fast Random", &m_Renderer.GetSettings().FastRandom);
+		ImGui::BeginChild("Boolean Settings", ImVec2(0, 212), true);
+		ImGui::Checkbox("Accumulate", &m_Settings.Accumulate);
+		ImGui::Checkbox("Multithreading", &m_Settings.Multithreading);
+		ImGui::Checkbox("SIMD", &m_Settings.UseSIMD);
+		ImGui::Checkbox("Progressive Preview", &m_Settings.ProgressivePreview);
+		ImGui::Checkbox("Frame Time Budget", &m_Settings.FrameTimeBudget);
+		if (ImGui::Checkbox("Russian Roulette", &m_Settings.RussianRoulette)) {
+			resetFrameIndex = true;
+		}
 		ImGui::EndChild();
 
-		ImGui::BeginChild("Slider Settings", ImVec2(0, 90), true);
-		ImGui::DragInt("Ray Bounces", &m_Renderer.GetSettings().RayBounces, 1, 2, std::numeric_limits<int>::max());
-		ImGui::SliderInt("Resolution Scale", &m_Renderer.GetSettings().ResolutionScale, 1, 100, "%d%%", ImGuiSliderFlags_AlwaysClamp);
+		bool wavefront = m_Settings.IntegratorType == Renderer::Integrator::Wavefront;
+		int sliderCount = 3 + (wavefront ? 1 : 0) + (m_Settings.ProgressivePreview ? 1 : 0) + (m_Settings.FrameTimeBudget ? 1 : 0) + (m_Settings.RussianRoulette ? 1 : 0);
+		ImGui::BeginChild("Slider Settings", ImVec2(0, 34.0f + 28.0f * (float)sliderCount), true);
+		// Both integrators produce the same image, so switching keeps the accumulation
+		if (ImGui::BeginCombo("Integrator", Renderer::GetIntegratorName(m_Settings.IntegratorType))) {
+			for (Renderer::Integrator integrator : { Renderer::Integrator::PerPixel, Renderer::Integrator::Wavefront }) {
+				bool isSelected = m_Settings.IntegratorType == integrator;
+				if (ImGui::Selectable(Renderer::GetIntegratorName(integrator), isSelected)) {
+					m_Settings.IntegratorType = integrator;
+				}
+				if (isSelected) {
+					ImGui::SetItemDefaultFocus();
+				}
+			}
+			ImGui::EndCombo();
+		}
+		if (wavefront) {
+			ImGui::Checkbox("Ray Binning", &m_Settings.RayBinning);
+		}
+		ImGui::DragInt("Ray Bounces", &m_Settings.RayBounces, 1, 2, std::numeric_limits<int>::max());
+		if (m_Settings.ProgressivePreview) {
+			ImGui::SliderInt("Preview Bounces", &m_Settings.PreviewRayBounces, 1, glm::max(m_Settings.RayBounces, 1), "%d", ImGuiSliderFlags_AlwaysClamp);
+		}
+		if (m_Settings.RussianRoulette) {
+			if (ImGui::DragInt("Roulette Depth", &m_Settings.RussianRouletteDepth, 1, 1, glm::max(m_Settings.RayBounces, 1), "%d", ImGuiSliderFlags_AlwaysClamp)) {
+				resetFrameIndex = true;
+			}
+		}
+		ImGui::SliderInt("Resolution Scale", &m_Settings.ResolutionScale, 1, 100, "%d%%", ImGuiSliderFlags_AlwaysClamp);
+		if (m_Settings.FrameTimeBudget) {
+			ImGui::SliderInt("Target Frame Time", &m_Settings.TargetFrameTime, 4, 100, "%d ms", ImGuiSliderFlags_AlwaysClamp);
+		}
 		ImGui::EndChild();
 
-		if (m_Renderer.GetSettings().FastRandom) {
+		if (m_Settings.Multithreading) {
 			ImGui::Separator();
 			ImGui::AlignTextToFramePadding();
-			Walnut::UI::TextCentered("Fast Random Settings");
+			Walnut::UI::TextCentered("Multithreading Settings");
 			ImGui::Separator();
 
-			ImGui::BeginChild("Fast Random Settings", ImVec2(0, 128), true);
-			ImGui::Checkbox("Use Clock Time", &m_Renderer.GetSettings().UseClockTime);
-			ImGui::Checkbox("Use Frame Index", &m_Renderer.GetSettings().UseFrameIndex);
-			ImGui::Checkbox("Use Ray Bounces", &m_Renderer.GetSettings().UseRayBounces);
+			ImGui::BeginChild("Multithreading Settings", ImVec2(0, 90), true);
+			ImGui::SliderInt("Tile Size", &m_Settings.TileSize, 4, 128, "%d", ImGuiSliderFlags_AlwaysClamp);
+			ImGui::SliderInt("Threads", &m_Settings.ThreadCount, 0, (int)std::thread::hardware_concurrency(), m_Settings.ThreadCount == 0 ? "Auto" : "%d", ImGuiSliderFlags_AlwaysClamp);
 			ImGui::EndChild();
 		}
 
+		ImGui::Separator();
+		ImGui::AlignTextToFramePadding();
+		Walnut::UI::TextCentered("Sampler Settings");
+		ImGui::Separator();
+
+		ImGui::BeginChild("Sampler Settings", ImVec2(0, m_Settings.AdaptiveSampling ? 146 : 118), true);
+		if (ImGui::BeginCombo("Sampler", Sampler::GetTypeName(m_Settings.SamplerType))) {
+			for (Sampler::Type type : { Sampler::Type::Independent, Sampler::Type::Sobol, Sampler::Type::BlueNoise }) {
+				bool isSelected = m_Settings.SamplerType == type;
+				if (ImGui::Selectable(Sampler::GetTypeName(type), isSelected)) {
+					m_Settings.SamplerType = type;
+					resetFrameIndex = true;
+				}
+				if (isSelected) {
+					ImGui::SetItemDefaultFocus();
+				}
+			}
+			ImGui::EndCombo();
+		}
+		if (ImGui::DragInt("Seed", &m_Settings.Seed)) {
+			resetFrameIndex = true;
+		}
+		// Converged tiles keep their samples, so toggling it or moving the threshold continues the accumulation
+		ImGui::Checkbox("Adaptive Sampling", &m_Settings.AdaptiveSampling);
+		if (m_Settings.AdaptiveSampling) {
+			ImGui::DragFloat("Convergence Threshold", &m_Settings.ConvergenceThreshold, 0.0005f, 0.001f, 0.5f, "%.4f", ImGuiSliderFlags_AlwaysClamp);
+		}
+		ImGui::EndChild();
+
+		ImGui::Separator();
+		ImGui::AlignTextToFramePadding();
+		Walnut::UI::TextCentered("Output Settings");
+		ImGui::Separator();
+
+		// Only changes how the accumulated samples are displayed, so accumulation keeps going
+		ImGui::BeginChild("Output Settings", ImVec2(0, 80), true);
+		if (ImGui::BeginCombo("Tonemapper", Tonemapper::GetTypeName(m_Settings.TonemapperType))) {
+			for (Tonemapper::Type type : { Tonemapper::Type::None, Tonemapper::Type::sRGB, Tonemapper::Type::ACES }) {
+				bool isSelected = m_Settings.TonemapperType == type;
+				if (ImGui::Selectable(Tonemapper::GetTypeName(type), isSelected)) {
+					m_Settings.TonemapperType = type;
+				}
+				if (isSelected) {
+					ImGui::SetItemDefaultFocus();
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::Checkbox("Sample Heatmap", &m_Settings.SampleHeatmap);
+		ImGui::EndChild();
+
 		if (ImGui::Button("Reset Accumulation", ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
 			resetFrameIndex = true;
 		}
@@ -64,23 +145,11 @@ bool SettingsPanel::OnUIRender() {
 		ImGui::EndChild();
 
 		ImGui::End();
-
-		SaveRendererSettings();
 	}
 
 	return resetFrameIndex;
 }
 
-void SettingsPanel::LoadRendererSettings() {
-	RendererSettingsSerializer serializer(m_Renderer);
-	serializer.Deserialize("settings/Renderer.yaml");
-}
-
-void SettingsPanel::SaveRendererSettings() {
-	RendererSettingsSerializer serializer(m_Renderer);
-	serializer.Serialize("settings/Renderer.yaml");
-}
-
 void SettingsPanel::SetupLanguageSelector() {
 	for (const auto& entry : std::filesystem::directory_iterator("i18n")) {
 		if (entry.path().extension() == ".yaml") {
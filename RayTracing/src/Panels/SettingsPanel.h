@@ -8,16 +8,13 @@
 
 class SettingsPanel : public Panel {
 public:
-	SettingsPanel(Renderer& renderer, bool& showSettingsPanel);
+	SettingsPanel(Renderer::Settings& settings, bool& showSettingsPanel);
 
 	virtual bool OnUIRender() override;
 private:
-	void LoadRendererSettings();
-	void SaveRendererSettings();
-
 	void SetupLanguageSelector();
 private:
-	Renderer& m_Renderer;
+	Renderer::Settings& m_Settings;
 
 	bool& m_ShowSettingsPanel;
 
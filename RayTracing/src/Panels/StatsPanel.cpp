@@ -2,18 +2,82 @@
 
 #include "Walnut/UI/UI.h"
 
-StatsPanel::StatsPanel(Renderer& renderer, float& lastRenderTime, bool& showStatsPanel)
-	: m_Renderer(renderer), m_LastRenderTime(lastRenderTime), m_ShowStatsPanel(showStatsPanel)
+#include "../Utils/Profiler.h"
+
+#include <algorithm>
+
+StatsPanel::StatsPanel(RenderThread& renderThread, const Renderer::Settings& settings, bool& showStatsPanel)
+	: m_RenderThread(renderThread), m_Settings(settings), m_ShowStatsPanel(showStatsPanel)
 {}
 
 bool StatsPanel::OnUIRender() {
 	if (m_ShowStatsPanel) {
 		ImGui::Begin("Stats", &m_ShowStatsPanel);
 
+		// The render thread's last finished frame, the UI keeps its own frame rate
+		const RenderThread::Status& status = m_RenderThread.AcquireLatestStatus();
+		const Renderer::Stats& stats = status.Stats;
+
 		ImGui::BeginChild("Stats", ImVec2(0, 0), true);
-		ImGui::Text("Last render: %.3fms", m_LastRenderTime);
+		ImGui::Text("Last render: %.3fms", status.RenderTime);
 		ImGui::Text("FPS: %.0f", ImGui::GetIO().Framerate);
-		ImGui::Text("Accumulated frames: %i", m_Renderer.GetFrameIndex());
+		ImGui::Text("Accumulated frames: %i", status.FrameIndex);
+		ImGui::Text("Samples per pixel per second: %.2f", stats.SamplesPerPixelPerSecond);
+		if (m_Settings.AdaptiveSampling) {
+			ImGui::Text("Converged tiles: %.1f%%", stats.ConvergedTiles * 100.0f);
+		}
+		if (stats.PreviewScale > 1) {
+			ImGui::Text("Preview: 1/%u resolution", stats.PreviewScale);
+		} else {
+			ImGui::Text("Preview: off");
+		}
+
+		ImGui::Separator();
+		ImGui::Text("BVH %s: %.3fms", stats.BVHRefitted ? "refit" : "build", stats.BVHBuildTime);
+		ImGui::Text("BVH nodes: %u, SAH cost %.1f", stats.BVHNodeCount, stats.BVHCost);
+		if (stats.InstanceCount > 0) {
+			ImGui::Text("Instances: %u (%.3fms)", stats.InstanceCount, stats.InstanceBuildTime);
+		}
+		if (stats.MeshCount > 0) {
+			ImGui::Text("Meshes: %u, %llu triangles (%.3fms)", stats.MeshCount, (unsigned long long)stats.TriangleCount, stats.MeshBuildTime);
+		}
+		ImGui::Text("Nodes visited per ray: %.2f", stats.AverageNodesVisited);
+		ImGui::Text("Average path length: %.2f", stats.AveragePathLength);
+		ImGui::Text("Intersection kernel: %s", stats.IntersectionKernel);
+		ImGui::Text("Resolve: %.3fms", stats.ResolveTime);
+		if (m_Settings.IntegratorType == Renderer::Integrator::Wavefront && m_Settings.RayBinning) {
+			ImGui::Text("Ray binning: %.3fms", stats.BinningTime);
+		}
+
+		ImGui::Separator();
+		ImGui::Text("Thread utilization");
+		for (size_t i = 0; i < stats.ThreadUtilization.size(); i++) {
+			char label[32];
+			snprintf(label, sizeof(label), "Thread %zu: %.0f%%", i, stats.ThreadUtilization[i] * 100.0f);
+			ImGui::ProgressBar(stats.ThreadUtilization[i], ImVec2(-1.0f, 0.0f), label);
+		}
+
+		ImGui::Separator();
+		bool profiling = Profiler::IsEnabled();
+		if (ImGui::Checkbox("Profiling", &profiling)) {
+			Profiler::SetEnabled(profiling);
+		}
+
+		if (profiling) {
+			// Collected by the render thread, so the stages and times belong to render frames, not UI frames
+			const float* frameTimes = status.FrameTimes;
+			float maxFrameTime = *std::max_element(frameTimes, frameTimes + Profiler::s_FrameHistorySize);
+			ImGui::PlotLines("##FrameTimes", frameTimes, (int)Profiler::s_FrameHistorySize, (int)status.FrameTimeOffset,
+				"Render frame time", 0.0f, glm::max(maxFrameTime, 1.0f), ImVec2(-1.0f, 60.0f));
+
+			for (const Profiler::StageTime& stage : status.StageTimes) {
+				ImGui::Text("%s: %.3fms (%u)", stage.Name, stage.Time, stage.Calls);
+			}
+
+			if (ImGui::Button("Export Chrome Trace")) {
+				Profiler::ExportChromeTrace("export/Trace.json");
+			}
+		}
 		ImGui::EndChild();
 
 		ImGui::End();
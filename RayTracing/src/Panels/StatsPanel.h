@@ -2,17 +2,16 @@
 
 #include "Panel.h"
 
-#include "../Renderer/Renderer.h"
+#include "../Renderer/RenderThread.h"
 
 class StatsPanel : public Panel {
 public:
-	StatsPanel(Renderer& renderer, float& lastRenderTime, bool& showStatsPanel);
+	StatsPanel(RenderThread& renderThread, const Renderer::Settings& settings, bool& showStatsPanel);
 
 	virtual bool OnUIRender() override;
 private:
-	Renderer& m_Renderer;
+	RenderThread& m_RenderThread;
+	const Renderer::Settings& m_Settings;
 
 	bool& m_ShowStatsPanel;
-
-	float& m_LastRenderTime;
 };
\ No newline at end of file
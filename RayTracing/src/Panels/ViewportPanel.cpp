@@ -2,8 +2,8 @@
 
 #include "Walnut/UI/UI.h"
 
-ViewportPanel::ViewportPanel(Renderer& renderer, bool& showViewportPanel)
-	: m_Renderer(renderer), m_ShowViewportPanel(showViewportPanel)
+ViewportPanel::ViewportPanel(const Renderer::Settings& settings, std::shared_ptr<Walnut::Image>& finalImage, bool& showViewportPanel)
+	: m_Settings(settings), m_FinalImage(finalImage), m_ShowViewportPanel(showViewportPanel)
 {}
 
 bool ViewportPanel::OnUIRender() {
@@ -16,7 +16,7 @@ bool ViewportPanel::OnUIRender() {
 		m_ViewportWidth = ImGui::GetContentRegionAvail().x;
 		m_ViewportHeight = ImGui::GetContentRegionAvail().y;
 
-		auto image = m_Renderer.GetFinalImage();
+		auto image = m_FinalImage;
 		if (image) {
 			ImGui::Image(image->GetDescriptorSet(), {
 				(float)m_ViewportWidth,
@@ -26,8 +26,8 @@ bool ViewportPanel::OnUIRender() {
 				{ 1.0f, 0.0f });
 		}
 
-		m_ViewportWidth *= (float)m_Renderer.GetSettings().ResolutionScale * 0.01f;
-		m_ViewportHeight *= (float)m_Renderer.GetSettings().ResolutionScale * 0.01f;
+		m_ViewportWidth *= (float)m_Settings.ResolutionScale * 0.01f;
+		m_ViewportHeight *= (float)m_Settings.ResolutionScale * 0.01f;
 
 		ImGui::End();
 		ImGui::PopStyleVar();
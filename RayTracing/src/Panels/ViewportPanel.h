@@ -4,9 +4,13 @@
 
 #include "../Renderer/Renderer.h"
 
+#include "Walnut/Image.h"
+
+#include <memory>
+
 class ViewportPanel : public Panel {
 public:
-	ViewportPanel(Renderer& renderer, bool& showViewportPanel);
+	ViewportPanel(const Renderer::Settings& settings, std::shared_ptr<Walnut::Image>& finalImage, bool& showViewportPanel);
 
 	virtual bool OnUIRender() override;
 public:
@@ -15,7 +19,8 @@ public:
 
 	const bool& GetViewportFocused() const { return m_ViewportFocused; }
 private:
-	Renderer& m_Renderer;
+	const Renderer::Settings& m_Settings;
+	std::shared_ptr<Walnut::Image>& m_FinalImage;
 
 	uint32_t m_ViewportWidth = 0;
 	uint32_t m_ViewportHeight = 0;
@@ -2,20 +2,25 @@
 
 #include "Walnut/Application.h"
 #include "Walnut/Input/Input.h"
-#include "Walnut/Timer.h"
 #include "Walnut/Core/Log.h"
 #include "Walnut/UI/UI.h"
 
 #include "Scene/Serializer/SceneSerializer.h"
+#include "Scene/Serializer/SceneBinarySerializer.h"
+#include "Scene/Serializer/SceneStreamingDeserializer.h"
+#include "Scene/Importer/MeshImporter.h"
 
 #include "Translation/TranslationService.h"
 
+#include "Utils/Profiler.h"
+
 RayTracingLayer::RayTracingLayer() :
+	m_RendererSettingsStore(m_RendererSettings, "settings/Renderer.yaml"),
 	m_Camera(45.0f, 0.1f, 1000.0f),
-	m_StatsPanel(m_Renderer, m_LastRenderTime, m_ShowStatsPanel),
-	m_SettingsPanel(m_Renderer, m_ShowSettingsPanel),
-	m_ScenePanel(m_Camera, m_Scene, m_LoadedScene, m_ShowScenePanel),
-	m_ViewportPanel(m_Renderer, m_ShowViewportPanel),
+	m_StatsPanel(m_RenderThread, m_RendererSettings, m_ShowStatsPanel),
+	m_SettingsPanel(m_RendererSettings, m_ShowSettingsPanel),
+	m_ScenePanel(m_Camera, m_Scene, m_SavedSceneRevision, m_ShowScenePanel),
+	m_ViewportPanel(m_RendererSettings, m_FinalImage, m_ShowViewportPanel),
 	m_AboutModal(m_AboutModalOpen),
 	m_ControlsModal(m_ControlsModalOpen)
 {}
@@ -24,20 +29,33 @@ void RayTracingLayer::OnAttach() {
 	spdlog::info("RayTracingLayer - Initializing");
 	LoadDefaultScene();
 	TranslationService::Use("English");
+	m_RenderThread.Start();
 	spdlog::info("RayTracingLayer - Initialization complete");
 
 }
 
 void RayTracingLayer::OnDetach() {
 	spdlog::info("RayTracingLayer - Destroying");
+	m_RenderThread.Stop();
 }
 
 void RayTracingLayer::OnUpdate(float ts) {
+	if (m_RendererSettingsStore.OnUpdate()) {
+		ResetFrameIndex();
+	}
+
 	if (m_Camera.OnUpdate(ts, m_ViewportPanel.GetViewportFocused())) {
 		ResetFrameIndex();
+		m_TimeSinceCameraMoved = 0.0f;
+	} else {
+		m_TimeSinceCameraMoved += ts;
 	}
 
-	m_Renderer.SetTime(ts);
+	// Mouse look does not move the camera on every single frame, the short hold keeps those
+	// frames from switching to a slow full resolution render in the middle of navigating
+	m_Navigating = m_TimeSinceCameraMoved < s_NavigationHoldTime;
+
+	m_Time = ts;
 
 	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::LeftControl)) {
 		if (Walnut::Input::IsKeyDown(Walnut::KeyCode::N)) {
@@ -51,21 +69,24 @@ void RayTracingLayer::OnUpdate(float ts) {
 }
 
 void RayTracingLayer::OnUIRender() {
-	// Panels
-	m_StatsPanel.OnUIRender();
-	if (m_SettingsPanel.OnUIRender()) {
-		ResetFrameIndex();
-	}
-	if (m_ScenePanel.OnUIRender()) {
-		ResetFrameIndex();
-	}
-	m_ViewportPanel.OnUIRender();
+	{
+		RT_PROFILE_SCOPE("UI");
 
-	// Modals
-	m_AboutModal.OnUIRender();
-	m_ControlsModal.OnUIRender();
-	UI_DrawNewSceneModal();
-	UI_DrawCloseConfirmationModal();
+		// Panels
+		m_StatsPanel.OnUIRender();
+		if (m_SettingsPanel.OnUIRender()) {
+			ResetFrameIndex();
+		}
+		// Scene edits bump the scene revisions, the renderer picks those up from the next snapshot
+		m_ScenePanel.OnUIRender();
+		m_ViewportPanel.OnUIRender();
+
+		// Modals
+		m_AboutModal.OnUIRender();
+		m_ControlsModal.OnUIRender();
+		UI_DrawNewSceneModal();
+		UI_DrawCloseConfirmationModal();
+	}
 
 	// Rendering
 	Render();
@@ -148,53 +169,94 @@ void RayTracingLayer::UI_DrawCloseConfirmationModal() {
 }
 
 void RayTracingLayer::Render() {
-	Walnut::Timer timer;
+	uint32_t width = m_ViewportPanel.GetViewportWidth();
+	uint32_t height = m_ViewportPanel.GetViewportHeight();
+	m_Camera.OnResize(width, height);
 
-	m_Renderer.OnResize(m_ViewportPanel.GetViewportWidth(), m_ViewportPanel.GetViewportHeight());
-	m_Camera.OnResize(m_ViewportPanel.GetViewportWidth(), m_ViewportPanel.GetViewportHeight());
+	// Never waits for the render thread, it picks this up once its current frame is done
+	m_RenderThread.Submit(m_Scene, m_Camera, m_RendererSettings, width, height, m_Navigating, m_Time);
 
-	m_Renderer.Render(m_Scene, m_Camera);
+	UploadLatestFrame();
+}
 
-	m_LastRenderTime = timer.ElapsedMillis();
+void RayTracingLayer::UploadLatestFrame() {
+	// The render thread writes other frames meanwhile, so this one can be read without a copy
+	const OutputFrames::Frame& frame = m_RenderThread.AcquireLatestFrame();
+	if (frame.Pixels.empty() || frame.Index == m_DisplayedFrameIndex) {
+		return;
+	}
+
+	m_DisplayedFrame = &frame;
+	m_DisplayedFrameIndex = frame.Index;
+
+	if (m_FinalImage) {
+		if (m_FinalImage->GetWidth() != frame.Width || m_FinalImage->GetHeight() != frame.Height) {
+			m_FinalImage->Resize(frame.Width, frame.Height);
+		}
+	} else {
+		m_FinalImage = std::make_shared<Walnut::Image>(frame.Width, frame.Height, Walnut::ImageFormat::RGBA);
+	}
+
+	RT_PROFILE_SCOPE("Image::SetData");
+	m_FinalImage->SetData(frame.Pixels.data());
 }
 
 void RayTracingLayer::NewScene(std::string& sceneName) {
 	m_Scene = Scene();
 	m_Scene.Name = sceneName;
+	m_SceneExtension = ".yaml";
 	Walnut::Application::Get().SetWindowTitle("Ray Tracing - " + m_Scene.Name);
-	ResetFrameIndex();
 }
 
 void RayTracingLayer::SaveScene() {
-	SceneSerializer serializer(m_Scene);
-	serializer.Serialize("scenes/" + m_Scene.Name + ".yaml");
-	m_LoadedScene = m_Scene;
+	// Scenes are saved back in the format they were loaded from
+	std::filesystem::path filepath = "scenes/" + m_Scene.Name + m_SceneExtension;
+
+	if (SceneBinarySerializer::IsBinaryScene(filepath)) {
+		SceneBinarySerializer serializer(m_Scene);
+		serializer.Serialize(filepath);
+	} else {
+		SceneSerializer serializer(m_Scene);
+		serializer.Serialize(filepath);
+	}
+
+	m_SavedSceneRevision = m_Scene.GetRevision();
 }
 
-void RayTracingLayer::LoadScene(std::string& sceneName) {
-	SceneSerializer serializer(m_Scene);
-	serializer.Deserialize("scenes/" + sceneName + ".yaml");
-	m_LoadedScene = m_Scene;
+void RayTracingLayer::LoadScene(std::string& sceneFilename) {
+	std::filesystem::path filepath = "scenes/" + sceneFilename;
+
+	if (SceneBinarySerializer::IsBinaryScene(filepath)) {
+		SceneBinarySerializer serializer(m_Scene);
+		serializer.Deserialize(filepath);
+	} else {
+		SceneStreamingDeserializer deserializer(m_Scene);
+		deserializer.Deserialize(filepath);
+	}
+	MeshImporter::ImportSceneMeshes(m_Scene);
+
+	m_SceneExtension = filepath.extension().string();
+	m_SavedSceneRevision = m_Scene.GetRevision();
 	Walnut::Application::Get().SetWindowTitle("Ray Tracing - " + m_Scene.Name);
-	ResetFrameIndex();
 }
 
 void RayTracingLayer::LoadDefaultScene() {
-	SceneSerializer serializer(m_Scene);
-	serializer.Deserialize("scenes/Default.yaml");
-	m_LoadedScene = m_Scene;
+	SceneStreamingDeserializer deserializer(m_Scene);
+	deserializer.Deserialize("scenes/Default.yaml");
+	MeshImporter::ImportSceneMeshes(m_Scene);
+	m_SceneExtension = ".yaml";
+	m_SavedSceneRevision = m_Scene.GetRevision();
 	Walnut::Application::Get().SetWindowTitle("Ray Tracing - " + m_Scene.Name);
-	ResetFrameIndex();
 }
 
 std::vector<std::string> RayTracingLayer::GetAllScenes() {
 	std::vector<std::string> allScenes;
 
 	for (const auto& entry : std::filesystem::directory_iterator("scenes")) {
-		if (entry.path().extension() == ".yaml") {
-			std::string sceneName = entry.path().filename().replace_extension("").string();
-			if (sceneName != "Default") {
-				allScenes.push_back(sceneName);
+		// The extension is kept so YAML and binary scenes with the same name can be told apart
+		if (entry.path().extension() == ".yaml" || SceneBinarySerializer::IsBinaryScene(entry.path())) {
+			if (entry.path().stem() != "Default") {
+				allScenes.push_back(entry.path().filename().string());
 			}
 		}
 	}
@@ -203,11 +265,16 @@ std::vector<std::string> RayTracingLayer::GetAllScenes() {
 }
 
 void RayTracingLayer::ExportImage() {
+	// The image on screen, which may be a frame behind the renderer
+	if (!m_DisplayedFrame) {
+		return;
+	}
+
 	std::filesystem::path folderPath = "export/" + m_Scene.Name + "/";
 
 	if (!std::filesystem::exists(folderPath)) {
 		std::filesystem::create_directory(folderPath);
-		m_Renderer.GetFinalImage()->Export(m_Renderer.GetImageData(), folderPath.string() + "0.png");
+		m_FinalImage->Export(m_DisplayedFrame->Pixels.data(), folderPath.string() + "0.png");
 
 		return;
 	}
@@ -219,5 +286,5 @@ void RayTracingLayer::ExportImage() {
 		}
 	}
 
-	m_Renderer.GetFinalImage()->Export(m_Renderer.GetImageData(), folderPath.string() + std::to_string(fileCount) + ".png");
+	m_FinalImage->Export(m_DisplayedFrame->Pixels.data(), folderPath.string() + std::to_string(fileCount) + ".png");
 }
\ No newline at end of file
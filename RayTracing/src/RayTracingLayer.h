@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Walnut/Layer.h"
+#include "Walnut/Image.h"
 
-#include "Renderer/Renderer.h"
+#include "Renderer/RenderThread.h"
+#include "Renderer/Serializer/RendererSettingsStore.h"
 
 #include "Panels/StatsPanel.h"
 #include "Panels/SettingsPanel.h"
@@ -23,7 +25,7 @@ public:
 public:
 	void NewScene(std::string& sceneName);
 	void SaveScene();
-	void LoadScene(std::string& sceneName);
+	void LoadScene(std::string& sceneFilename);
 	void LoadDefaultScene();
 public:
 	std::vector<std::string> GetAllScenes();
@@ -50,12 +52,21 @@ private:
 	void UI_DrawCloseConfirmationModal();
 private:
 	void Render();
-	void ResetFrameIndex() { m_Renderer.ResetFrameIndex(); }
+	void UploadLatestFrame();
+	void ResetFrameIndex() { m_RenderThread.ResetFrameIndex(); }
 private:
-	Renderer m_Renderer;
+	RenderThread m_RenderThread;
+
+	// The UI's copy, edited by the panels and submitted to the render thread every frame
+	Renderer::Settings m_RendererSettings;
+	RendererSettingsStore m_RendererSettingsStore;
+	std::shared_ptr<Walnut::Image> m_FinalImage;
+	const OutputFrames::Frame* m_DisplayedFrame = nullptr; // What m_FinalImage holds, see Renderer::AcquireLatestFrame
+	uint64_t m_DisplayedFrameIndex = 0;
 	Camera m_Camera;
 	Scene m_Scene;
-	Scene m_LoadedScene;
+	uint64_t m_SavedSceneRevision = 0;
+	std::string m_SceneExtension = ".yaml";
 
 	StatsPanel m_StatsPanel;
 	SettingsPanel m_SettingsPanel;
@@ -65,7 +76,10 @@ private:
 	AboutModal m_AboutModal;
 	ControlsModal m_ControlsModal;
 
-	float m_LastRenderTime = 0.0f;
+	static constexpr float s_NavigationHoldTime = 0.1f; // Seconds without camera movement before leaving the preview
+	float m_TimeSinceCameraMoved = s_NavigationHoldTime;
+	bool m_Navigating = false;
+	float m_Time = 0.0f;
 
 	bool m_AboutModalOpen = false;
 	bool m_NewSceneModalOpen = false;
@@ -0,0 +1,412 @@
+#include "BVH.h"
+
+#include "Walnut/Timer.h"
+
+#include <numeric>
+#include <algorithm>
+
+namespace Utils {
+	// A single chunk without a pool, so small nodes never pay for a dispatch
+	static uint32_t GetChunkCount(uint32_t count, ThreadPool* threadPool, uint32_t chunkSize) {
+		if (!threadPool || threadPool->GetThreadCount() <= 1) {
+			return 1;
+		}
+
+		return std::clamp(count / chunkSize, 1u, threadPool->GetThreadCount() * 4);
+	}
+
+	// Calls processChunk(chunkIndex, begin, end) for contiguous ranges covering [0, count)
+	template<typename ProcessChunk>
+	static void ForEachChunk(uint32_t count, uint32_t chunkCount, ThreadPool* threadPool, ProcessChunk&& processChunk) {
+		if (chunkCount <= 1) {
+			processChunk(0, 0, count);
+			return;
+		}
+
+		threadPool->Dispatch(chunkCount, [count, chunkCount, &processChunk](uint32_t chunkIndex, uint32_t /*threadIndex*/) {
+			uint32_t begin = (uint32_t)((uint64_t)count * chunkIndex / chunkCount);
+			uint32_t end = (uint32_t)((uint64_t)count * (chunkIndex + 1) / chunkCount);
+			processChunk(chunkIndex, begin, end);
+		});
+	}
+}
+
+void BVH::Build(const std::vector<BoundingBox>& primitiveBounds, uint32_t maxLeafSize, ThreadPool* threadPool) {
+	Walnut::Timer timer;
+
+	Clear();
+
+	m_MaxLeafSize = maxLeafSize;
+
+	if (primitiveBounds.empty()) {
+		m_BuildTime = timer.ElapsedMillis();
+		return;
+	}
+
+	uint32_t primitiveCount = (uint32_t)primitiveBounds.size();
+
+	m_PrimitiveIndices.resize(primitiveCount);
+	std::iota(m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), 0);
+
+	std::vector<glm::vec3> centroids(primitiveCount);
+	uint32_t chunkCount = Utils::GetChunkCount(primitiveCount, threadPool, s_ParallelChunkSize);
+	Utils::ForEachChunk(primitiveCount, chunkCount, threadPool, [&](uint32_t /*chunkIndex*/, uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			centroids[i] = primitiveBounds[i].Centroid();
+		}
+	});
+
+	// A binary tree with N leaves never needs more than 2N - 1 nodes
+	m_Nodes.resize(primitiveCount * 2 - 1);
+
+	BVHNode& root = m_Nodes[0];
+	root.LeftFirst = 0;
+	root.PrimitiveCount = primitiveCount;
+	m_NodeCount = 1;
+
+	UpdateNodeBounds(root, primitiveBounds, threadPool);
+
+	if (threadPool && threadPool->GetThreadCount() > 1 && primitiveCount >= s_ParallelBuildThreshold) {
+		BuildParallel(primitiveBounds, centroids, *threadPool);
+	} else {
+		Subdivide(m_Nodes, m_NodeCount, 0, 0, primitiveBounds, centroids);
+	}
+
+	m_Nodes.resize(m_NodeCount);
+	m_Cost = ComputeCost();
+
+	m_BuildTime = timer.ElapsedMillis();
+}
+
+void BVH::BuildParallel(const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids, ThreadPool& threadPool) {
+	struct Subtree {
+		uint32_t NodeIndex;
+		uint32_t Depth;
+	};
+
+	uint32_t primitiveCount = m_Nodes[0].PrimitiveCount;
+	uint32_t subtreeSize = std::max(primitiveCount / (threadPool.GetThreadCount() * s_SubtreesPerThread), m_MaxLeafSize);
+
+	// The top of the tree has few nodes with many primitives each, they are split one at a time with
+	// the binning spread over the threads. Nodes small enough become subtrees, built one per task.
+	std::vector<Subtree> subtrees;
+	std::vector<Subtree> pending = { { 0, 0 } };
+	while (!pending.empty()) {
+		Subtree current = pending.back();
+		pending.pop_back();
+
+		if (m_Nodes[current.NodeIndex].PrimitiveCount <= subtreeSize) {
+			subtrees.push_back(current);
+			continue;
+		}
+
+		if (SplitNode(m_Nodes, m_NodeCount, current.NodeIndex, current.Depth, primitiveBounds, centroids, &threadPool)) {
+			uint32_t leftChildIndex = m_Nodes[current.NodeIndex].LeftFirst;
+			pending.push_back({ leftChildIndex + 1, current.Depth + 1 });
+			pending.push_back({ leftChildIndex, current.Depth + 1 });
+		}
+	}
+
+	// Subtrees own disjoint ranges of the primitive indices, so they can be partitioned concurrently
+	std::vector<std::vector<BVHNode>> subtreeNodes(subtrees.size());
+	std::vector<uint32_t> subtreeNodeCounts(subtrees.size());
+	threadPool.Dispatch((uint32_t)subtrees.size(), [&](uint32_t subtreeIndex, uint32_t /*threadIndex*/) {
+		const Subtree& subtree = subtrees[subtreeIndex];
+		std::vector<BVHNode>& nodes = subtreeNodes[subtreeIndex];
+
+		nodes.resize(m_Nodes[subtree.NodeIndex].PrimitiveCount * 2 - 1);
+		nodes[0] = m_Nodes[subtree.NodeIndex];
+
+		uint32_t nodeCount = 1;
+		Subdivide(nodes, nodeCount, 0, subtree.Depth, primitiveBounds, centroids);
+		subtreeNodeCounts[subtreeIndex] = nodeCount;
+	});
+
+	// Subtree roots keep their place, the rest of every subtree is appended in subtree order.
+	// Local node i > 0 ends up at offset + i.
+	std::vector<uint32_t> offsets(subtrees.size());
+	for (size_t i = 0; i < subtrees.size(); i++) {
+		offsets[i] = m_NodeCount - 1;
+		m_NodeCount += subtreeNodeCounts[i] - 1;
+	}
+
+	threadPool.Dispatch((uint32_t)subtrees.size(), [&](uint32_t subtreeIndex, uint32_t /*threadIndex*/) {
+		std::vector<BVHNode>& nodes = subtreeNodes[subtreeIndex];
+		uint32_t offset = offsets[subtreeIndex];
+
+		for (uint32_t i = 0; i < subtreeNodeCounts[subtreeIndex]; i++) {
+			BVHNode node = nodes[i];
+			if (!node.IsLeaf()) {
+				node.LeftFirst += offset;
+			}
+
+			m_Nodes[i == 0 ? subtrees[subtreeIndex].NodeIndex : offset + i] = node;
+		}
+
+		nodes = std::vector<BVHNode>();
+	});
+}
+
+void BVH::Refit(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool) {
+	Walnut::Timer timer;
+
+	if (m_Nodes.empty()) {
+		m_RefitTime = timer.ElapsedMillis();
+		return;
+	}
+
+	// Leaves only depend on their primitives
+	uint32_t chunkCount = Utils::GetChunkCount(m_NodeCount, threadPool, s_ParallelChunkSize);
+	Utils::ForEachChunk(m_NodeCount, chunkCount, threadPool, [&](uint32_t /*chunkIndex*/, uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (m_Nodes[i].IsLeaf()) {
+				UpdateNodeBounds(m_Nodes[i], primitiveBounds, nullptr);
+			}
+		}
+	});
+
+	// Children always come after their parent, so walking backwards reaches them first
+	for (uint32_t i = m_NodeCount; i-- > 0;) {
+		BVHNode& node = m_Nodes[i];
+		if (node.IsLeaf()) {
+			continue;
+		}
+
+		node.Bounds = m_Nodes[node.LeftFirst].Bounds;
+		node.Bounds.Grow(m_Nodes[node.LeftFirst + 1].Bounds);
+	}
+
+	m_Cost = ComputeCost();
+
+	m_RefitTime = timer.ElapsedMillis();
+}
+
+void BVH::Clear() {
+	m_Nodes.clear();
+	m_PrimitiveIndices.clear();
+	m_NodeCount = 0;
+	m_Cost = 0.0f;
+}
+
+void BVH::UpdateNodeBounds(BVHNode& node, const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool) {
+	auto growBounds = [&](uint32_t begin, uint32_t end, BoundingBox& bounds) {
+		for (uint32_t i = begin; i < end; i++) {
+			bounds.Grow(primitiveBounds[m_PrimitiveIndices[node.LeftFirst + i]]);
+		}
+	};
+
+	node.Bounds = BoundingBox();
+
+	uint32_t chunkCount = Utils::GetChunkCount(node.PrimitiveCount, threadPool, s_ParallelChunkSize);
+	if (chunkCount == 1) {
+		growBounds(0, node.PrimitiveCount, node.Bounds);
+		return;
+	}
+
+	std::vector<BoundingBox> chunkBounds(chunkCount);
+	Utils::ForEachChunk(node.PrimitiveCount, chunkCount, threadPool, [&](uint32_t chunkIndex, uint32_t begin, uint32_t end) {
+		growBounds(begin, end, chunkBounds[chunkIndex]);
+	});
+
+	for (const BoundingBox& bounds : chunkBounds) {
+		node.Bounds.Grow(bounds);
+	}
+}
+
+void BVH::Subdivide(std::vector<BVHNode>& nodes, uint32_t& nodeCount, uint32_t nodeIndex, uint32_t depth, const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids) {
+	if (!SplitNode(nodes, nodeCount, nodeIndex, depth, primitiveBounds, centroids, nullptr)) {
+		return;
+	}
+
+	uint32_t leftChildIndex = nodes[nodeIndex].LeftFirst;
+	Subdivide(nodes, nodeCount, leftChildIndex, depth + 1, primitiveBounds, centroids);
+	Subdivide(nodes, nodeCount, leftChildIndex + 1, depth + 1, primitiveBounds, centroids);
+}
+
+bool BVH::SplitNode(std::vector<BVHNode>& nodes, uint32_t& nodeCount, uint32_t nodeIndex, uint32_t depth, const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids, ThreadPool* threadPool) {
+	BVHNode& node = nodes[nodeIndex];
+
+	if (node.PrimitiveCount <= m_MaxLeafSize || depth >= s_MaxDepth - 1) {
+		return false;
+	}
+
+	int axis = -1;
+	float splitPosition = 0.0f;
+	float splitCost = FindBestSplit(node, primitiveBounds, centroids, threadPool, axis, splitPosition);
+
+	// Only split when the SAH says it is cheaper than intersecting every primitive of this leaf
+	float leafCost = node.PrimitiveCount * node.Bounds.SurfaceArea();
+	if (axis < 0 || splitCost >= leafCost) {
+		return false;
+	}
+
+	// Partition the primitive indices in place around the split plane
+	int i = node.LeftFirst;
+	int j = i + node.PrimitiveCount - 1;
+	while (i <= j) {
+		if (centroids[m_PrimitiveIndices[i]][axis] < splitPosition) {
+			i++;
+		} else {
+			std::swap(m_PrimitiveIndices[i], m_PrimitiveIndices[j--]);
+		}
+	}
+
+	uint32_t leftCount = i - node.LeftFirst;
+	if (leftCount == 0 || leftCount == node.PrimitiveCount) {
+		return false;
+	}
+
+	uint32_t leftChildIndex = nodeCount++;
+	uint32_t rightChildIndex = nodeCount++;
+
+	BVHNode& leftChild = nodes[leftChildIndex];
+	leftChild.LeftFirst = node.LeftFirst;
+	leftChild.PrimitiveCount = leftCount;
+
+	BVHNode& rightChild = nodes[rightChildIndex];
+	rightChild.LeftFirst = i;
+	rightChild.PrimitiveCount = node.PrimitiveCount - leftCount;
+
+	node.LeftFirst = leftChildIndex;
+	node.PrimitiveCount = 0;
+
+	UpdateNodeBounds(leftChild, primitiveBounds, threadPool);
+	UpdateNodeBounds(rightChild, primitiveBounds, threadPool);
+
+	return true;
+}
+
+float BVH::FindBestSplit(const BVHNode& node, const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids, ThreadPool* threadPool, int& axis, float& splitPosition) {
+	struct Bin {
+		BoundingBox Bounds;
+		uint32_t PrimitiveCount = 0;
+	};
+
+	struct AxisBins {
+		Bin Bins[3][s_BinCount];
+	};
+
+	// Bins only take minimums, maximums and counts, so splitting the primitives into chunks
+	// gives exactly the same bins as a single pass
+	uint32_t chunkCount = Utils::GetChunkCount(node.PrimitiveCount, threadPool, s_ParallelChunkSize);
+
+	auto growCentroidBounds = [&](uint32_t begin, uint32_t end, BoundingBox& bounds) {
+		for (uint32_t i = begin; i < end; i++) {
+			bounds.Grow(centroids[m_PrimitiveIndices[node.LeftFirst + i]]);
+		}
+	};
+
+	BoundingBox centroidBounds;
+	if (chunkCount == 1) {
+		growCentroidBounds(0, node.PrimitiveCount, centroidBounds);
+	} else {
+		std::vector<BoundingBox> chunkBounds(chunkCount);
+		Utils::ForEachChunk(node.PrimitiveCount, chunkCount, threadPool, [&](uint32_t chunkIndex, uint32_t begin, uint32_t end) {
+			growCentroidBounds(begin, end, chunkBounds[chunkIndex]);
+		});
+
+		for (const BoundingBox& bounds : chunkBounds) {
+			centroidBounds.Grow(bounds);
+		}
+	}
+
+	bool splittable[3];
+	float scale[3];
+	for (int a = 0; a < 3; a++) {
+		splittable[a] = centroidBounds.Min[a] != centroidBounds.Max[a];
+		scale[a] = splittable[a] ? s_BinCount / (centroidBounds.Max[a] - centroidBounds.Min[a]) : 0.0f;
+	}
+
+	auto fillBins = [&](uint32_t begin, uint32_t end, AxisBins& bins) {
+		for (uint32_t i = begin; i < end; i++) {
+			uint32_t primitiveIndex = m_PrimitiveIndices[node.LeftFirst + i];
+
+			for (int a = 0; a < 3; a++) {
+				if (!splittable[a]) {
+					continue;
+				}
+
+				int binIndex = glm::min(s_BinCount - 1, (int)((centroids[primitiveIndex][a] - centroidBounds.Min[a]) * scale[a]));
+				bins.Bins[a][binIndex].PrimitiveCount++;
+				bins.Bins[a][binIndex].Bounds.Grow(primitiveBounds[primitiveIndex]);
+			}
+		}
+	};
+
+	AxisBins axisBins;
+	if (chunkCount == 1) {
+		fillBins(0, node.PrimitiveCount, axisBins);
+	} else {
+		std::vector<AxisBins> chunkBins(chunkCount);
+		Utils::ForEachChunk(node.PrimitiveCount, chunkCount, threadPool, [&](uint32_t chunkIndex, uint32_t begin, uint32_t end) {
+			fillBins(begin, end, chunkBins[chunkIndex]);
+		});
+
+		for (const AxisBins& bins : chunkBins) {
+			for (int a = 0; a < 3; a++) {
+				for (int i = 0; i < s_BinCount; i++) {
+					axisBins.Bins[a][i].PrimitiveCount += bins.Bins[a][i].PrimitiveCount;
+					axisBins.Bins[a][i].Bounds.Grow(bins.Bins[a][i].Bounds);
+				}
+			}
+		}
+	}
+
+	float bestCost = std::numeric_limits<float>::max();
+
+	for (int a = 0; a < 3; a++) {
+		if (!splittable[a]) {
+			continue;
+		}
+
+		const Bin* bins = axisBins.Bins[a];
+
+		// Sweep from both sides to get the area and count on either side of every bin boundary
+		float leftArea[s_BinCount - 1], rightArea[s_BinCount - 1];
+		uint32_t leftCount[s_BinCount - 1], rightCount[s_BinCount - 1];
+
+		BoundingBox leftBounds, rightBounds;
+		uint32_t leftSum = 0, rightSum = 0;
+
+		for (int i = 0; i < s_BinCount - 1; i++) {
+			leftSum += bins[i].PrimitiveCount;
+			leftCount[i] = leftSum;
+			leftBounds.Grow(bins[i].Bounds);
+			leftArea[i] = leftSum > 0 ? leftBounds.SurfaceArea() : 0.0f;
+
+			rightSum += bins[s_BinCount - 1 - i].PrimitiveCount;
+			rightCount[s_BinCount - 2 - i] = rightSum;
+			rightBounds.Grow(bins[s_BinCount - 1 - i].Bounds);
+			rightArea[s_BinCount - 2 - i] = rightSum > 0 ? rightBounds.SurfaceArea() : 0.0f;
+		}
+
+		float binWidth = (centroidBounds.Max[a] - centroidBounds.Min[a]) / s_BinCount;
+		for (int i = 0; i < s_BinCount - 1; i++) {
+			float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+			if (cost < bestCost) {
+				axis = a;
+				splitPosition = centroidBounds.Min[a] + binWidth * (i + 1);
+				bestCost = cost;
+			}
+		}
+	}
+
+	return bestCost;
+}
+
+float BVH::ComputeCost() const {
+	float rootArea = m_Nodes[0].Bounds.SurfaceArea();
+	if (rootArea <= 0.0f) {
+		return 0.0f;
+	}
+
+	// Interior nodes cost one box test and leaves one test per primitive, weighted by the chance
+	// that a ray hitting the root also hits the node
+	double cost = 0.0;
+	for (uint32_t i = 0; i < m_NodeCount; i++) {
+		const BVHNode& node = m_Nodes[i];
+		cost += (double)node.Bounds.SurfaceArea() * (node.IsLeaf() ? node.PrimitiveCount : 1);
+	}
+
+	return (float)(cost / rootArea);
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "Ray.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <limits>
+#include <utility>
+#include <cstdint>
+
+struct BoundingBox {
+	glm::vec3 Min{ std::numeric_limits<float>::max() };
+	glm::vec3 Max{ -std::numeric_limits<float>::max() };
+
+	void Grow(const glm::vec3& point) {
+		Min = glm::min(Min, point);
+		Max = glm::max(Max, point);
+	}
+
+	void Grow(const BoundingBox& other) {
+		Min = glm::min(Min, other.Min);
+		Max = glm::max(Max, other.Max);
+	}
+
+	glm::vec3 Centroid() const { return (Min + Max) * 0.5f; }
+
+	float SurfaceArea() const {
+		glm::vec3 extent = Max - Min;
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+};
+
+struct BVHNode {
+	BoundingBox Bounds;
+
+	// Interior nodes: index of the left child (the right child is LeftFirst + 1)
+	// Leaf nodes: index of the first primitive in the primitive index list
+	uint32_t LeftFirst = 0;
+	uint32_t PrimitiveCount = 0;
+
+	bool IsLeaf() const { return PrimitiveCount > 0; }
+};
+
+class BVH {
+public:
+	BVH() = default;
+
+	// With a thread pool, large builds split the top of the tree with parallel binning and then build
+	// the subtrees below it as independent tasks. The tree is the same as a single threaded build,
+	// only the order of the nodes differs.
+	void Build(const std::vector<BoundingBox>& primitiveBounds, uint32_t maxLeafSize = 4, ThreadPool* threadPool = nullptr);
+
+	// Recomputes the node bounds for primitives that moved or changed size, keeping the tree as it is.
+	// The primitives must be the same as in the last build. The tree gets worse the further they
+	// move, GetCost tells when a rebuild is due.
+	void Refit(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool = nullptr);
+	void Clear();
+
+	bool IsEmpty() const { return m_Nodes.empty(); }
+
+	// Calls intersectLeaf(firstPrimitive, primitiveCount) for every leaf the ray reaches
+	// before hitDistance. The callback is expected to shrink hitDistance when it finds a closer hit.
+	template<typename IntersectLeaf>
+	void Traverse(const Ray& ray, float& hitDistance, uint32_t& nodesVisited, IntersectLeaf&& intersectLeaf) const;
+
+	const std::vector<BVHNode>& GetNodes() const { return m_Nodes; }
+	const std::vector<uint32_t>& GetPrimitiveIndices() const { return m_PrimitiveIndices; }
+
+	uint32_t GetNodeCount() const { return m_NodeCount; }
+	float GetBuildTime() const { return m_BuildTime; }
+	float GetRefitTime() const { return m_RefitTime; }
+
+	// Expected cost of a random ray with the SAH, relative to the surface area of the root
+	float GetCost() const { return m_Cost; }
+private:
+	void BuildParallel(const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids, ThreadPool& threadPool);
+
+	// Nodes are passed in so subtrees can be built into their own list, child indices are relative to it
+	void UpdateNodeBounds(BVHNode& node, const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool);
+	void Subdivide(std::vector<BVHNode>& nodes, uint32_t& nodeCount, uint32_t nodeIndex, uint32_t depth, const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids);
+	bool SplitNode(std::vector<BVHNode>& nodes, uint32_t& nodeCount, uint32_t nodeIndex, uint32_t depth, const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids, ThreadPool* threadPool);
+	float FindBestSplit(const BVHNode& node, const std::vector<BoundingBox>& primitiveBounds, const std::vector<glm::vec3>& centroids, ThreadPool* threadPool, int& axis, float& splitPosition);
+
+	float ComputeCost() const;
+
+	static float IntersectBounds(const Ray& ray, const glm::vec3& inverseDirection, const BoundingBox& bounds, float hitDistance);
+private:
+	static constexpr int s_BinCount = 16;
+	static constexpr int s_MaxDepth = 64;
+
+	static constexpr uint32_t s_ParallelBuildThreshold = 1 << 14; // Primitives, smaller builds are not worth the tasks
+	static constexpr uint32_t s_SubtreesPerThread = 8;             // So work stealing can even out unbalanced splits
+	static constexpr uint32_t s_ParallelChunkSize = 1 << 13;       // Primitives per task when binning one node in parallel
+
+	std::vector<BVHNode> m_Nodes;
+	std::vector<uint32_t> m_PrimitiveIndices;
+
+	uint32_t m_NodeCount = 0;
+	uint32_t m_MaxLeafSize = 4;
+
+	float m_BuildTime = 0.0f;
+	float m_RefitTime = 0.0f;
+	float m_Cost = 0.0f;
+};
+
+inline float BVH::IntersectBounds(const Ray& ray, const glm::vec3& inverseDirection, const BoundingBox& bounds, float hitDistance) {
+	// Slab test, returns the entry distance or max float on a miss
+	glm::vec3 t0 = (bounds.Min - ray.Origin) * inverseDirection;
+	glm::vec3 t1 = (bounds.Max - ray.Origin) * inverseDirection;
+
+	glm::vec3 tSmall = glm::min(t0, t1);
+	glm::vec3 tBig = glm::max(t0, t1);
+
+	float tMin = glm::max(glm::max(tSmall.x, tSmall.y), tSmall.z);
+	float tMax = glm::min(glm::min(tBig.x, tBig.y), tBig.z);
+
+	if (tMax >= tMin && tMax > 0.0f && tMin < hitDistance) {
+		return tMin;
+	}
+
+	return std::numeric_limits<float>::max();
+}
+
+template<typename IntersectLeaf>
+void BVH::Traverse(const Ray& ray, float& hitDistance, uint32_t& nodesVisited, IntersectLeaf&& intersectLeaf) const {
+	if (m_Nodes.empty()) {
+		return;
+	}
+
+	glm::vec3 inverseDirection = 1.0f / ray.Direction;
+
+	const BVHNode* stack[s_MaxDepth];
+	uint32_t stackSize = 0;
+
+	const BVHNode* node = &m_Nodes[0];
+	nodesVisited++;
+
+	if (IntersectBounds(ray, inverseDirection, node->Bounds, hitDistance) == std::numeric_limits<float>::max()) {
+		return;
+	}
+
+	while (true) {
+		if (node->IsLeaf()) {
+			intersectLeaf(node->LeftFirst, node->PrimitiveCount);
+
+			if (stackSize == 0) {
+				break;
+			}
+
+			node = stack[--stackSize];
+			continue;
+		}
+
+		// Visit the nearest child first, and postpone the other one
+		const BVHNode* child0 = &m_Nodes[node->LeftFirst];
+		const BVHNode* child1 = &m_Nodes[node->LeftFirst + 1];
+		nodesVisited += 2;
+
+		float distance0 = IntersectBounds(ray, inverseDirection, child0->Bounds, hitDistance);
+		float distance1 = IntersectBounds(ray, inverseDirection, child1->Bounds, hitDistance);
+
+		if (distance0 > distance1) {
+			std::swap(distance0, distance1);
+			std::swap(child0, child1);
+		}
+
+		if (distance0 == std::numeric_limits<float>::max()) {
+			if (stackSize == 0) {
+				break;
+			}
+
+			node = stack[--stackSize];
+			continue;
+		}
+
+		node = child0;
+
+		if (distance1 != std::numeric_limits<float>::max()) {
+			stack[stackSize++] = child1;
+		}
+	}
+}
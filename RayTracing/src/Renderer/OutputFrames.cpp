@@ -0,0 +1,23 @@
+#include "OutputFrames.h"
+
+OutputFrames::Frame& OutputFrames::BeginWrite(uint32_t width, uint32_t height) {
+	Frame& frame = m_Frames.GetWriteBuffer();
+
+	if (frame.Width != width || frame.Height != height) {
+		frame.Pixels.assign((size_t)width * height, 0);
+		frame.Width = width;
+		frame.Height = height;
+	}
+
+	return frame;
+}
+
+void OutputFrames::Publish() {
+	m_Frames.GetWriteBuffer().Index = ++m_PublishedCount;
+	m_Frames.Publish();
+}
+
+const OutputFrames::Frame& OutputFrames::AcquireLatest() {
+	m_Frames.AcquireLatest();
+	return m_Frames.GetReadBuffer();
+}
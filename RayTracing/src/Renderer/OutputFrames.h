@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../Utils/TripleBuffer.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// RGBA8 frames handed from the renderer to whoever displays them, through a TripleBuffer. The renderer
+// writes one frame while the last finished one is displayed or uploaded.
+class OutputFrames {
+public:
+	struct Frame {
+		std::vector<uint32_t> Pixels;
+		uint32_t Width = 0, Height = 0;
+		uint64_t Index = 0; // Counts published frames, 0 if this one never was
+	};
+public:
+	OutputFrames() = default;
+
+	// Writer side. The write frame is resized (and cleared) only when its size differs.
+	Frame& BeginWrite(uint32_t width, uint32_t height);
+	void Publish();
+
+	// The frame the writer published last, it stays intact while the writer fills the next one
+	const Frame& GetPublishedFrame() const { return m_Frames.GetPublishedBuffer(); }
+
+	// Reader side. The returned frame stays valid and unchanged until the next call.
+	const Frame& AcquireLatest();
+private:
+	TripleBuffer<Frame> m_Frames;
+	uint64_t m_PublishedCount = 0;
+};
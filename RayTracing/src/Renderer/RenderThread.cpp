@@ -0,0 +1,132 @@
+#include "RenderThread.h"
+
+#include "Walnut/Timer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace Utils {
+	static void CopyChangedParts(const Scene& source, Scene& target) {
+		// Snapshots are reused, so most of the time only what was just edited differs
+		if (target.Revisions.Sky != source.Revisions.Sky) {
+			target.Sky = source.Sky;
+		}
+		if (target.Revisions.Lights != source.Revisions.Lights) {
+			target.Lights = source.Lights;
+		}
+		if (target.Revisions.Spheres != source.Revisions.Spheres) {
+			target.Spheres = source.Spheres;
+		}
+		if (target.Revisions.Materials != source.Revisions.Materials) {
+			target.Materials = source.Materials;
+		}
+		if (target.Revisions.Prototypes != source.Revisions.Prototypes) {
+			target.Prototypes = source.Prototypes;
+		}
+		if (target.Revisions.Instances != source.Revisions.Instances) {
+			target.Instances = source.Instances;
+		}
+		if (target.Revisions.Meshes != source.Revisions.Meshes) {
+			target.Meshes = source.Meshes;
+		}
+
+		target.Name = source.Name;
+		target.Revisions = source.Revisions;
+	}
+}
+
+RenderThread::~RenderThread() {
+	Stop();
+}
+
+void RenderThread::Start() {
+	if (m_Running) {
+		return;
+	}
+
+	m_Running = true;
+	m_Thread = std::thread(&RenderThread::Run, this);
+}
+
+void RenderThread::Stop() {
+	if (!m_Running) {
+		return;
+	}
+
+	// The current frame is finished first
+	m_Running = false;
+	m_Thread.join();
+}
+
+void RenderThread::Submit(const Scene& scene, const Camera& camera, const Renderer::Settings& settings, uint32_t width, uint32_t height, bool navigating, float time) {
+	Snapshot& snapshot = m_Snapshots.GetWriteBuffer();
+
+	Utils::CopyChangedParts(scene, snapshot.Scene);
+	snapshot.Camera = camera;
+	snapshot.Settings = settings;
+	snapshot.Width = width;
+	snapshot.Height = height;
+	snapshot.Navigating = navigating;
+	snapshot.Time = time;
+	snapshot.ResetCount = m_ResetCount;
+
+	m_Snapshots.Publish();
+}
+
+const RenderThread::Status& RenderThread::AcquireLatestStatus() {
+	m_Statuses.AcquireLatest();
+	return m_Statuses.GetReadBuffer();
+}
+
+void RenderThread::Run() {
+	spdlog::info("RenderThread - Started");
+
+	const Snapshot* snapshot = nullptr;
+	uint64_t resetCount = 0;
+	float renderTime = 0.0f;
+
+	while (m_Running.load(std::memory_order_relaxed)) {
+		// The snapshot stays the same for a whole Render call, edits take effect at the next one
+		if (m_Snapshots.AcquireLatest()) {
+			snapshot = &m_Snapshots.GetReadBuffer();
+
+			m_Renderer.GetSettings() = snapshot->Settings;
+			m_Renderer.OnResize(snapshot->Width, snapshot->Height);
+			m_Renderer.SetNavigating(snapshot->Navigating);
+			m_Renderer.SetTime(snapshot->Time);
+
+			if (snapshot->ResetCount != resetCount) {
+				resetCount = snapshot->ResetCount;
+				m_Renderer.ResetFrameIndex();
+			}
+		}
+
+		// Nothing to render into until the viewport has a size
+		if (!snapshot || snapshot->Width == 0 || snapshot->Height == 0) {
+			std::this_thread::sleep_for(s_IdleTime);
+			continue;
+		}
+
+		Walnut::Timer timer;
+
+		m_Renderer.SetFrameTime(renderTime);
+		m_Renderer.Render(snapshot->Scene, snapshot->Camera);
+
+		renderTime = timer.ElapsedMillis();
+
+		// A frame here is a Render call, the UI may draw any number of frames meanwhile
+		Profiler::NewFrame();
+
+		Status& status = m_Statuses.GetWriteBuffer();
+		status.Stats = m_Renderer.GetStats();
+		status.FrameIndex = m_Renderer.GetFrameIndex();
+		status.RenderTime = renderTime;
+		status.StageTimes = Profiler::GetStageTimes();
+		std::copy_n(Profiler::GetFrameTimes(), Profiler::s_FrameHistorySize, status.FrameTimes);
+		status.FrameTimeOffset = Profiler::GetFrameTimeOffset();
+		m_Statuses.Publish();
+	}
+
+	spdlog::info("RenderThread - Stopped");
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Renderer.h"
+
+#include "../Scene/Scene.h"
+#include "../Scene/Camera.h"
+#include "../Utils/TripleBuffer.h"
+#include "../Utils/Profiler.h"
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// Runs a Renderer on its own thread, so a slow frame never holds up the UI. The UI thread submits a
+// snapshot of the scene, camera and settings every frame, and the render thread picks up the latest one
+// between two Render calls, which is the next sample boundary. Snapshots, finished frames and stats are
+// all handed over through lock-free triple buffers, neither thread ever waits for the other.
+class RenderThread {
+public:
+	struct Status {
+		Renderer::Stats Stats;
+		int FrameIndex = 0;
+		float RenderTime = 0.0f; // Milliseconds, the last Render call
+
+		// The profiler's breakdown of the last frame, empty while profiling is off, and the render frame time history
+		std::vector<Profiler::StageTime> StageTimes;
+		float FrameTimes[Profiler::s_FrameHistorySize] = {};
+		uint32_t FrameTimeOffset = 0;
+	};
+public:
+	RenderThread() = default;
+	~RenderThread();
+
+	void Start();
+	void Stop();
+
+	// UI thread. Only the parts of the scene whose revision changed since the snapshot was last used are copied.
+	void Submit(const Scene& scene, const Camera& camera, const Renderer::Settings& settings, uint32_t width, uint32_t height, bool navigating, float time);
+
+	// Applied together with the next Submit
+	void ResetFrameIndex() { m_ResetCount++; }
+
+	// UI thread. Both stay valid and unchanged until the next call.
+	const OutputFrames::Frame& AcquireLatestFrame() { return m_Renderer.AcquireLatestFrame(); }
+	const Status& AcquireLatestStatus();
+private:
+	struct Snapshot {
+		::Scene Scene;
+		::Camera Camera{ 45.0f, 0.1f, 1000.0f };
+		Renderer::Settings Settings;
+		uint32_t Width = 0, Height = 0;
+		bool Navigating = false;
+		float Time = 0.0f;
+		uint64_t ResetCount = 0;
+	};
+
+	void Run();
+private:
+	static constexpr std::chrono::milliseconds s_IdleTime{ 1 }; // Between checks for a snapshot with something to render
+
+	Renderer m_Renderer; // Render thread only, apart from the output frames
+
+	TripleBuffer<Snapshot> m_Snapshots;
+	TripleBuffer<Status> m_Statuses;
+
+	uint64_t m_ResetCount = 0; // UI thread only
+
+	std::thread m_Thread;
+	std::atomic<bool> m_Running = false;
+};
@@ -1,248 +1,1148 @@
 #include "Renderer.h"
+#include "Sampler.h"
 
-#include "Walnut/Random.h"
+#include "../Utils/Profiler.h"
 
-#include <execution>
-#include <time.h>
+#include "Walnut/Timer.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
 
 namespace Utils {
-	static uint32_t ConvertToRGBA(const glm::vec4& color) {
-		uint8_t r = (uint8_t)(color.r * 255.0f);
-		uint8_t g = (uint8_t)(color.g * 255.0f);
-		uint8_t b = (uint8_t)(color.b * 255.0f);
-		uint8_t a = (uint8_t)(color.a * 255.0f);
+	// Cosine-weighted direction in the hemisphere around normal, pdf = cos(theta) / pi
+	static glm::vec3 CosineSampleHemisphere(const glm::vec3& normal, const glm::vec2& u) {
+		float r = glm::sqrt(u.x);
+		float phi = 2.0f * glm::pi<float>() * u.y;
+
+		float localX = r * glm::cos(phi);
+		float localY = r * glm::sin(phi);
+		float localZ = glm::sqrt(glm::max(0.0f, 1.0f - u.x));
 
-		return (a << 24) | (b << 16) | (g << 8) | r;
+		// Branchless orthonormal basis (Duff et al. 2017)
+		float sign = std::copysign(1.0f, normal.z);
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+		glm::vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+		return tangent * localX + bitangent * localY + normal * localZ;
 	}
 
-	static uint32_t PCH_Hash(uint32_t input) {
-		uint32_t state = input * 747796405u + 2891336453u;
-		uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
-		return (word >> 22u) ^ word;
+	// Spreads the low 10 bits of value so two zero bits follow each of them, for 3D Morton codes
+	static uint32_t ExpandBits(uint32_t value) {
+		value = (value * 0x00010001u) & 0xFF0000FFu;
+		value = (value * 0x00000101u) & 0x0F00F00Fu;
+		value = (value * 0x00000011u) & 0xC30C30C3u;
+		value = (value * 0x00000005u) & 0x49249249u;
+		return value;
 	}
 
-	static float RandomFloat(uint32_t& seed) {
-		seed = PCH_Hash(seed);
-		return (float)seed / (float)std::numeric_limits<uint32_t>::max();
+	// Bounds of the enabled spheres, and which sphere each of them belongs to
+	static void GetSphereBounds(const std::vector<Sphere>& spheres, std::vector<BoundingBox>& sphereBounds, std::vector<uint32_t>& enabledSpheres) {
+		sphereBounds.clear();
+		enabledSpheres.clear();
+		sphereBounds.reserve(spheres.size());
+		enabledSpheres.reserve(spheres.size());
+
+		for (size_t i = 0; i < spheres.size(); i++) {
+			const Sphere& sphere = spheres[i];
+
+			if (!sphere.Enabled) {
+				continue;
+			}
+
+			BoundingBox& bounds = sphereBounds.emplace_back();
+			bounds.Min = sphere.Position - glm::vec3(glm::abs(sphere.Radius));
+			bounds.Max = sphere.Position + glm::vec3(glm::abs(sphere.Radius));
+
+			enabledSpheres.push_back((uint32_t)i);
+		}
 	}
 
-	static glm::vec3 RandomInUnitSphere(uint32_t& seed) {
-		return glm::normalize(glm::vec3(
-			RandomFloat(seed) * 2.0f - 1.0f,
-			RandomFloat(seed) * 2.0f - 1.0f,
-			RandomFloat(seed) * 2.0f - 1.0f
-		));
+	static void GetTriangleBounds(const MeshGeometry& geometry, std::vector<BoundingBox>& triangleBounds) {
+		triangleBounds.resize(geometry.GetTriangleCount());
+
+		for (size_t i = 0; i < triangleBounds.size(); i++) {
+			BoundingBox& bounds = triangleBounds[i];
+			bounds = BoundingBox();
+			for (size_t corner = 0; corner < 3; corner++) {
+				bounds.Grow(geometry.Positions[geometry.Indices[i * 3 + corner]]);
+			}
+		}
 	}
-}
 
-void Renderer::OnResize(uint32_t width, uint32_t height) {
-	if (m_FinalImage) {
-		// No resize necessary
-		if (m_FinalImage->GetWidth() == width && m_FinalImage->GetHeight() == height) {
-			return;
+	static BoundingBox TransformBounds(const BoundingBox& bounds, const glm::mat4& transform) {
+		BoundingBox result;
+		for (int corner = 0; corner < 8; corner++) {
+			glm::vec3 point(
+				corner & 1 ? bounds.Max.x : bounds.Min.x,
+				corner & 2 ? bounds.Max.y : bounds.Min.y,
+				corner & 4 ? bounds.Max.z : bounds.Min.z
+			);
+			result.Grow(glm::vec3(transform * glm::vec4(point, 1.0f)));
 		}
 
-		m_FinalImage->Resize(width, height);
-	} else {
-		m_FinalImage = std::make_shared<Walnut::Image>(width, height, Walnut::ImageFormat::RGBA);
+		return result;
 	}
 
-	delete[] m_ImageData;
-	m_ImageData = new uint32_t[width * height];
-	
-	delete[] m_AccumulationData;
-	m_AccumulationData = new glm::vec4[width * height];
+	static float Luminance(const glm::vec3& color) {
+		return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+	}
 
-	m_ImageHorizontalIterator.resize(width);
-	m_ImageVerticalIterator.resize(height);
+	// Blue for the fewest samples through green and yellow to red for the most, t in [0, 1]
+	static uint32_t HeatmapColor(float t) {
+		glm::vec3 color;
+		if (t < 0.5f) {
+			color = glm::mix(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), t * 2.0f);
+		} else {
+			color = glm::mix(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t * 2.0f - 1.0f);
+		}
 
-	for (uint32_t i = 0; i < width; i++) {
-		m_ImageHorizontalIterator[i] = i;
+		uint32_t r = (uint32_t)(color.r * 255.0f);
+		uint32_t g = (uint32_t)(color.g * 255.0f);
+		uint32_t b = (uint32_t)(color.b * 255.0f);
+		return 0xff000000 | (b << 16) | (g << 8) | r;
 	}
+}
 
-	for (uint32_t i = 0; i < height; i++) {
-		m_ImageVerticalIterator[i] = i;
+void Renderer::OnResize(uint32_t width, uint32_t height) {
+	// No resize necessary
+	if (m_AccumulationData && m_Width == width && m_Height == height) {
+		return;
 	}
 
+	m_Width = width;
+	m_Height = height;
+
+	delete[] m_AccumulationData;
+	m_AccumulationData = new glm::vec3[width * height];
+
+	delete[] m_LuminanceSquaredData;
+	m_LuminanceSquaredData = new float[width * height];
+
 	ResetFrameIndex();
 }
 
 void Renderer::Render(const Scene& scene, const Camera& camera) {
+	RT_PROFILE_SCOPE("Renderer::Render");
+	Walnut::Timer timer;
+
 	m_ActiveScene = &scene;
 	m_ActiveCamera = &camera;
 
-	if (m_FrameIndex == 1) {
-		memset(m_AccumulationData, 0, m_FinalImage->GetWidth() * m_FinalImage->GetHeight() * sizeof(glm::vec4));
+	m_Stats.BinningTime = 0.0f;
+
+	// Before the acceleration structures, their builds use the pool as well
+	m_ThreadPool.Resize(m_Settings.Multithreading ? (uint32_t)m_Settings.ThreadCount : 1);
+	m_ThreadCounters.assign(m_ThreadPool.GetThreadCount(), RayCounters());
+
+	// Revisions are unique across all scenes, so switching to another scene is caught here as well
+	bool spheresChanged = scene.Revisions.Spheres != m_SphereRevision;
+	if (spheresChanged) {
+		UpdateAccelerationStructure();
 	}
 
-	if (m_Settings.Multithreading) {
-		std::for_each(std::execution::par, m_ImageVerticalIterator.begin(), m_ImageVerticalIterator.end(), [this](uint32_t y) {
-			std::for_each(std::execution::par, m_ImageHorizontalIterator.begin(), m_ImageHorizontalIterator.end(), [this, y](uint32_t x) {
-				Accumulate(x, y);
-			});
-		});
+	// Moving instances around only rebuilds the BVH over the instances, the prototype BVHs stay as they are
+	bool prototypesChanged = scene.Revisions.Prototypes != m_PrototypeRevision;
+	bool instancesChanged = prototypesChanged || scene.Revisions.Instances != m_InstanceRevision;
+	if (instancesChanged) {
+		Walnut::Timer instanceTimer;
+
+		if (prototypesChanged) {
+			UpdatePrototypeStructures();
+		}
+		UpdateInstanceStructure();
+
+		m_Stats.InstanceBuildTime = instanceTimer.ElapsedMillis();
+	}
+
+	bool meshesChanged = scene.Revisions.Meshes != m_MeshRevision;
+	if (meshesChanged) {
+		Walnut::Timer meshTimer;
+		UpdateMeshStructures();
+		m_Stats.MeshBuildTime = meshTimer.ElapsedMillis();
+	}
+
+	if (spheresChanged || instancesChanged || meshesChanged) {
+		UpdateSceneBounds();
+	}
+
+	if (scene.GetRevision() != m_SceneRevision) {
+		m_SceneRevision = scene.GetRevision();
+		ResetFrameIndex();
+	}
+
+	m_SphereIntersector.SetUseSIMD(m_Settings.UseSIMD);
+	for (PrototypeAccelerationStructure& prototype : m_PrototypeStructures) {
+		prototype.Intersector.SetUseSIMD(m_Settings.UseSIMD);
+	}
+	m_Stats.IntersectionKernel = SphereIntersector::GetKernelName(m_SphereIntersector.GetKernel());
+
+	m_ImageData = m_OutputFrames.BeginWrite(m_Width, m_Height).Pixels.data();
+
+	m_TileSize = (uint32_t)glm::max(m_Settings.TileSize, 1);
+	m_TileCountX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_TileCountY = (m_Height + m_TileSize - 1) / m_TileSize;
+
+	// A different tile size or image size changes what the per tile sample counts refer to
+	if (m_TileSampleCounts.size() != (size_t)m_TileCountX * m_TileCountY) {
+		ResetFrameIndex();
+	}
+
+	// Covers every dispatch of the frame's tracing, in wavefront mode or with several passes the last one is tiny
+	m_ThreadPool.ResetUtilization();
+
+	bool preview = m_Navigating && m_Settings.ProgressivePreview;
+	if (preview) {
+		RenderPreview();
+	} else {
+		if (m_ResetAccumulation) {
+			memset(m_AccumulationData, 0, m_Width * m_Height * sizeof(glm::vec3));
+			memset(m_LuminanceSquaredData, 0, m_Width * m_Height * sizeof(float));
+			m_TileSampleCounts.assign((size_t)m_TileCountX * m_TileCountY, 0);
+			m_TileErrors.assign((size_t)m_TileCountX * m_TileCountY, std::numeric_limits<float>::max());
+			m_ResetAccumulation = false;
+		}
+
+		TraceTiles();
+	}
+
+	m_Stats.PreviewScale = preview ? m_PreviewScale : 1;
+
+	RayCounters totalCounters;
+	for (const RayCounters& counters : m_ThreadCounters) {
+		totalCounters.NodesVisited += counters.NodesVisited;
+		totalCounters.RaysTraced += counters.RaysTraced;
+		totalCounters.SamplesTraced += counters.SamplesTraced;
+	}
+
+	m_Stats.RaysTraced = totalCounters.RaysTraced;
+
+	if (totalCounters.RaysTraced > 0) {
+		m_Stats.AverageNodesVisited = (float)totalCounters.NodesVisited / (float)totalCounters.RaysTraced;
+	}
+
+	if (totalCounters.SamplesTraced > 0) {
+		m_Stats.AveragePathLength = (float)totalCounters.RaysTraced / (float)totalCounters.SamplesTraced;
+	}
+
+	m_Stats.ThreadUtilization = m_ThreadPool.GetThreadUtilization();
+
+	if (preview) {
+		UpsamplePreview();
+
+		// Previews are never accumulated, the first frame after navigation starts from a cleared buffer
+		ResetFrameIndex();
 	} else {
-		for (uint32_t y = 0; y < m_FinalImage->GetHeight(); y++) {
-			for (uint32_t x = 0; x < m_FinalImage->GetWidth(); x++) {
-				Accumulate(x, y);
+		Resolve();
+
+		// Without accumulation every pass starts over, with a budget a pass can span several frames
+		if (!m_Settings.Accumulate && m_FrameIndex > 1) {
+			ResetFrameIndex();
+		}
+	}
+
+	// The frame written before this one stays untouched while it is being displayed
+	m_OutputFrames.Publish();
+
+	float seconds = timer.Elapsed();
+	if (seconds > 0.0f && m_Width * m_Height > 0) {
+		m_Stats.SamplesPerPixelPerSecond = (float)totalCounters.SamplesTraced / ((float)m_Width * (float)m_Height * seconds);
+	}
+}
+
+void Renderer::TraceTiles() {
+	if (m_TileSampleCounts.empty()) {
+		return;
+	}
+
+	RT_PROFILE_SCOPE("Renderer::TraceTiles");
+
+	Walnut::Timer timer;
+
+	// Whatever the last frame spent outside of tracing (resolve, upload) is assumed to stay the same
+	bool budgeted = m_Settings.FrameTimeBudget;
+	float overhead = glm::max(m_FrameTime - m_TraceTime, 0.0f);
+	float budget = glm::max((float)m_Settings.TargetFrameTime - overhead, s_MinTraceBudget);
+
+	// The variance estimate needs the samples of several frames
+	bool adaptive = m_Settings.AdaptiveSampling && m_Settings.Accumulate;
+	uint32_t tileCount = (uint32_t)m_TileSampleCounts.size();
+	uint32_t tracedTiles = 0;
+
+	while (true) {
+		// Tiles behind the rest get their next sample first, so a pass left unfinished by the last frame is completed before a new one starts
+		uint32_t passSamples = GetPassSamples(adaptive);
+		if (passSamples == std::numeric_limits<uint32_t>::max()) {
+			break; // Every tile converged
+		}
+
+		m_PendingTiles.clear();
+		for (uint32_t i = 0; i < tileCount; i++) {
+			if (m_TileSampleCounts[i] == passSamples && !(adaptive && IsTileConverged(i))) {
+				m_PendingTiles.push_back(i);
+			}
+		}
+
+		if (m_Settings.IntegratorType == Integrator::Wavefront) {
+			// The budget is checked between waves, a wave always runs to completion
+			uint32_t tilesPerWave = glm::max(s_WavefrontWaveSize / (m_TileSize * m_TileSize), 1u);
+			for (uint32_t first = 0; first < (uint32_t)m_PendingTiles.size(); first += tilesPerWave) {
+				if (budgeted && timer.ElapsedMillis() > budget) {
+					break;
+				}
+
+				RenderWave(m_PendingTiles.data() + first, glm::min(tilesPerWave, (uint32_t)m_PendingTiles.size() - first));
 			}
+		} else {
+			m_ThreadPool.Dispatch((uint32_t)m_PendingTiles.size(), [this, &timer, budgeted, budget](uint32_t index, uint32_t threadIndex) {
+				if (budgeted && timer.ElapsedMillis() > budget) {
+					return;
+				}
+
+				RenderTile(m_PendingTiles[index], threadIndex);
+			});
+		}
+
+		tracedTiles += (uint32_t)m_PendingTiles.size();
+
+		// Without a budget, the tiles adaptive sampling skips are traded for more samples in the noisy ones,
+		// so a frame still traces about as many tiles as a full pass
+		bool keepTracing = budgeted ? m_Settings.Accumulate && timer.ElapsedMillis() < budget : adaptive && tracedTiles < tileCount;
+		if (!keepTracing) {
+			break;
+		}
+	}
+
+	m_TraceTime = timer.ElapsedMillis();
+
+	// The frame index counts the passes every tile still being sampled has completed, plus one
+	uint32_t passSamples = GetPassSamples(adaptive);
+	if (passSamples == std::numeric_limits<uint32_t>::max()) {
+		passSamples = *std::max_element(m_TileSampleCounts.begin(), m_TileSampleCounts.end());
+	}
+	m_FrameIndex = passSamples + 1;
+
+	uint32_t convergedTiles = 0;
+	for (uint32_t i = 0; i < tileCount; i++) {
+		convergedTiles += adaptive && IsTileConverged(i) ? 1 : 0;
+	}
+	m_Stats.ConvergedTiles = (float)convergedTiles / (float)tileCount;
+}
+
+uint32_t Renderer::GetPassSamples(bool adaptive) const {
+	uint32_t passSamples = std::numeric_limits<uint32_t>::max();
+	for (uint32_t i = 0; i < (uint32_t)m_TileSampleCounts.size(); i++) {
+		if (!(adaptive && IsTileConverged(i))) {
+			passSamples = glm::min(passSamples, m_TileSampleCounts[i]);
 		}
 	}
 
-	m_FinalImage->SetData(m_ImageData);
+	return passSamples;
+}
+
+bool Renderer::IsTileConverged(uint32_t tileIndex) const {
+	// The threshold is only compared here, so changing it applies to the current accumulation right away
+	return m_TileSampleCounts[tileIndex] >= s_MinAdaptiveSamples && m_TileErrors[tileIndex] < m_Settings.ConvergenceThreshold;
+}
 
-	if (m_Settings.Accumulate) {
-		m_FrameIndex++;
+const char* Renderer::GetIntegratorName(Integrator integrator) {
+	switch (integrator) {
+		case Integrator::PerPixel:
+			return "PerPixel";
+		case Integrator::Wavefront:
+			return "Wavefront";
+	}
+
+	return "Unknown";
+}
+
+bool Renderer::TryParseIntegrator(const std::string& name, Integrator& integrator) {
+	for (Integrator candidate : { Integrator::PerPixel, Integrator::Wavefront }) {
+		if (name == GetIntegratorName(candidate)) {
+			integrator = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Renderer::SetNavigating(bool navigating) {
+	if (navigating && !m_Navigating) {
+		m_NextPreviewScale = s_MaxPreviewScale;
+	}
+
+	m_Navigating = navigating;
+}
+
+void Renderer::UpdateAccelerationStructure() {
+	RT_PROFILE_SCOPE("Renderer::UpdateAccelerationStructure");
+
+	std::vector<BoundingBox> sphereBounds;
+	std::vector<uint32_t> enabledSpheres;
+	Utils::GetSphereBounds(m_ActiveScene->Spheres, sphereBounds, enabledSpheres);
+
+	// Moving spheres or changing their radius keeps the tree and only refits the bounds, until the
+	// tree got too much worse than it was when it was built. Enabling, disabling, adding or removing
+	// spheres changes the primitives and always rebuilds.
+	bool refit = !m_SphereBVH.IsEmpty() && enabledSpheres == m_EnabledSpheres;
+	if (refit) {
+		m_SphereBVH.Refit(sphereBounds, &m_ThreadPool);
+		refit = m_SphereBVH.GetCost() <= m_SphereBVHBuildCost * s_MaxRefitCostRatio;
+	}
+
+	if (refit) {
+		m_Stats.BVHBuildTime = m_SphereBVH.GetRefitTime();
 	} else {
-		ResetFrameIndex();
+		// The leaf size only depends on the CPU, so toggling SIMD off never changes the tree
+		m_SphereBVH.Build(sphereBounds, SphereIntersector::GetKernelWidth(SphereIntersector::GetBestKernel()), &m_ThreadPool);
+		m_SphereBVHBuildCost = m_SphereBVH.GetCost();
+		m_EnabledSpheres = std::move(enabledSpheres);
+
+		const std::vector<uint32_t>& primitiveIndices = m_SphereBVH.GetPrimitiveIndices();
+		m_BVHSphereIndices.resize(primitiveIndices.size());
+		for (size_t i = 0; i < primitiveIndices.size(); i++) {
+			m_BVHSphereIndices[i] = m_EnabledSpheres[primitiveIndices[i]];
+		}
+
+		m_Stats.BVHBuildTime = m_SphereBVH.GetBuildTime();
 	}
+
+	// The intersector copies the sphere data, so it is rebuilt either way
+	m_SphereIntersector.Build(m_SphereBVH, m_ActiveScene->Spheres, m_BVHSphereIndices);
+
+	m_Stats.BVHRefitted = refit;
+	m_Stats.BVHNodeCount = m_SphereBVH.GetNodeCount();
+	m_Stats.BVHCost = m_SphereBVH.GetCost();
+
+	m_SphereRevision = m_ActiveScene->Revisions.Spheres;
 }
 
-void Renderer::Accumulate(const uint32_t& x, const uint32_t& y) {
-	glm::vec4 color = RayGen(x, y);
-	m_AccumulationData[x + y * m_FinalImage->GetWidth()] += color;
+void Renderer::UpdatePrototypeStructures() {
+	RT_PROFILE_SCOPE("Renderer::UpdatePrototypeStructures");
 
-	glm::vec4 accumulatedColor = m_AccumulationData[x + y * m_FinalImage->GetWidth()];
-	accumulatedColor /= (float)m_FrameIndex;
+	const std::vector<Prototype>& prototypes = m_ActiveScene->Prototypes;
+	m_PrototypeStructures.resize(prototypes.size());
+
+	std::vector<BoundingBox> sphereBounds;
+	std::vector<uint32_t> enabledSpheres;
+
+	for (size_t i = 0; i < prototypes.size(); i++) {
+		PrototypeAccelerationStructure& structure = m_PrototypeStructures[i];
+		Utils::GetSphereBounds(prototypes[i].Spheres, sphereBounds, enabledSpheres);
+
+		structure.SphereBVH.Build(sphereBounds, SphereIntersector::GetKernelWidth(SphereIntersector::GetBestKernel()), &m_ThreadPool);
+
+		// The intersector reports indices into the prototype's spheres
+		std::vector<uint32_t> sphereIndices(structure.SphereBVH.GetPrimitiveIndices().size());
+		for (size_t j = 0; j < sphereIndices.size(); j++) {
+			sphereIndices[j] = enabledSpheres[structure.SphereBVH.GetPrimitiveIndices()[j]];
+		}
 
-	accumulatedColor = glm::clamp(accumulatedColor, glm::vec4(0.0f), glm::vec4(1.0f));
-	m_ImageData[x + y * m_FinalImage->GetWidth()] = Utils::ConvertToRGBA(accumulatedColor);
+		structure.Intersector.Build(structure.SphereBVH, prototypes[i].Spheres, sphereIndices);
+	}
+
+	m_PrototypeRevision = m_ActiveScene->Revisions.Prototypes;
 }
 
-glm::vec4 Renderer::RayGen(uint32_t x, uint32_t y) {
-	Ray ray;
-	ray.Origin = m_ActiveCamera->GetPosition();
-	ray.Direction = m_ActiveCamera->GetRayDirections()[x + y * m_FinalImage->GetWidth()];
+void Renderer::UpdateInstanceStructure() {
+	RT_PROFILE_SCOPE("Renderer::UpdateInstanceStructure");
+
+	std::vector<InstanceData> instances;
+	std::vector<BoundingBox> instanceBounds;
+	instances.reserve(m_ActiveScene->Instances.size());
+	instanceBounds.reserve(m_ActiveScene->Instances.size());
+
+	for (const Instance& instance : m_ActiveScene->Instances) {
+		if (!instance.Enabled || instance.PrototypeIndex < 0 || instance.PrototypeIndex >= (int)m_PrototypeStructures.size()) {
+			continue;
+		}
 
-	glm::vec3 light(0.0f);
-	glm::vec3 contribution(1.0f);
+		const BVH& prototypeBVH = m_PrototypeStructures[instance.PrototypeIndex].SphereBVH;
+		if (prototypeBVH.IsEmpty()) {
+			continue;
+		}
 
-	uint32_t seed = x + y * m_FinalImage->GetWidth();
+		InstanceData& data = instances.emplace_back();
+		data.InstanceToWorld = instance.GetTransform();
+		data.WorldToInstance = glm::inverse(data.InstanceToWorld);
+		data.NormalToWorld = glm::transpose(glm::mat3(data.WorldToInstance));
+		data.PrototypeIndex = (uint32_t)instance.PrototypeIndex;
+		data.MaterialIndex = instance.MaterialIndex;
 
-	if (m_Settings.UseFrameIndex) {
-		seed *= m_FrameIndex;
+		instanceBounds.push_back(Utils::TransformBounds(prototypeBVH.GetNodes()[0].Bounds, data.InstanceToWorld));
 	}
 
-	if (m_Settings.UseClockTime) {
-		seed *= clock();
+	// Instances are expensive to test, so leaves hold a single one
+	m_InstanceBVH.Build(instanceBounds, 1, &m_ThreadPool);
+
+	const std::vector<uint32_t>& primitiveIndices = m_InstanceBVH.GetPrimitiveIndices();
+	m_Instances.resize(primitiveIndices.size());
+	for (size_t i = 0; i < primitiveIndices.size(); i++) {
+		m_Instances[i] = instances[primitiveIndices[i]];
 	}
 
-	for (int i = 0; i < m_Settings.RayBounces; i++) {
-		if (m_Settings.UseRayBounces) {
-			seed += i;
+	m_Stats.InstanceCount = (uint32_t)m_Instances.size();
+
+	m_InstanceRevision = m_ActiveScene->Revisions.Instances;
+}
+
+void Renderer::UpdateMeshStructures() {
+	RT_PROFILE_SCOPE("Renderer::UpdateMeshStructures");
+
+	// Structures of geometry that is still in use are kept, so moving a mesh or changing its material
+	// only rebuilds the BVH over the meshes
+	std::vector<MeshAccelerationStructure> structures;
+	std::vector<MeshData> meshes;
+	std::vector<BoundingBox> meshBounds;
+	std::vector<BoundingBox> triangleBounds;
+
+	m_Stats.TriangleCount = 0;
+
+	for (const Mesh& mesh : m_ActiveScene->Meshes) {
+		if (!mesh.Enabled || !mesh.Geometry) {
+			continue;
 		}
 
-		Renderer::HitPayload payload = TraceRay(ray);
+		auto usesGeometry = [&mesh](const MeshAccelerationStructure& structure) { return structure.Geometry == mesh.Geometry; };
 
-		if (payload.HitDistance < 0.0f) {
-			if (m_ActiveScene->Sky.Enabled) {
-				light += m_ActiveScene->Sky.Color * contribution;
+		auto it = std::find_if(structures.begin(), structures.end(), usesGeometry);
+		if (it == structures.end()) {
+			auto previous = std::find_if(m_MeshStructures.begin(), m_MeshStructures.end(), usesGeometry);
+			if (previous != m_MeshStructures.end()) {
+				structures.push_back(std::move(*previous));
+			} else {
+				MeshAccelerationStructure& structure = structures.emplace_back();
+				structure.Geometry = mesh.Geometry;
+
+				Utils::GetTriangleBounds(*mesh.Geometry, triangleBounds);
+				structure.TriangleBVH.Build(triangleBounds, s_TriangleLeafSize, &m_ThreadPool);
+				structure.Intersector.Build(structure.TriangleBVH, *mesh.Geometry);
 			}
-			break;
+			it = structures.end() - 1;
 		}
 
-		const Sphere& sphere = m_ActiveScene->Spheres[payload.ObjectIndex];
+		glm::mat4 meshToWorld = mesh.GetTransform();
 
-		float lightIntensity = 1.0f;
+		MeshData& data = meshes.emplace_back();
+		data.WorldToMesh = glm::inverse(meshToWorld);
+		data.NormalToWorld = glm::transpose(glm::mat3(data.WorldToMesh));
+		data.Position = mesh.Position;
+		data.StructureIndex = (uint32_t)(it - structures.begin());
+		data.MaterialIndex = mesh.MaterialIndex;
 
-		if (m_ActiveScene->Lights.size() > 0) {
-			for (auto& light : m_ActiveScene->Lights) {
-				if (!light.Enabled) {
-					continue;
-				}
+		meshBounds.push_back(Utils::TransformBounds(it->TriangleBVH.GetNodes()[0].Bounds, meshToWorld));
+		m_Stats.TriangleCount += mesh.Geometry->GetTriangleCount();
+	}
+
+	m_MeshStructures = std::move(structures);
+
+	// Like instances, every mesh gets its own leaf
+	m_MeshBVH.Build(meshBounds, 1, &m_ThreadPool);
+
+	const std::vector<uint32_t>& primitiveIndices = m_MeshBVH.GetPrimitiveIndices();
+	m_Meshes.resize(primitiveIndices.size());
+	for (size_t i = 0; i < primitiveIndices.size(); i++) {
+		m_Meshes[i] = meshes[primitiveIndices[i]];
+	}
+
+	m_Stats.MeshCount = (uint32_t)m_Meshes.size();
+
+	m_MeshRevision = m_ActiveScene->Revisions.Meshes;
+}
+
+void Renderer::UpdateSceneBounds() {
+	m_SceneBounds = BoundingBox();
+
+	if (!m_SphereBVH.IsEmpty()) {
+		m_SceneBounds.Grow(m_SphereBVH.GetNodes()[0].Bounds);
+	}
+
+	if (!m_InstanceBVH.IsEmpty()) {
+		m_SceneBounds.Grow(m_InstanceBVH.GetNodes()[0].Bounds);
+	}
+
+	if (!m_MeshBVH.IsEmpty()) {
+		m_SceneBounds.Grow(m_MeshBVH.GetNodes()[0].Bounds);
+	}
+}
+
+void Renderer::RenderTile(uint32_t tileIndex, uint32_t threadIndex) {
+	RT_PROFILE_SCOPE("Renderer::RenderTile");
+
+	uint32_t minX = (tileIndex % m_TileCountX) * m_TileSize;
+	uint32_t minY = (tileIndex / m_TileCountX) * m_TileSize;
+	uint32_t maxX = glm::min(minX + m_TileSize, m_Width);
+	uint32_t maxY = glm::min(minY + m_TileSize, m_Height);
+
+	RayCounters counters;
+	uint32_t sampleIndex = m_TileSampleCounts[tileIndex] + 1;
+
+	for (uint32_t y = minY; y < maxY; y++) {
+		for (uint32_t x = minX; x < maxX; x++) {
+			Accumulate(x, y, sampleIndex, counters);
+		}
+	}
+
+	m_TileSampleCounts[tileIndex] = sampleIndex;
+	m_TileErrors[tileIndex] = GetTileError(minX, minY, maxX, maxY, sampleIndex);
+
+	m_ThreadCounters[threadIndex].NodesVisited += counters.NodesVisited;
+	m_ThreadCounters[threadIndex].RaysTraced += counters.RaysTraced;
+	m_ThreadCounters[threadIndex].SamplesTraced += counters.SamplesTraced;
+}
+
+void Renderer::Accumulate(const uint32_t& x, const uint32_t& y, const uint32_t& sampleIndex, RayCounters& counters) {
+	glm::vec3 color = RayGen(x, y, sampleIndex, counters);
+	float luminance = Utils::Luminance(color);
+
+	m_AccumulationData[x + y * m_Width] += color;
+	m_LuminanceSquaredData[x + y * m_Width] += luminance * luminance;
+	counters.SamplesTraced++;
+}
+
+void Renderer::AccumulatePath(const PathState& path) {
+	float luminance = Utils::Luminance(path.Light);
+
+	m_AccumulationData[path.PixelIndex] += path.Light;
+	m_LuminanceSquaredData[path.PixelIndex] += luminance * luminance;
+}
+
+void Renderer::RenderWave(const uint32_t* tiles, uint32_t tileCount) {
+	RT_PROFILE_SCOPE("Renderer::RenderWave");
+
+	m_WaveTileOffsets.resize(tileCount + 1);
+	m_WaveTileOffsets[0] = 0;
+	for (uint32_t i = 0; i < tileCount; i++) {
+		uint32_t minX = (tiles[i] % m_TileCountX) * m_TileSize;
+		uint32_t minY = (tiles[i] / m_TileCountX) * m_TileSize;
+		uint32_t pixelCount = (glm::min(minX + m_TileSize, m_Width) - minX) * (glm::min(minY + m_TileSize, m_Height) - minY);
+		m_WaveTileOffsets[i + 1] = m_WaveTileOffsets[i] + pixelCount;
+	}
+
+	uint32_t pathCount = m_WaveTileOffsets[tileCount];
+	m_WavePaths.resize(pathCount);
+	m_WaveNextPaths.resize(pathCount);
+	m_WaveHits.resize(pathCount);
+
+	// Primary rays
+	m_ThreadPool.Dispatch(tileCount, [this, tiles](uint32_t index, uint32_t threadIndex) {
+		uint32_t tileIndex = tiles[index];
+		uint32_t minX = (tileIndex % m_TileCountX) * m_TileSize;
+		uint32_t minY = (tileIndex / m_TileCountX) * m_TileSize;
+		uint32_t maxX = glm::min(minX + m_TileSize, m_Width);
+		uint32_t maxY = glm::min(minY + m_TileSize, m_Height);
+		uint32_t sampleIndex = m_TileSampleCounts[tileIndex] + 1;
 
-				glm::vec3 lightDirection = glm::normalize(sphere.Position - light.Position);
-				lightIntensity += glm::max(glm::dot(payload.WorldNormal, -lightDirection), 0.0f); // == cos(angle)
+		PathState* path = m_WavePaths.data() + m_WaveTileOffsets[index];
+		for (uint32_t y = minY; y < maxY; y++) {
+			for (uint32_t x = minX; x < maxX; x++) {
+				*path++ = CreatePath(x, y, sampleIndex);
 			}
 		}
 
-		if (m_ActiveScene->Materials.size() > 0) {
-			const Material& material = m_ActiveScene->Materials[sphere.MaterialIndex];
-			contribution *= material.Albedo * lightIntensity;
-			light += material.GetEmission();
+		m_ThreadCounters[threadIndex].SamplesTraced += (maxX - minX) * (maxY - minY);
+	});
+
+	int bounces = m_Settings.RayBounces;
+	uint32_t activeCount = bounces > 0 ? pathCount : 0;
+
+	// Primary rays of a tile are coherent already
+	bool binning = false;
+
+	while (activeCount > 0) {
+		uint32_t chunkCount = (activeCount + s_WavefrontChunkSize - 1) / s_WavefrontChunkSize;
+
+		if (binning) {
+			BinWave(activeCount);
 		}
 
-		ray.Origin = payload.WorldPosition + payload.WorldNormal * 0.0001f;
+		// Intersect the whole queue, hits are stored by path so the order rays are traced in does not matter
+		m_ThreadPool.Dispatch(chunkCount, [this, activeCount, binning](uint32_t chunkIndex, uint32_t threadIndex) {
+			uint32_t first = chunkIndex * s_WavefrontChunkSize;
+			uint32_t last = glm::min(first + s_WavefrontChunkSize, activeCount);
 
-		if (m_Settings.FastRandom) {
-			ray.Direction = glm::normalize(payload.WorldNormal + Utils::RandomInUnitSphere(seed));
-		} else {
-			ray.Direction = glm::normalize(payload.WorldNormal + Walnut::Random::InUnitSphere());
+			RayCounters counters;
+			for (uint32_t j = first; j < last; j++) {
+				uint32_t i = binning ? m_WaveOrder[j] : j;
+				m_WaveHits[i] = TraceRay(m_WavePaths[i].PathRay, counters);
+			}
+
+			m_ThreadCounters[threadIndex].NodesVisited += counters.NodesVisited;
+			m_ThreadCounters[threadIndex].RaysTraced += counters.RaysTraced;
+		});
+
+		// Shade, finished paths go into the accumulation buffer and the survivors move to the front of their chunk.
+		// Every pixel has exactly one path in a wave, so no two jobs write the same pixel.
+		m_WaveChunkSurvivors.resize(chunkCount);
+		m_ThreadPool.Dispatch(chunkCount, [this, activeCount, bounces](uint32_t chunkIndex, uint32_t /*threadIndex*/) {
+			uint32_t first = chunkIndex * s_WavefrontChunkSize;
+			uint32_t last = glm::min(first + s_WavefrontChunkSize, activeCount);
+
+			uint32_t survivors = 0;
+			for (uint32_t i = first; i < last; i++) {
+				PathState& path = m_WavePaths[i];
+
+				if (Shade(m_WaveHits[i], path, bounces) && path.Depth < bounces) {
+					m_WavePaths[first + survivors++] = path;
+				} else {
+					AccumulatePath(path);
+				}
+			}
+
+			m_WaveChunkSurvivors[chunkIndex] = survivors;
+		});
+
+		// Compact the survivors of all chunks into the next queue
+		uint32_t survivorCount = 0;
+		for (uint32_t& survivors : m_WaveChunkSurvivors) {
+			uint32_t count = survivors;
+			survivors = survivorCount; // Now the chunk's offset in the next queue
+			survivorCount += count;
+		}
+
+		m_ThreadPool.Dispatch(chunkCount, [this, activeCount, survivorCount, chunkCount](uint32_t chunkIndex, uint32_t /*threadIndex*/) {
+			uint32_t offset = m_WaveChunkSurvivors[chunkIndex];
+			uint32_t count = (chunkIndex + 1 < chunkCount ? m_WaveChunkSurvivors[chunkIndex + 1] : survivorCount) - offset;
+
+			const PathState* source = m_WavePaths.data() + chunkIndex * s_WavefrontChunkSize;
+			std::copy(source, source + count, m_WaveNextPaths.data() + offset);
+		});
+
+		std::swap(m_WavePaths, m_WaveNextPaths);
+		activeCount = survivorCount;
+		binning = m_Settings.RayBinning && m_SceneBounds.IsValid();
+	}
+
+	m_ThreadPool.Dispatch(tileCount, [this, tiles](uint32_t index, uint32_t /*threadIndex*/) {
+		uint32_t tileIndex = tiles[index];
+		uint32_t minX = (tileIndex % m_TileCountX) * m_TileSize;
+		uint32_t minY = (tileIndex / m_TileCountX) * m_TileSize;
+		uint32_t maxX = glm::min(minX + m_TileSize, m_Width);
+		uint32_t maxY = glm::min(minY + m_TileSize, m_Height);
+
+		uint32_t sampleIndex = ++m_TileSampleCounts[tileIndex];
+		m_TileErrors[tileIndex] = GetTileError(minX, minY, maxX, maxY, sampleIndex);
+	});
+}
+
+float Renderer::GetTileError(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY, uint32_t sampleCount) const {
+	// Largest relative standard error of the mean luminance in the tile. Dark pixels are measured against
+	// s_MinErrorLuminance, otherwise barely visible noise in them would keep the tile from converging.
+	float inverseCount = 1.0f / (float)sampleCount;
+	float error = 0.0f;
+
+	for (uint32_t y = minY; y < maxY; y++) {
+		for (uint32_t x = minX; x < maxX; x++) {
+			float mean = Utils::Luminance(m_AccumulationData[x + y * m_Width]) * inverseCount;
+			float meanSquared = m_LuminanceSquaredData[x + y * m_Width] * inverseCount;
+			float variance = glm::max(meanSquared - mean * mean, 0.0f);
+
+			float standardError = glm::sqrt(variance * inverseCount);
+			error = glm::max(error, standardError / glm::max(mean, s_MinErrorLuminance));
 		}
 	}
 
-	return { light, 1.0f };
+	return error;
 }
 
-Renderer::HitPayload Renderer::TraceRay(const Ray& ray) {
-	// (bx^2 + by^2)t^2 + (2(axbx + ayby))t + (ax^2 + ay^2 - r^2) = 0
-	// where
-	// a = ray origin
-	// b = ray direction
-	// r = radius
-	// t = hit distance
+void Renderer::Resolve() {
+	RT_PROFILE_SCOPE("Renderer::Resolve");
+	Walnut::Timer timer;
 
-	int closestSphere = -1;
-	float hitDistance = std::numeric_limits<float>::max();
+	uint32_t maxSamples = *std::max_element(m_TileSampleCounts.begin(), m_TileSampleCounts.end());
 
-	for (size_t i = 0; i < m_ActiveScene->Spheres.size(); i++) {
-		const Sphere& sphere = m_ActiveScene->Spheres[i];
+	// The frame being written is not the one the last frame went to, so tiles without any samples yet
+	// copy what the last frame showed
+	const OutputFrames::Frame& lastFrame = m_OutputFrames.GetPublishedFrame();
+	const uint32_t* lastImageData = lastFrame.Width == m_Width && lastFrame.Height == m_Height ? lastFrame.Pixels.data() : nullptr;
 
-		if (!sphere.Enabled) {
-			continue;
+	// One job per row of tiles. Neighbouring tiles with the same sample count are converted as one run of pixels.
+	m_ThreadPool.Dispatch(m_TileCountY, [this, maxSamples, lastImageData](uint32_t tileY, uint32_t /*threadIndex*/) {
+		uint32_t minY = tileY * m_TileSize;
+		uint32_t maxY = glm::min(minY + m_TileSize, m_Height);
+		const uint32_t* sampleCounts = m_TileSampleCounts.data() + (size_t)tileY * m_TileCountX;
+
+		for (uint32_t firstTile = 0; firstTile < m_TileCountX;) {
+			uint32_t samples = sampleCounts[firstTile];
+			uint32_t lastTile = firstTile + 1;
+			while (lastTile < m_TileCountX && sampleCounts[lastTile] == samples) {
+				lastTile++;
+			}
+
+			uint32_t minX = firstTile * m_TileSize;
+			uint32_t maxX = glm::min(lastTile * m_TileSize, m_Width);
+
+			if (m_Settings.SampleHeatmap) {
+				uint32_t color = Utils::HeatmapColor((float)samples / (float)glm::max(maxSamples, 1u));
+				for (uint32_t y = minY; y < maxY; y++) {
+					std::fill(m_ImageData + minX + (size_t)y * m_Width, m_ImageData + maxX + (size_t)y * m_Width, color);
+				}
+			} else if (samples > 0) {
+				float scale = 1.0f / (float)samples;
+
+				for (uint32_t y = minY; y < maxY; y++) {
+					size_t first = minX + (size_t)y * m_Width;
+					Tonemapper::Resolve(m_Settings.TonemapperType, m_AccumulationData + first, m_ImageData + first, maxX - minX, scale, m_Settings.UseSIMD);
+				}
+			} else if (lastImageData) {
+				for (uint32_t y = minY; y < maxY; y++) {
+					size_t first = minX + (size_t)y * m_Width;
+					memcpy(m_ImageData + first, lastImageData + first, (maxX - minX) * sizeof(uint32_t));
+				}
+			}
+
+			firstTile = lastTile;
 		}
+	});
 
-		glm::vec3 origin = ray.Origin - sphere.Position;
+	m_Stats.ResolveTime = timer.ElapsedMillis();
+}
 
-		float a = glm::dot(ray.Direction, ray.Direction);
-		float b = 2.0f * glm::dot(origin, ray.Direction);
-		float c = glm::dot(origin, origin) - sphere.Radius * sphere.Radius;
+void Renderer::RenderPreview() {
+	RT_PROFILE_SCOPE("Renderer::RenderPreview");
+	Walnut::Timer timer;
 
-		// Quadratic formula discriminant:
-		// b^2 - 4ac
+	m_PreviewScale = m_NextPreviewScale;
+	m_PreviewWidth = (m_Width + m_PreviewScale - 1) / m_PreviewScale;
+	m_PreviewHeight = (m_Height + m_PreviewScale - 1) / m_PreviewScale;
+	m_PreviewData.resize((size_t)m_PreviewWidth * m_PreviewHeight);
+	m_PreviewImage.resize((size_t)m_PreviewWidth * m_PreviewHeight);
 
-		float discriminant = b * b - 4.0f * a * c;
-		if (discriminant < 0.0f) {
-			continue;
+	m_PreviewTileCountX = (m_PreviewWidth + m_TileSize - 1) / m_TileSize;
+	m_PreviewTileCountY = (m_PreviewHeight + m_TileSize - 1) / m_TileSize;
+
+	m_ThreadPool.Dispatch(m_PreviewTileCountX * m_PreviewTileCountY, [this](uint32_t tileIndex, uint32_t threadIndex) {
+		RenderPreviewTile(tileIndex, threadIndex);
+	});
+
+	// A half resolution frame traces four times the rays of a quarter resolution one
+	float frameTime = timer.ElapsedMillis();
+	if (m_PreviewScale == s_MaxPreviewScale && frameTime * 4.0f < s_PreviewFrameBudget) {
+		m_NextPreviewScale = s_MaxPreviewScale / 2;
+	} else if (m_PreviewScale < s_MaxPreviewScale && frameTime > s_PreviewFrameBudget) {
+		m_NextPreviewScale = s_MaxPreviewScale;
+	}
+}
+
+void Renderer::RenderPreviewTile(uint32_t tileIndex, uint32_t threadIndex) {
+	uint32_t minX = (tileIndex % m_PreviewTileCountX) * m_TileSize;
+	uint32_t minY = (tileIndex / m_PreviewTileCountX) * m_TileSize;
+	uint32_t maxX = glm::min(minX + m_TileSize, m_PreviewWidth);
+	uint32_t maxY = glm::min(minY + m_TileSize, m_PreviewHeight);
+
+	// Each preview pixel covers a block of m_PreviewScale^2 image pixels and traces the ray through its center
+	int bounces = glm::clamp(m_Settings.PreviewRayBounces, 1, m_Settings.RayBounces);
+	float offset = (float)(m_PreviewScale - 1) * 0.5f;
+
+	RayCounters counters;
+
+	for (uint32_t y = minY; y < maxY; y++) {
+		for (uint32_t x = minX; x < maxX; x++) {
+			PathState path;
+			path.PathRay.Origin = m_ActiveCamera->GetPosition();
+			path.PathRay.Direction = m_ActiveCamera->GetRayDirection((float)(x * m_PreviewScale) + offset, (float)(y * m_PreviewScale) + offset);
+			path.PathSampler = Sampler(m_Settings.SamplerType, (uint32_t)m_Settings.Seed, x, y, m_PreviewWidth, 1);
+
+			m_PreviewData[x + y * m_PreviewWidth] = TracePath(path, bounces, counters);
+			counters.SamplesTraced++;
+		}
+
+		size_t first = minX + (size_t)y * m_PreviewWidth;
+		Tonemapper::Resolve(m_Settings.TonemapperType, m_PreviewData.data() + first, m_PreviewImage.data() + first, maxX - minX, 1.0f, m_Settings.UseSIMD);
+	}
+
+	m_ThreadCounters[threadIndex].NodesVisited += counters.NodesVisited;
+	m_ThreadCounters[threadIndex].RaysTraced += counters.RaysTraced;
+	m_ThreadCounters[threadIndex].SamplesTraced += counters.SamplesTraced;
+}
+
+void Renderer::UpsamplePreview() {
+	RT_PROFILE_SCOPE("Renderer::UpsamplePreview");
+	Walnut::Timer timer;
+
+	// Nearest neighbour, every preview row is expanded once and then copied to the rows below it
+	uint32_t scale = m_PreviewScale;
+	uint32_t rowsPerBand = m_TileSize * scale;
+	uint32_t bandCount = (m_Height + rowsPerBand - 1) / rowsPerBand;
+
+	m_ThreadPool.Dispatch(bandCount, [this, scale, rowsPerBand](uint32_t bandIndex, uint32_t /*threadIndex*/) {
+		uint32_t minY = bandIndex * rowsPerBand;
+		uint32_t maxY = glm::min(minY + rowsPerBand, m_Height);
+
+		for (uint32_t y = minY; y < maxY; y++) {
+			uint32_t* row = m_ImageData + (size_t)y * m_Width;
+
+			if (y % scale != 0) {
+				memcpy(row, row - m_Width, m_Width * sizeof(uint32_t));
+				continue;
+			}
+
+			const uint32_t* source = m_PreviewImage.data() + (size_t)(y / scale) * m_PreviewWidth;
+			for (uint32_t x = 0; x < m_Width; x++) {
+				row[x] = source[x / scale];
+			}
 		}
+	});
+
+	m_Stats.ResolveTime = timer.ElapsedMillis();
+}
 
-		// (-b += sqrt(discriminant)) / (2.0f * a)
-		// float t0 = (-b + glm::sqrt(discriminant)) / (2.0f * a);
-		// float t1 = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+void Renderer::BinWave(uint32_t activeCount) {
+	RT_PROFILE_SCOPE("Renderer::BinWave");
+	Walnut::Timer timer;
 
-		// glm::vec3 h0 = rayOrigin + rayDirection * t0;
-		// glm::vec3 h1 = rayOrigin + rayDirection * t1;
+	const BoundingBox& sceneBounds = m_SceneBounds;
+	glm::vec3 cellScale = (float)(1u << s_BinCellBits) / glm::max(sceneBounds.Max - sceneBounds.Min, glm::vec3(1e-6f));
 
-		float closestT = (-b - glm::sqrt(discriminant)) / (2.0f * a);
-		if (closestT > 0.0f && closestT < hitDistance) {
-			hitDistance = closestT;
-			closestSphere = (int)i;
+	m_WaveBinKeys.resize(activeCount);
+	m_WaveOrder.resize(activeCount);
+
+	uint32_t chunkCount = (activeCount + s_WavefrontChunkSize - 1) / s_WavefrontChunkSize;
+	m_ThreadPool.Dispatch(chunkCount, [this, activeCount, &sceneBounds, cellScale](uint32_t chunkIndex, uint32_t /*threadIndex*/) {
+		uint32_t first = chunkIndex * s_WavefrontChunkSize;
+		uint32_t last = glm::min(first + s_WavefrontChunkSize, activeCount);
+
+		for (uint32_t i = first; i < last; i++) {
+			const Ray& ray = m_WavePaths[i].PathRay;
+
+			// Origins outside the scene bounds end up in the border cells
+			glm::vec3 cell = glm::clamp((ray.Origin - sceneBounds.Min) * cellScale, glm::vec3(0.0f), glm::vec3((float)((1u << s_BinCellBits) - 1)));
+			uint32_t morton = (Utils::ExpandBits((uint32_t)cell.x) << 2) | (Utils::ExpandBits((uint32_t)cell.y) << 1) | Utils::ExpandBits((uint32_t)cell.z);
+			uint32_t octant = (ray.Direction.x < 0.0f ? 1u : 0u) | (ray.Direction.y < 0.0f ? 2u : 0u) | (ray.Direction.z < 0.0f ? 4u : 0u);
+
+			m_WaveBinKeys[i] = (morton << 3) | octant;
 		}
+	});
+
+	// Counting sort, stable so paths of one bin keep their tile order
+	m_WaveBinOffsets.assign(s_BinCount, 0);
+	for (uint32_t i = 0; i < activeCount; i++) {
+		m_WaveBinOffsets[m_WaveBinKeys[i]]++;
 	}
 
-	if (closestSphere < 0) {
-		return Miss(ray);
+	uint32_t offset = 0;
+	for (uint32_t& binOffset : m_WaveBinOffsets) {
+		uint32_t count = binOffset;
+		binOffset = offset;
+		offset += count;
+	}
+
+	for (uint32_t i = 0; i < activeCount; i++) {
+		m_WaveOrder[m_WaveBinOffsets[m_WaveBinKeys[i]]++] = i;
+	}
+
+	m_Stats.BinningTime += timer.ElapsedMillis();
+}
+
+glm::vec3 Renderer::RayGen(uint32_t x, uint32_t y, uint32_t sampleIndex, RayCounters& counters) {
+	PathState path = CreatePath(x, y, sampleIndex);
+	return TracePath(path, m_Settings.RayBounces, counters);
+}
+
+Renderer::PathState Renderer::CreatePath(uint32_t x, uint32_t y, uint32_t sampleIndex) const {
+	PathState path;
+	path.PathRay.Origin = m_ActiveCamera->GetPosition();
+	path.PathRay.Direction = m_ActiveCamera->GetRayDirection((float)x, (float)y);
+	path.PathSampler = Sampler(m_Settings.SamplerType, (uint32_t)m_Settings.Seed, x, y, m_Width, sampleIndex);
+	path.PixelIndex = x + y * m_Width;
+
+	return path;
+}
+
+glm::vec3 Renderer::TracePath(PathState& path, int bounces, RayCounters& counters) {
+	while (path.Depth < bounces) {
+		Renderer::HitPayload payload = TraceRay(path.PathRay, counters);
+
+		if (!Shade(payload, path, bounces)) {
+			break;
+		}
+	}
+
+	return path.Light;
+}
+
+bool Renderer::Shade(const HitPayload& payload, PathState& path, int bounces) const {
+	if (payload.HitDistance < 0.0f) {
+		if (m_ActiveScene->Sky.Enabled) {
+			path.Light += m_ActiveScene->Sky.Color * path.Contribution;
+		}
+		return false;
+	}
+
+	float lightIntensity = 1.0f;
+
+	if (m_ActiveScene->Lights.size() > 0) {
+		for (auto& light : m_ActiveScene->Lights) {
+			if (!light.Enabled) {
+				continue;
+			}
+
+			glm::vec3 lightDirection = glm::normalize(payload.ObjectPosition - light.Position);
+			lightIntensity += glm::max(glm::dot(payload.WorldNormal, -lightDirection), 0.0f); // == cos(angle)
+		}
+	}
+
+	// Scene files can hold any index, one without a material shades as if there were no materials at all
+	if ((size_t)payload.MaterialIndex < m_ActiveScene->Materials.size()) {
+		const Material& material = m_ActiveScene->Materials[payload.MaterialIndex];
+		path.Contribution *= material.Albedo * lightIntensity;
+		path.Light += material.GetEmission() * path.RouletteWeight;
+	}
+
+	path.PathRay.Origin = payload.WorldPosition + payload.WorldNormal * 0.0001f;
+
+	path.PathRay.Direction = Utils::CosineSampleHemisphere(payload.WorldNormal, path.PathSampler.Next2D());
+
+	path.Depth++;
+
+	// Russian roulette: past the minimum depth, paths carrying little throughput are ended at random and
+	// the survivors are weighted by 1 / survival, which keeps the expected value the same
+	if (m_Settings.RussianRoulette && path.Depth >= m_Settings.RussianRouletteDepth && path.Depth < bounces) {
+		const glm::vec3& contribution = path.Contribution;
+		float survival = glm::clamp(glm::max(contribution.r, glm::max(contribution.g, contribution.b)), s_MinSurvivalProbability, 1.0f);
+		if (path.PathSampler.Next1D() >= survival) {
+			return false;
+		}
+
+		path.Contribution /= survival;
+		path.RouletteWeight /= survival;
 	}
 
-	return ClosestHit(ray, hitDistance, closestSphere);
+	return true;
 }
 
-Renderer::HitPayload Renderer::ClosestHit(const Ray& ray, float hitDistance, int objectIndex) {
+Renderer::HitPayload Renderer::TraceRay(const Ray& ray, RayCounters& counters) {
 	Renderer::HitPayload payload;
-	payload.HitDistance = hitDistance;
-	payload.ObjectIndex = objectIndex;
+	payload.ObjectIndex = -1;
+	payload.PrimitiveIndex = -1;
+
+	float hitDistance = std::numeric_limits<float>::max();
+
+	uint32_t nodesVisited = 0;
+
+	m_SphereBVH.Traverse(ray, hitDistance, nodesVisited, [&](uint32_t firstPrimitive, uint32_t primitiveCount) {
+		int sphereIndex = m_SphereIntersector.Intersect(ray, firstPrimitive, primitiveCount, hitDistance);
+		if (sphereIndex >= 0) {
+			payload.Primitive = PrimitiveType::Sphere;
+			payload.ObjectIndex = sphereIndex;
+		}
+	});
+
+	// The ray is moved into each instance's space instead of moving the prototype. Without normalizing the
+	// direction a distance along the instance space ray is the same distance along the world space ray,
+	// so hitDistance carries over in both directions. Meshes work the same way.
+	m_InstanceBVH.Traverse(ray, hitDistance, nodesVisited, [&](uint32_t firstInstance, uint32_t instanceCount) {
+		for (uint32_t i = firstInstance; i < firstInstance + instanceCount; i++) {
+			const InstanceData& instance = m_Instances[i];
+			const PrototypeAccelerationStructure& prototype = m_PrototypeStructures[instance.PrototypeIndex];
+
+			Ray instanceRay;
+			instanceRay.Origin = glm::vec3(instance.WorldToInstance * glm::vec4(ray.Origin, 1.0f));
+			instanceRay.Direction = glm::mat3(instance.WorldToInstance) * ray.Direction;
+
+			prototype.SphereBVH.Traverse(instanceRay, hitDistance, nodesVisited, [&](uint32_t firstPrimitive, uint32_t primitiveCount) {
+				int sphereIndex = prototype.Intersector.Intersect(instanceRay, firstPrimitive, primitiveCount, hitDistance);
+				if (sphereIndex >= 0) {
+					payload.Primitive = PrimitiveType::InstanceSphere;
+					payload.ObjectIndex = (int)i;
+					payload.PrimitiveIndex = sphereIndex;
+				}
+			});
+		}
+	});
+
+	m_MeshBVH.Traverse(ray, hitDistance, nodesVisited, [&](uint32_t firstMesh, uint32_t meshCount) {
+		for (uint32_t i = firstMesh; i < firstMesh + meshCount; i++) {
+			const MeshData& mesh = m_Meshes[i];
+			const MeshAccelerationStructure& structure = m_MeshStructures[mesh.StructureIndex];
+
+			Ray meshRay;
+			meshRay.Origin = glm::vec3(mesh.WorldToMesh * glm::vec4(ray.Origin, 1.0f));
+			meshRay.Direction = glm::mat3(mesh.WorldToMesh) * ray.Direction;
+
+			TriangleIntersector::PreparedRay preparedRay = TriangleIntersector::Prepare(meshRay);
+
+			structure.TriangleBVH.Traverse(meshRay, hitDistance, nodesVisited, [&](uint32_t firstPrimitive, uint32_t primitiveCount) {
+				int triangleIndex = structure.Intersector.Intersect(preparedRay, firstPrimitive, primitiveCount, hitDistance);
+				if (triangleIndex >= 0) {
+					payload.Primitive = PrimitiveType::Triangle;
+					payload.ObjectIndex = (int)i;
+					payload.PrimitiveIndex = triangleIndex;
+				}
+			});
+		}
+	});
 
-	const Sphere& closestSphere = m_ActiveScene->Spheres[objectIndex];
+	counters.NodesVisited += nodesVisited;
+	counters.RaysTraced++;
 
-	glm::vec3 origin = ray.Origin - closestSphere.Position;
-	payload.WorldPosition = origin + ray.Direction * hitDistance;
-	payload.WorldNormal = glm::normalize(payload.WorldPosition);
+	if (payload.ObjectIndex < 0) {
+		return Miss(ray);
+	}
 
-	payload.WorldPosition += closestSphere.Position;
+	payload.HitDistance = hitDistance;
+	ClosestHit(ray, payload);
 
 	return payload;
 }
 
+void Renderer::ClosestHit(const Ray& ray, HitPayload& payload) {
+	switch (payload.Primitive) {
+		case PrimitiveType::Sphere: {
+			const Sphere& closestSphere = m_ActiveScene->Spheres[payload.ObjectIndex];
+			payload.ObjectPosition = closestSphere.Position;
+			payload.MaterialIndex = closestSphere.MaterialIndex;
+
+			glm::vec3 origin = ray.Origin - closestSphere.Position;
+			payload.WorldPosition = origin + ray.Direction * payload.HitDistance;
+			payload.WorldNormal = glm::normalize(payload.WorldPosition);
+
+			payload.WorldPosition += closestSphere.Position;
+			break;
+		}
+		case PrimitiveType::InstanceSphere: {
+			const InstanceData& instance = m_Instances[payload.ObjectIndex];
+			const Sphere& closestSphere = m_ActiveScene->Prototypes[instance.PrototypeIndex].Spheres[payload.PrimitiveIndex];
+			payload.ObjectPosition = glm::vec3(instance.InstanceToWorld * glm::vec4(closestSphere.Position, 1.0f));
+			// Checked here rather than in UpdateInstanceStructure, which does not run when only the materials change
+			bool hasOverride = (size_t)instance.MaterialIndex < m_ActiveScene->Materials.size();
+			payload.MaterialIndex = hasOverride ? instance.MaterialIndex : closestSphere.MaterialIndex;
+
+			// The sphere is only round in instance space, its normal is turned back with the inverse transpose
+			payload.WorldPosition = ray.Origin + ray.Direction * payload.HitDistance;
+			glm::vec3 instancePosition = glm::vec3(instance.WorldToInstance * glm::vec4(payload.WorldPosition, 1.0f));
+			payload.WorldNormal = glm::normalize(instance.NormalToWorld * (instancePosition - closestSphere.Position));
+			break;
+		}
+		case PrimitiveType::Triangle: {
+			const MeshData& mesh = m_Meshes[payload.ObjectIndex];
+			const MeshGeometry& geometry = *m_MeshStructures[mesh.StructureIndex].Geometry;
+			payload.ObjectPosition = mesh.Position;
+			payload.MaterialIndex = mesh.MaterialIndex;
+
+			const uint32_t* indices = &geometry.Indices[(size_t)payload.PrimitiveIndex * 3];
+			const glm::vec3& v0 = geometry.Positions[indices[0]];
+			const glm::vec3& v1 = geometry.Positions[indices[1]];
+			const glm::vec3& v2 = geometry.Positions[indices[2]];
+
+			payload.WorldPosition = ray.Origin + ray.Direction * payload.HitDistance;
+			payload.WorldNormal = glm::normalize(mesh.NormalToWorld * glm::cross(v1 - v0, v2 - v0));
+
+			// Triangles are two sided, the normal faces the side the ray came from
+			if (glm::dot(payload.WorldNormal, ray.Direction) > 0.0f) {
+				payload.WorldNormal = -payload.WorldNormal;
+			}
+			break;
+		}
+	}
+}
+
 Renderer::HitPayload Renderer::Miss(const Ray& ray) {
 	Renderer::HitPayload payload;
 	payload.HitDistance = -1.0f;
@@ -1,26 +1,104 @@
 #pragma once
 
-#include "Walnut/Image.h"
-
 #include "../Scene/Camera.h"
 #include "../Scene/Scene.h"
 #include "Ray.h"
+#include "BVH.h"
+#include "ThreadPool.h"
+#include "SphereIntersector.h"
+#include "TriangleIntersector.h"
+#include "OutputFrames.h"
+#include "Sampler.h"
+#include "Tonemapper.h"
 
+#include <vector>
+#include <string>
 #include <memory>
 #include <glm/glm.hpp>
 
 class Renderer {
 public:
+	enum class Integrator {
+		PerPixel = 0, // Every pixel runs its whole bounce loop before the next one starts
+		Wavefront     // Breadth first, each bounce of a whole batch of paths is intersected, then shaded
+	};
+
 	struct Settings {
 		bool Accumulate = true;
 		bool Multithreading = true;
-		bool FastRandom = true;
-		bool UseClockTime = true;
-		bool UseFrameIndex = true;
-		bool UseRayBounces = true;
+		bool UseSIMD = true;
+		bool ProgressivePreview = true; // Trace at a reduced resolution while the camera moves
+		bool FrameTimeBudget = false; // Trace as many samples as fit in TargetFrameTime, a pass may span several frames
+		bool AdaptiveSampling = false; // Stop sampling tiles once their noise is below ConvergenceThreshold
+		bool SampleHeatmap = false; // Show how many samples each tile received instead of the image
+		bool RussianRoulette = true; // End low throughput paths early, without changing the expected image
+		bool RayBinning = false; // Wavefront only: intersect bounce rays grouped by origin cell and direction octant
+
+		Integrator IntegratorType = Integrator::PerPixel;
+		Sampler::Type SamplerType = Sampler::Type::Sobol;
+		Tonemapper::Type TonemapperType = Tonemapper::Type::None;
 
 		int RayBounces = 5;
+		int PreviewRayBounces = 2;
+		int RussianRouletteDepth = 3; // Bounces every path gets before roulette starts
+		int Seed = 0; // Same seed, scene and camera always produce the same image
 		int ResolutionScale = 100;
+		int TargetFrameTime = 16; // ms
+		float ConvergenceThreshold = 0.01f; // Relative standard error of a pixel's mean luminance
+
+		int TileSize = 16;
+		int ThreadCount = 0; // 0 = all hardware threads
+
+		bool operator==(const Settings& other) const {
+			return (
+				this->Accumulate == other.Accumulate &&
+				this->Multithreading == other.Multithreading &&
+				this->UseSIMD == other.UseSIMD &&
+				this->ProgressivePreview == other.ProgressivePreview &&
+				this->FrameTimeBudget == other.FrameTimeBudget &&
+				this->AdaptiveSampling == other.AdaptiveSampling &&
+				this->SampleHeatmap == other.SampleHeatmap &&
+				this->RussianRoulette == other.RussianRoulette &&
+				this->RayBinning == other.RayBinning &&
+				this->IntegratorType == other.IntegratorType &&
+				this->SamplerType == other.SamplerType &&
+				this->TonemapperType == other.TonemapperType &&
+				this->RayBounces == other.RayBounces &&
+				this->PreviewRayBounces == other.PreviewRayBounces &&
+				this->RussianRouletteDepth == other.RussianRouletteDepth &&
+				this->Seed == other.Seed &&
+				this->ResolutionScale == other.ResolutionScale &&
+				this->TargetFrameTime == other.TargetFrameTime &&
+				this->ConvergenceThreshold == other.ConvergenceThreshold &&
+				this->TileSize == other.TileSize &&
+				this->ThreadCount == other.ThreadCount
+			);
+		}
+
+		bool operator!=(const Settings& other) const { return !(*this == other); }
+	};
+
+	struct Stats {
+		float BVHBuildTime = 0.0f; // Or the refit time when BVHRefitted
+		uint32_t BVHNodeCount = 0;
+		float BVHCost = 0.0f; // See BVH::GetCost
+		bool BVHRefitted = false;
+		float InstanceBuildTime = 0.0f; // Prototype BVHs and the BVH over the instances
+		uint32_t InstanceCount = 0;
+		float MeshBuildTime = 0.0f; // Triangle BVHs of newly loaded geometry and the BVH over the meshes
+		uint32_t MeshCount = 0;
+		uint64_t TriangleCount = 0; // Summed over the meshes, shared geometry counts once per mesh
+		float AverageNodesVisited = 0.0f;
+		float AveragePathLength = 0.0f; // Rays traced per sample
+		uint64_t RaysTraced = 0; // During the last frame
+		float BinningTime = 0.0f;
+		float ResolveTime = 0.0f;
+		float SamplesPerPixelPerSecond = 0.0f;
+		float ConvergedTiles = 0.0f; // Fraction of tiles adaptive sampling has stopped
+		uint32_t PreviewScale = 1; // Resolution divisor of the last frame, 1 = full resolution
+		const char* IntersectionKernel = "Scalar";
+
+		std::vector<float> ThreadUtilization;
 	};
 public:
 	Renderer() = default;
@@ -28,45 +106,246 @@ public:
 	void OnResize(uint32_t width, uint32_t height);
 	void Render(const Scene& scene, const Camera& camera);
 
-	std::shared_ptr<Walnut::Image> GetFinalImage() const { return m_FinalImage; }
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+
+	void ResetFrameIndex() { m_FrameIndex = 1; m_ResetAccumulation = true; }
+
+	// Measured duration of the last whole frame, the tracing budget is what TargetFrameTime leaves after everything else
+	void SetFrameTime(float milliseconds) { m_FrameTime = milliseconds; }
 
-	void ResetFrameIndex() { m_FrameIndex = 1; }
+	// While navigating, frames are traced at 1/4 or 1/2 of the resolution with PreviewRayBounces and
+	// upsampled to the full image. Accumulation starts over at full resolution once navigation stops.
+	void SetNavigating(bool navigating);
 	int GetFrameIndex() { return m_FrameIndex; }
 	Settings& GetSettings() { return m_Settings; }
+	const Stats& GetStats() const { return m_Stats; }
 
-	const uint32_t* GetImageData() const { return m_ImageData; }
+	// Final image of the last frame, for the thread that calls Render
+	const uint32_t* GetImageData() const { return m_OutputFrames.GetPublishedFrame().Pixels.data(); }
+
+	// Latest finished frame for a consumer that overlaps its use of the image with the next Render,
+	// such as a GPU upload. See OutputFrames.
+	const OutputFrames::Frame& AcquireLatestFrame() { return m_OutputFrames.AcquireLatest(); }
+
+	static const char* GetIntegratorName(Integrator integrator);
+	static bool TryParseIntegrator(const std::string& name, Integrator& integrator);
 
 	void SetTime(float time) { m_Time = time; }
 	void GetTime(float& time) { m_Time = time; }
 private:
+	enum class PrimitiveType {
+		Sphere = 0,     // ObjectIndex is the scene sphere
+		InstanceSphere, // ObjectIndex is the instance in m_Instances, PrimitiveIndex the sphere in its prototype
+		Triangle        // ObjectIndex is the mesh in m_Meshes, PrimitiveIndex the triangle in its geometry
+	};
+
 	struct HitPayload {
 		float HitDistance;
 		glm::vec3 WorldPosition;
 		glm::vec3 WorldNormal;
 
+		// What TraceRay found, ClosestHit fills in everything else from these
+		PrimitiveType Primitive;
 		int ObjectIndex;
+		int PrimitiveIndex;
+
+		// World space center of the sphere or origin of the mesh that was hit, and its material (with any instance override applied)
+		glm::vec3 ObjectPosition;
+		int MaterialIndex;
+	};
+
+	// Everything a path carries from one bounce to the next, so the integrators can stop and resume it
+	struct PathState {
+		Ray PathRay;
+		Sampler PathSampler;
+
+		glm::vec3 Light{ 0.0f };
+		glm::vec3 Contribution{ 1.0f };
+		float RouletteWeight = 1.0f; // Emission is not scaled by Contribution, so it needs the roulette weight separately
+
+		int Depth = 0;
+		uint32_t PixelIndex = 0;
+	};
+
+	struct RayCounters {
+		uint64_t NodesVisited = 0;
+		uint64_t RaysTraced = 0;
+		uint64_t SamplesTraced = 0;
 	};
 
-	void Accumulate(const uint32_t& x, const uint32_t& y);
+	void UpdateAccelerationStructure();
+	void UpdatePrototypeStructures();
+	void UpdateInstanceStructure();
+	void UpdateMeshStructures();
+	void UpdateSceneBounds();
+
+	void TraceTiles();
+	uint32_t GetPassSamples(bool adaptive) const; // Fewest samples of any tile still being sampled
+	bool IsTileConverged(uint32_t tileIndex) const;
+
+	void RenderTile(uint32_t tileIndex, uint32_t threadIndex);
+	void Accumulate(const uint32_t& x, const uint32_t& y, const uint32_t& sampleIndex, RayCounters& counters);
+	void AccumulatePath(const PathState& path);
+
+	void RenderWave(const uint32_t* tiles, uint32_t tileCount);
+	void BinWave(uint32_t activeCount);
+	float GetTileError(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY, uint32_t sampleCount) const;
+	void Resolve();
 
-	glm::vec4 RayGen(uint32_t x, uint32_t y); // PerPixel
+	void RenderPreview();
+	void RenderPreviewTile(uint32_t tileIndex, uint32_t threadIndex);
+	void UpsamplePreview();
 
-	HitPayload TraceRay(const Ray& ray);
-	HitPayload ClosestHit(const Ray& ray, float hitDistance, int objectIndex);
+	glm::vec3 RayGen(uint32_t x, uint32_t y, uint32_t sampleIndex, RayCounters& counters); // PerPixel
+	PathState CreatePath(uint32_t x, uint32_t y, uint32_t sampleIndex) const;
+	glm::vec3 TracePath(PathState& path, int bounces, RayCounters& counters);
+
+	// Adds what the ray hit (or the sky on a miss) to the path and continues it, false once the path ended
+	bool Shade(const HitPayload& payload, PathState& path, int bounces) const;
+
+	HitPayload TraceRay(const Ray& ray, RayCounters& counters);
+	void ClosestHit(const Ray& ray, HitPayload& payload);
 	HitPayload Miss(const Ray& ray);
 private:
-	std::shared_ptr<Walnut::Image> m_FinalImage;
 	Settings m_Settings;
+	Stats m_Stats;
+
+	ThreadPool m_ThreadPool;
+	std::vector<RayCounters> m_ThreadCounters;
 
-	std::vector<uint32_t> m_ImageHorizontalIterator, m_ImageVerticalIterator;
+	uint32_t m_TileSize = 16;
+	uint32_t m_TileCountX = 0, m_TileCountY = 0;
+
+	// Samples accumulated per tile, tiles differ while a budgeted pass is unfinished or with adaptive sampling
+	std::vector<uint32_t> m_TileSampleCounts;
+	std::vector<float> m_TileErrors; // See GetTileError
+	std::vector<uint32_t> m_PendingTiles;
+	bool m_ResetAccumulation = true;
+
+	static constexpr float s_MinTraceBudget = 1.0f; // ms, so every frame makes some progress
+	float m_FrameTime = 0.0f;
+	float m_TraceTime = 0.0f;
 
 	const Scene* m_ActiveScene = nullptr;
 	const Camera* m_ActiveCamera = nullptr;
 
+	// Acceleration structure over the enabled spheres of the active scene,
+	// m_BVHSphereIndices maps BVH primitive order to indices in Scene::Spheres
+	BVH m_SphereBVH;
+	std::vector<uint32_t> m_BVHSphereIndices;
+	SphereIntersector m_SphereIntersector;
+
+	// What the sphere BVH was built over, to tell whether a refit is enough
+	std::vector<uint32_t> m_EnabledSpheres;
+	float m_SphereBVHBuildCost = 0.0f;
+	static constexpr float s_MaxRefitCostRatio = 2.0f;
+
+	// One BVH per prototype, shared by all of its instances
+	struct PrototypeAccelerationStructure {
+		BVH SphereBVH;
+		SphereIntersector Intersector;
+	};
+
+	// Enabled instances of valid prototypes, in the primitive order of m_InstanceBVH
+	struct InstanceData {
+		glm::mat4 WorldToInstance;
+		glm::mat4 InstanceToWorld;
+		glm::mat3 NormalToWorld;
+		uint32_t PrototypeIndex;
+		int MaterialIndex;
+	};
+
+	std::vector<PrototypeAccelerationStructure> m_PrototypeStructures;
+	std::vector<InstanceData> m_Instances;
+	BVH m_InstanceBVH;
+
+	// One BVH per mesh geometry in mesh space, shared by every mesh referencing the geometry
+	struct MeshAccelerationStructure {
+		std::shared_ptr<const MeshGeometry> Geometry;
+		BVH TriangleBVH;
+		TriangleIntersector Intersector;
+	};
+
+	// Enabled meshes with geometry, in the primitive order of m_MeshBVH
+	struct MeshData {
+		glm::mat4 WorldToMesh;
+		glm::mat3 NormalToWorld;
+		glm::vec3 Position;
+		uint32_t StructureIndex;
+		int MaterialIndex;
+	};
+
+	static constexpr uint32_t s_TriangleLeafSize = 4;
+
+	std::vector<MeshAccelerationStructure> m_MeshStructures;
+	std::vector<MeshData> m_Meshes;
+	BVH m_MeshBVH;
+
+	// Bounds of everything that can be hit, spheres, instances and meshes
+	BoundingBox m_SceneBounds;
+
+	// Scene revisions the BVHs and the accumulated image were built from, see SceneRevisions
+	uint64_t m_SphereRevision = 0;
+	uint64_t m_PrototypeRevision = 0;
+	uint64_t m_InstanceRevision = 0;
+	uint64_t m_MeshRevision = 0;
+	uint64_t m_SceneRevision = 0;
+
+	uint32_t m_Width = 0, m_Height = 0;
+
+	// Final RGBA8 images, uploaded to the GPU (or written to disk) by whoever owns the renderer.
+	// m_ImageData points into the frame being written during Render.
+	OutputFrames m_OutputFrames;
 	uint32_t* m_ImageData = nullptr;
-	glm::vec4* m_AccumulationData = nullptr;
+
+	// Sum of all samples per pixel since the last frame index reset, turned into m_ImageData by Resolve
+	glm::vec3* m_AccumulationData = nullptr;
+
+	// Sum of the squared luminance of all samples per pixel, for the variance adaptive sampling is driven by
+	float* m_LuminanceSquaredData = nullptr;
+
+	// Paths per wave, and paths per job within the wavefront stages
+	static constexpr uint32_t s_WavefrontWaveSize = 1 << 16;
+	static constexpr uint32_t s_WavefrontChunkSize = 1024;
+
+	// The active paths of the current wave, compacted after every bounce. Paths of one tile are stored next to
+	// each other, m_WaveTileOffsets holds where each tile's paths start when the wave is generated.
+	std::vector<PathState> m_WavePaths;
+	std::vector<PathState> m_WaveNextPaths;
+	std::vector<HitPayload> m_WaveHits;
+	std::vector<uint32_t> m_WaveTileOffsets;
+	std::vector<uint32_t> m_WaveChunkSurvivors;
+
+	// Ray binning: a 2^s_BinCellBits cells per axis grid over the scene bounds, Morton ordered, times 8 direction octants.
+	// m_WaveOrder is the order the intersection stage visits the active paths in.
+	static constexpr uint32_t s_BinCellBits = 4;
+	static constexpr uint32_t s_BinCount = 1u << (3 * s_BinCellBits + 3);
+
+	std::vector<uint32_t> m_WaveBinKeys;
+	std::vector<uint32_t> m_WaveBinOffsets;
+	std::vector<uint32_t> m_WaveOrder;
+
+	static constexpr float s_MinSurvivalProbability = 0.05f; // Caps the weight of a roulette survivor at 20
+
+	static constexpr uint32_t s_MinAdaptiveSamples = 16; // Fewer samples give too unreliable a variance
+	static constexpr float s_MinErrorLuminance = 0.05f;
 
 	uint32_t m_FrameIndex = 1;
 
+	// Previews start at s_MaxPreviewScale and switch to half resolution once that still fits s_PreviewFrameBudget
+	static constexpr uint32_t s_MaxPreviewScale = 4;
+	static constexpr float s_PreviewFrameBudget = 1000.0f / 30.0f; // ms
+
+	bool m_Navigating = false;
+	uint32_t m_PreviewScale = s_MaxPreviewScale;     // Of the current preview frame
+	uint32_t m_NextPreviewScale = s_MaxPreviewScale; // Picked from the current frame's time, upsampling still needs the current one
+	uint32_t m_PreviewWidth = 0, m_PreviewHeight = 0;
+	uint32_t m_PreviewTileCountX = 0, m_PreviewTileCountY = 0;
+
+	// One sample per preview pixel and its tonemapped color, m_PreviewWidth * m_PreviewHeight each
+	std::vector<glm::vec3> m_PreviewData;
+	std::vector<uint32_t> m_PreviewImage;
+
 	float m_Time = 0.0f;
 };
\ No newline at end of file
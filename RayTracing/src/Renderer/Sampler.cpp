@@ -0,0 +1,236 @@
+#include "Sampler.h"
+
+#include <vector>
+#include <limits>
+#include <cmath>
+
+namespace Utils {
+	static uint32_t ReverseBits(uint32_t value) {
+		value = (value << 16) | (value >> 16);
+		value = ((value & 0x00ff00ffu) << 8) | ((value & 0xff00ff00u) >> 8);
+		value = ((value & 0x0f0f0f0fu) << 4) | ((value & 0xf0f0f0f0u) >> 4);
+		value = ((value & 0x33333333u) << 2) | ((value & 0xccccccccu) >> 2);
+		value = ((value & 0x55555555u) << 1) | ((value & 0xaaaaaaaau) >> 1);
+		return value;
+	}
+
+	// Hash-based Owen scramble (Burley 2020, "Practical Hash-based Owen Scrambling"):
+	// the Laine-Karras permutation only lets lower bits affect higher ones, so applying it
+	// to the bit-reversed value flips every bit depending only on the bits above it.
+	static uint32_t NestedUniformScramble(uint32_t value, uint32_t seed) {
+		value = ReverseBits(value);
+
+		value += seed;
+		value ^= value * 0x6c50b47cu;
+		value ^= value * 0xb82f1e52u;
+		value ^= value * 0xc7afe638u;
+		value ^= value * 0x8d22f6e6u;
+
+		return ReverseBits(value);
+	}
+
+	// Second Sobol dimension, its direction numbers follow v[i] = v[i - 1] ^ (v[i - 1] >> 1)
+	static uint32_t SobolSecondDimension(uint32_t index) {
+		uint32_t result = 0;
+
+		for (uint32_t direction = 1u << 31; index; index >>= 1, direction ^= direction >> 1) {
+			if (index & 1) {
+				result ^= direction;
+			}
+		}
+
+		return result;
+	}
+
+	static void AddEnergy(std::vector<float>& energy, const std::vector<float>& kernel, uint32_t size, uint32_t pixel, float sign) {
+		uint32_t pixelX = pixel % size;
+		uint32_t pixelY = pixel / size;
+
+		for (uint32_t y = 0; y < size; y++) {
+			const float* kernelRow = &kernel[((y + size - pixelY) % size) * size];
+			for (uint32_t x = 0; x < size; x++) {
+				energy[x + y * size] += sign * kernelRow[(x + size - pixelX) % size];
+			}
+		}
+	}
+
+	static uint32_t FindTightestCluster(const std::vector<uint8_t>& pattern, const std::vector<float>& energy) {
+		uint32_t best = 0;
+		float bestEnergy = -1.0f;
+
+		for (uint32_t i = 0; i < (uint32_t)pattern.size(); i++) {
+			if (pattern[i] && energy[i] > bestEnergy) {
+				best = i;
+				bestEnergy = energy[i];
+			}
+		}
+
+		return best;
+	}
+
+	static uint32_t FindLargestVoid(const std::vector<uint8_t>& pattern, const std::vector<float>& energy) {
+		uint32_t best = 0;
+		float bestEnergy = std::numeric_limits<float>::max();
+
+		for (uint32_t i = 0; i < (uint32_t)pattern.size(); i++) {
+			if (!pattern[i] && energy[i] < bestEnergy) {
+				best = i;
+				bestEnergy = energy[i];
+			}
+		}
+
+		return best;
+	}
+
+	// Ulichney's void-and-cluster method on a torus, returns the rank of every pixel
+	static std::vector<uint32_t> GenerateBlueNoiseRanks(uint32_t size) {
+		uint32_t pixelCount = size * size;
+
+		const float sigma = 1.5f;
+		std::vector<float> kernel(pixelCount);
+		for (uint32_t y = 0; y < size; y++) {
+			for (uint32_t x = 0; x < size; x++) {
+				float dx = (float)glm::min(x, size - x);
+				float dy = (float)glm::min(y, size - y);
+				kernel[x + y * size] = std::exp(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+			}
+		}
+
+		std::vector<uint8_t> pattern(pixelCount, 0);
+		std::vector<float> energy(pixelCount, 0.0f);
+
+		// Initial binary pattern: 10% of the pixels at hashed positions
+		uint32_t initialCount = pixelCount / 10;
+		for (uint32_t count = 0, state = 0; count < initialCount; state++) {
+			uint32_t pixel = Sampler::Hash(state) % pixelCount;
+			if (!pattern[pixel]) {
+				pattern[pixel] = 1;
+				AddEnergy(energy, kernel, size, pixel, 1.0f);
+				count++;
+			}
+		}
+
+		// Move the tightest cluster into the largest void until that stops changing anything
+		while (true) {
+			uint32_t cluster = FindTightestCluster(pattern, energy);
+			pattern[cluster] = 0;
+			AddEnergy(energy, kernel, size, cluster, -1.0f);
+
+			uint32_t largestVoid = FindLargestVoid(pattern, energy);
+			pattern[largestVoid] = 1;
+			AddEnergy(energy, kernel, size, largestVoid, 1.0f);
+
+			if (largestVoid == cluster) {
+				break;
+			}
+		}
+
+		std::vector<uint32_t> ranks(pixelCount);
+
+		// Phase 1: rank the initial pattern by removing its tightest clusters first
+		{
+			std::vector<uint8_t> remaining = pattern;
+			std::vector<float> remainingEnergy = energy;
+
+			for (uint32_t rank = initialCount; rank > 0; rank--) {
+				uint32_t cluster = FindTightestCluster(remaining, remainingEnergy);
+				remaining[cluster] = 0;
+				AddEnergy(remainingEnergy, kernel, size, cluster, -1.0f);
+				ranks[cluster] = rank - 1;
+			}
+		}
+
+		// Phase 2 and 3: fill the largest void until every pixel has a rank. With a linear
+		// filter the tightest cluster of empty pixels is also the largest void of set ones,
+		// so the inverted pattern Ulichney uses past half-full is not needed.
+		for (uint32_t rank = initialCount; rank < pixelCount; rank++) {
+			uint32_t largestVoid = FindLargestVoid(pattern, energy);
+			pattern[largestVoid] = 1;
+			AddEnergy(energy, kernel, size, largestVoid, 1.0f);
+			ranks[largestVoid] = rank;
+		}
+
+		return ranks;
+	}
+}
+
+Sampler::Sampler(Type type, uint32_t seed, uint32_t x, uint32_t y, uint32_t width, uint32_t frameIndex)
+	: m_Type(type), m_X(x), m_Y(y)
+{
+	m_SeedKey = Hash(seed);
+	m_PixelKey = Hash(m_SeedKey ^ (x + y * width));
+	m_Key = Hash(m_PixelKey ^ frameIndex);
+
+	// Frame indices start at 1, sequences at 0
+	m_SampleIndex = frameIndex - 1;
+
+	if (m_Type == Type::BlueNoise) {
+		m_BlueNoiseMask = GetBlueNoiseMask();
+	}
+}
+
+const char* Sampler::GetTypeName(Type type) {
+	switch (type) {
+		case Type::Independent:
+			return "Independent";
+		case Type::Sobol:
+			return "Sobol";
+		case Type::BlueNoise:
+			return "BlueNoise";
+	}
+
+	return "Unknown";
+}
+
+bool Sampler::TryParseType(const std::string& name, Type& type) {
+	for (Type candidate : { Type::Independent, Type::Sobol, Type::BlueNoise }) {
+		if (name == GetTypeName(candidate)) {
+			type = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const uint32_t* Sampler::GetBlueNoiseMask() {
+	static const std::vector<uint32_t> mask = []() {
+		std::vector<uint32_t> ranks = Utils::GenerateBlueNoiseRanks(s_BlueNoiseSize);
+
+		// Centre of every rank's interval as 0.32 fixed point, so frame rotations can wrap around for free
+		uint64_t pixelCount = (uint64_t)ranks.size();
+		for (uint32_t& rank : ranks) {
+			rank = (uint32_t)(((2 * (uint64_t)rank + 1) << 31) / pixelCount);
+		}
+
+		return ranks;
+	}();
+
+	return mask.data();
+}
+
+float Sampler::Sobol(uint32_t dimension) const {
+	// Dimensions are consumed in pairs from the (0, 2)-sequence formed by the first two Sobol
+	// dimensions. Every pair gets its own shuffled sample index so pairs stay decorrelated.
+	uint32_t pair = dimension >> 1;
+	uint32_t pairSeed = Hash(m_PixelKey ^ Hash(pair));
+
+	uint32_t index = Utils::NestedUniformScramble(m_SampleIndex, pairSeed);
+	uint32_t value = (dimension & 1) ? Utils::SobolSecondDimension(index) : Utils::ReverseBits(index);
+
+	return ToFloat(Utils::NestedUniformScramble(value, Hash(pairSeed + (dimension & 1) + 1)));
+}
+
+float Sampler::BlueNoise(uint32_t dimension) const {
+	// Every dimension reads the mask at its own toroidal offset, the same for all pixels so the
+	// spatial blue-noise distribution survives. Frames rotate dimension pairs along the R2 sequence,
+	// a single golden ratio step for both would only ever move points along the diagonal.
+	uint32_t offset = Hash(m_SeedKey ^ (dimension * 0x9e3779b9u));
+	uint32_t maskX = (m_X + offset) % s_BlueNoiseSize;
+	uint32_t maskY = (m_Y + (offset >> 16)) % s_BlueNoiseSize;
+
+	uint32_t rotation = m_SampleIndex * ((dimension & 1) ? 2447445413u : 3242174889u);
+	uint32_t value = m_BlueNoiseMask[maskX + maskY * s_BlueNoiseSize] + rotation;
+
+	return ToFloat(value);
+}
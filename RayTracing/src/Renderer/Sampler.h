@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <cstdint>
+
+// Per-pixel source of sample values for RayGen. Samplers are stateless apart from a
+// dimension counter: every value is a function of (seed, pixel, frame, dimension), so
+// there is no per-pixel state to store and a render only depends on Settings::Seed,
+// never on the clock or on which thread picked up a tile.
+class Sampler {
+public:
+	enum class Type {
+		Independent = 0, // White noise from an integer hash
+		Sobol,           // Owen-scrambled 2D Sobol points, shuffled per dimension pair
+		BlueNoise        // Void-and-cluster mask, rotated along the R2 sequence every frame
+	};
+public:
+	Sampler() = default; // Placeholder for path queues, overwritten before it is used
+	Sampler(Type type, uint32_t seed, uint32_t x, uint32_t y, uint32_t width, uint32_t frameIndex);
+
+	// Uniform float in [0, 1), every call consumes one dimension
+	float Next1D() {
+		uint32_t dimension = m_Dimension++;
+
+		switch (m_Type) {
+			case Type::Sobol:
+				return Sobol(dimension);
+			case Type::BlueNoise:
+				return BlueNoise(dimension);
+			default:
+				return ToFloat(Hash(m_Key + dimension * 0x9e3779b9u));
+		}
+	}
+
+	glm::vec2 Next2D() {
+		float u = Next1D();
+		float v = Next1D();
+		return { u, v };
+	}
+
+	uint32_t GetDimension() const { return m_Dimension; }
+
+	static const char* GetTypeName(Type type);
+	static bool TryParseType(const std::string& name, Type& type);
+
+	// PCG output permutation used as an integer hash
+	static uint32_t Hash(uint32_t input) {
+		uint32_t state = input * 747796405u + 2891336453u;
+		uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		return (word >> 22u) ^ word;
+	}
+public:
+	static constexpr uint32_t s_BlueNoiseSize = 64;
+
+	// Void-and-cluster ranks of a s_BlueNoiseSize² mask as 0.32 fixed point, generated on first use
+	static const uint32_t* GetBlueNoiseMask();
+private:
+	float Sobol(uint32_t dimension) const;
+	float BlueNoise(uint32_t dimension) const;
+
+	static float ToFloat(uint32_t value) { return (float)(value >> 8) * (1.0f / 16777216.0f); }
+private:
+	Type m_Type = Type::Independent;
+
+	uint32_t m_SeedKey = 0;
+	uint32_t m_PixelKey = 0;
+	uint32_t m_Key = 0;
+	uint32_t m_SampleIndex = 0;
+	uint32_t m_X = 0, m_Y = 0;
+
+	uint32_t m_Dimension = 0;
+
+	const uint32_t* m_BlueNoiseMask = nullptr;
+};
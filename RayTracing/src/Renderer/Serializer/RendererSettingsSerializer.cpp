@@ -2,8 +2,8 @@
 
 #include <fstream>
 
-RendererSettingsSerializer::RendererSettingsSerializer(Renderer& renderer)
-	: m_Renderer(renderer)
+RendererSettingsSerializer::RendererSettingsSerializer(Renderer::Settings& settings)
+	: m_Settings(settings)
 {}
 
 bool RendererSettingsSerializer::Serialize(const std::filesystem::path& filepath) {
@@ -13,7 +13,7 @@ bool RendererSettingsSerializer::Serialize(const std::filesystem::path& filepath
 		out << YAML::Key << "Renderer" << YAML::Value;
 		{
 			out << YAML::BeginMap; // Renderer
-			SerializeSettings(out, m_Renderer.GetSettings());
+			SerializeSettings(out, m_Settings);
 			out << YAML::EndMap; // Renderer
 		}
 		out << YAML::EndMap; // Root
@@ -28,12 +28,25 @@ bool RendererSettingsSerializer::Serialize(const std::filesystem::path& filepath
 void RendererSettingsSerializer::SerializeSettings(YAML::Emitter& out, const Renderer::Settings& settings) {
 	out << YAML::Key << "Accumulate" << YAML::Value << settings.Accumulate;
 	out << YAML::Key << "Multithreading" << YAML::Value << settings.Multithreading;
-	out << YAML::Key << "FastRandom" << YAML::Value << settings.FastRandom;
-	out << YAML::Key << "UseClockTime" << YAML::Value << settings.UseClockTime;
-	out << YAML::Key << "UseFrameIndex" << YAML::Value << settings.UseFrameIndex;
-	out << YAML::Key << "UseRayBounces" << YAML::Value << settings.UseRayBounces;
+	out << YAML::Key << "UseSIMD" << YAML::Value << settings.UseSIMD;
+	out << YAML::Key << "ProgressivePreview" << YAML::Value << settings.ProgressivePreview;
+	out << YAML::Key << "FrameTimeBudget" << YAML::Value << settings.FrameTimeBudget;
+	out << YAML::Key << "AdaptiveSampling" << YAML::Value << settings.AdaptiveSampling;
+	out << YAML::Key << "SampleHeatmap" << YAML::Value << settings.SampleHeatmap;
+	out << YAML::Key << "RussianRoulette" << YAML::Value << settings.RussianRoulette;
+	out << YAML::Key << "RayBinning" << YAML::Value << settings.RayBinning;
 	out << YAML::Key << "RayBounces" << YAML::Value << settings.RayBounces;
+	out << YAML::Key << "PreviewRayBounces" << YAML::Value << settings.PreviewRayBounces;
+	out << YAML::Key << "RussianRouletteDepth" << YAML::Value << settings.RussianRouletteDepth;
+	out << YAML::Key << "Integrator" << YAML::Value << Renderer::GetIntegratorName(settings.IntegratorType);
+	out << YAML::Key << "Sampler" << YAML::Value << Sampler::GetTypeName(settings.SamplerType);
+	out << YAML::Key << "Tonemapper" << YAML::Value << Tonemapper::GetTypeName(settings.TonemapperType);
+	out << YAML::Key << "Seed" << YAML::Value << settings.Seed;
 	out << YAML::Key << "ResolutionScale" << YAML::Value << settings.ResolutionScale;
+	out << YAML::Key << "TargetFrameTime" << YAML::Value << settings.TargetFrameTime;
+	out << YAML::Key << "ConvergenceThreshold" << YAML::Value << settings.ConvergenceThreshold;
+	out << YAML::Key << "TileSize" << YAML::Value << settings.TileSize;
+	out << YAML::Key << "ThreadCount" << YAML::Value << settings.ThreadCount;
 }
 
 bool RendererSettingsSerializer::Deserialize(const std::filesystem::path& filepath) {
@@ -56,14 +69,27 @@ bool RendererSettingsSerializer::Deserialize(const std::filesystem::path& filepa
 }
 
 void RendererSettingsSerializer::DeserializeSettings(YAML::Node& settingsNode) {
-	auto& settings = m_Renderer.GetSettings();
+	auto& settings = m_Settings;
 
-	settings.Accumulate = settingsNode["Accumulate"].as<bool>();
-	settings.Multithreading = settingsNode["Multithreading"].as<bool>();
-	settings.FastRandom = settingsNode["FastRandom"].as<bool>();
-	settings.UseClockTime = settingsNode["UseClockTime"].as<bool>();
-	settings.UseFrameIndex = settingsNode["UseFrameIndex"].as<bool>();
-	settings.UseRayBounces = settingsNode["UseRayBounces"].as<bool>();
-	settings.RayBounces = settingsNode["RayBounces"].as<int>();
-	settings.ResolutionScale = settingsNode["ResolutionScale"].as<int>();
+	settings.Accumulate = settingsNode["Accumulate"].as<bool>(settings.Accumulate);
+	settings.Multithreading = settingsNode["Multithreading"].as<bool>(settings.Multithreading);
+	settings.UseSIMD = settingsNode["UseSIMD"].as<bool>(settings.UseSIMD);
+	settings.ProgressivePreview = settingsNode["ProgressivePreview"].as<bool>(settings.ProgressivePreview);
+	settings.FrameTimeBudget = settingsNode["FrameTimeBudget"].as<bool>(settings.FrameTimeBudget);
+	settings.AdaptiveSampling = settingsNode["AdaptiveSampling"].as<bool>(settings.AdaptiveSampling);
+	settings.SampleHeatmap = settingsNode["SampleHeatmap"].as<bool>(settings.SampleHeatmap);
+	settings.RussianRoulette = settingsNode["RussianRoulette"].as<bool>(settings.RussianRoulette);
+	settings.RayBinning = settingsNode["RayBinning"].as<bool>(settings.RayBinning);
+	settings.RayBounces = settingsNode["RayBounces"].as<int>(settings.RayBounces);
+	settings.PreviewRayBounces = settingsNode["PreviewRayBounces"].as<int>(settings.PreviewRayBounces);
+	settings.RussianRouletteDepth = settingsNode["RussianRouletteDepth"].as<int>(settings.RussianRouletteDepth);
+	Renderer::TryParseIntegrator(settingsNode["Integrator"].as<std::string>(""), settings.IntegratorType);
+	Sampler::TryParseType(settingsNode["Sampler"].as<std::string>(""), settings.SamplerType);
+	Tonemapper::TryParseType(settingsNode["Tonemapper"].as<std::string>(""), settings.TonemapperType);
+	settings.Seed = settingsNode["Seed"].as<int>(settings.Seed);
+	settings.ResolutionScale = settingsNode["ResolutionScale"].as<int>(settings.ResolutionScale);
+	settings.TargetFrameTime = settingsNode["TargetFrameTime"].as<int>(settings.TargetFrameTime);
+	settings.ConvergenceThreshold = settingsNode["ConvergenceThreshold"].as<float>(settings.ConvergenceThreshold);
+	settings.TileSize = settingsNode["TileSize"].as<int>(settings.TileSize);
+	settings.ThreadCount = settingsNode["ThreadCount"].as<int>(settings.ThreadCount);
 }
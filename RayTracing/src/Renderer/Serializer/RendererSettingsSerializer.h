@@ -8,7 +8,7 @@
 
 class RendererSettingsSerializer {
 public:
-	RendererSettingsSerializer(Renderer& renderer);
+	RendererSettingsSerializer(Renderer::Settings& settings);
 
 	bool Serialize(const std::filesystem::path& filepath);
 	bool Deserialize(const std::filesystem::path& filepath);
@@ -16,5 +16,5 @@ private:
 	void SerializeSettings(YAML::Emitter& out, const Renderer::Settings& settings);
 	void DeserializeSettings(YAML::Node& settingsNode);
 private:
-	Renderer& m_Renderer;
+	Renderer::Settings& m_Settings;
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "RendererSettingsStore.h"
+#include "RendererSettingsSerializer.h"
+
+#include <spdlog/spdlog.h>
+
+RendererSettingsStore::RendererSettingsStore(Renderer::Settings& settings, const std::filesystem::path& filepath)
+	: m_Settings(settings), m_Filepath(filepath)
+{
+	RendererSettingsSerializer serializer(m_Settings);
+	if (!serializer.Deserialize(m_Filepath)) {
+		spdlog::warn("RendererSettingsStore - Could not read {0}, using default settings", m_Filepath.string());
+	}
+
+	m_LastSettings = m_Settings;
+	m_WrittenSettings = m_LastSettings;
+
+	m_FileWatcher.Watch(m_Filepath, [this]() {
+		m_FileChanged = true;
+	});
+
+	m_WriterThread = std::thread(&RendererSettingsStore::WriterLoop, this);
+}
+
+RendererSettingsStore::~RendererSettingsStore() {
+	m_FileWatcher.Stop();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_Condition.notify_one();
+
+	m_WriterThread.join();
+}
+
+bool RendererSettingsStore::OnUpdate() {
+	Renderer::Settings& settings = m_Settings;
+	bool reloaded = false;
+
+	if (m_FileChanged.exchange(false)) {
+		// Keys missing from a hand-edited file keep their current values
+		Renderer::Settings fileSettings = settings;
+		RendererSettingsSerializer serializer(fileSettings);
+
+		if (serializer.Deserialize(m_Filepath)) {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// Our own writes come back through the watcher as well, those match what was written last
+			if (fileSettings != m_WrittenSettings) {
+				spdlog::info("RendererSettingsStore - {0} changed on disk, reloading", m_Filepath.string());
+
+				// An external edit wins over changes that have not been saved yet
+				m_SavePending = false;
+				m_WrittenSettings = fileSettings;
+
+				settings = fileSettings;
+				m_LastSettings = fileSettings;
+				reloaded = true;
+			}
+		}
+	}
+
+	if (settings != m_LastSettings) {
+		m_LastSettings = settings;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_PendingSettings = settings;
+			m_SavePending = true;
+			m_SaveTime = std::chrono::steady_clock::now() + s_SaveDelay;
+		}
+		m_Condition.notify_one();
+	}
+
+	return reloaded;
+}
+
+void RendererSettingsStore::WriterLoop() {
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true) {
+		m_Condition.wait(lock, [this]() { return m_SavePending || !m_Running; });
+
+		// Every change pushes m_SaveTime back, so dragging a slider only writes once it is released.
+		// On shutdown the pending settings are written straight away.
+		while (m_Running && m_SavePending && std::chrono::steady_clock::now() < m_SaveTime) {
+			m_Condition.wait_until(lock, m_SaveTime);
+		}
+
+		if (m_SavePending) {
+			Renderer::Settings settings = m_PendingSettings;
+			m_SavePending = false;
+			m_WrittenSettings = settings;
+
+			lock.unlock();
+			Write(settings);
+			lock.lock();
+		}
+
+		if (!m_Running) {
+			break;
+		}
+	}
+}
+
+void RendererSettingsStore::Write(const Renderer::Settings& settings) {
+	// Write next to the real file and rename over it, so readers never see a half written file
+	std::filesystem::path temporaryPath = m_Filepath;
+	temporaryPath += ".tmp";
+
+	Renderer::Settings settingsCopy = settings;
+	RendererSettingsSerializer serializer(settingsCopy);
+	serializer.Serialize(temporaryPath);
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, m_Filepath, error);
+	if (error) {
+		spdlog::warn("RendererSettingsStore - Could not write {0}: {1}", m_Filepath.string(), error.message());
+	}
+}
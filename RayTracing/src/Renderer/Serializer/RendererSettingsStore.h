@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../Renderer.h"
+
+#include "../../Utils/FileWatcher.h"
+
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+
+// Keeps Renderer::Settings and its YAML file in sync. The file is read once on construction, after
+// that changes to the settings are written back on a background thread once they stop changing for
+// s_SaveDelay, and edits made to the file outside the app are picked up through a FileWatcher.
+class RendererSettingsStore {
+public:
+	RendererSettingsStore(Renderer::Settings& settings, const std::filesystem::path& filepath);
+	~RendererSettingsStore();
+
+	// Call once per frame on the main thread. Queues a save if the settings changed since the last call
+	// and applies external edits to the file. Returns true if the settings were reloaded from disk.
+	bool OnUpdate();
+private:
+	void WriterLoop();
+	void Write(const Renderer::Settings& settings);
+private:
+	static constexpr std::chrono::milliseconds s_SaveDelay{ 500 };
+
+	Renderer::Settings& m_Settings;
+	std::filesystem::path m_Filepath;
+
+	// Settings as of the previous OnUpdate, only touched on the main thread
+	Renderer::Settings m_LastSettings;
+
+	std::thread m_WriterThread;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+
+	// Guarded by m_Mutex
+	bool m_Running = true;
+	bool m_SavePending = false;
+	std::chrono::steady_clock::time_point m_SaveTime;
+	Renderer::Settings m_PendingSettings;
+	Renderer::Settings m_WrittenSettings; // What the file holds, so our own writes are not mistaken for external edits
+
+	FileWatcher m_FileWatcher;
+	std::atomic<bool> m_FileChanged = false;
+};
@@ -0,0 +1,300 @@
+#include "SphereIntersector.h"
+
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define RT_X86
+	#include <immintrin.h>
+
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define RT_TARGET(features)
+	#else
+		#include <cpuid.h>
+		#define RT_TARGET(features) __attribute__((target(features)))
+	#endif
+#endif
+
+// All kernels evaluate the quadratic with the exact same operation order as the
+// original scalar TraceRay (no FMA, same association), so every kernel returns
+// bit-identical hit distances and the same sphere on ties (lowest index wins).
+
+namespace Utils {
+	static int IntersectScalar(const SphereIntersector::Data& data, uint32_t offset, uint32_t count, const Ray& ray, float& hitDistance) {
+		int closest = -1;
+
+		float a = glm::dot(ray.Direction, ray.Direction);
+
+		for (uint32_t i = offset; i < offset + count; i++) {
+			glm::vec3 origin = ray.Origin - glm::vec3(data.CenterX[i], data.CenterY[i], data.CenterZ[i]);
+
+			float b = 2.0f * glm::dot(origin, ray.Direction);
+			float c = glm::dot(origin, origin) - data.RadiusSquared[i];
+
+			float discriminant = b * b - 4.0f * a * c;
+			if (discriminant < 0.0f) {
+				continue;
+			}
+
+			float closestT = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+			if (closestT > 0.0f && closestT < hitDistance) {
+				hitDistance = closestT;
+				closest = (int)i;
+			}
+		}
+
+		return closest;
+	}
+
+#ifdef RT_X86
+	template<int LaneCount>
+	static int ReduceLanes(const float* laneT, const int* laneIndex, float& hitDistance) {
+		int closest = -1;
+
+		for (int lane = 0; lane < LaneCount; lane++) {
+			if (laneIndex[lane] < 0) {
+				continue;
+			}
+
+			if (laneT[lane] < hitDistance || (laneT[lane] == hitDistance && laneIndex[lane] < closest)) {
+				hitDistance = laneT[lane];
+				closest = laneIndex[lane];
+			}
+		}
+
+		return closest;
+	}
+
+	RT_TARGET("sse4.1")
+	static int IntersectSSE41(const SphereIntersector::Data& data, uint32_t offset, uint32_t count, const Ray& ray, float& hitDistance) {
+		float a = glm::dot(ray.Direction, ray.Direction);
+
+		const __m128 originX = _mm_set1_ps(ray.Origin.x);
+		const __m128 originY = _mm_set1_ps(ray.Origin.y);
+		const __m128 originZ = _mm_set1_ps(ray.Origin.z);
+		const __m128 directionX = _mm_set1_ps(ray.Direction.x);
+		const __m128 directionY = _mm_set1_ps(ray.Direction.y);
+		const __m128 directionZ = _mm_set1_ps(ray.Direction.z);
+
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 fourA = _mm_set1_ps(4.0f * a);
+		const __m128 twoA = _mm_set1_ps(2.0f * a);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+
+		__m128 bestT = _mm_set1_ps(hitDistance);
+		__m128i bestIndex = _mm_set1_epi32(-1);
+		__m128i index = _mm_setr_epi32((int)offset, (int)offset + 1, (int)offset + 2, (int)offset + 3);
+		const __m128i step = _mm_set1_epi32(4);
+
+		for (uint32_t i = offset; i < offset + count; i += 4) {
+			__m128 ox = _mm_sub_ps(originX, _mm_load_ps(&data.CenterX[i]));
+			__m128 oy = _mm_sub_ps(originY, _mm_load_ps(&data.CenterY[i]));
+			__m128 oz = _mm_sub_ps(originZ, _mm_load_ps(&data.CenterZ[i]));
+
+			__m128 originDotDirection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, directionX), _mm_mul_ps(oy, directionY)), _mm_mul_ps(oz, directionZ));
+			__m128 originDotOrigin = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+
+			__m128 b = _mm_mul_ps(two, originDotDirection);
+			__m128 c = _mm_sub_ps(originDotOrigin, _mm_load_ps(&data.RadiusSquared[i]));
+
+			// A negative discriminant (or a NaN padding sphere) turns t into NaN, which fails both comparisons
+			__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(fourA, c));
+			__m128 t = _mm_div_ps(_mm_sub_ps(_mm_xor_ps(b, signMask), _mm_sqrt_ps(discriminant)), twoA);
+
+			__m128 mask = _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, bestT));
+			bestT = _mm_blendv_ps(bestT, t, mask);
+			bestIndex = _mm_blendv_epi8(bestIndex, index, _mm_castps_si128(mask));
+
+			index = _mm_add_epi32(index, step);
+		}
+
+		alignas(16) float laneT[4];
+		alignas(16) int laneIndex[4];
+		_mm_store_ps(laneT, bestT);
+		_mm_store_si128((__m128i*)laneIndex, bestIndex);
+
+		return ReduceLanes<4>(laneT, laneIndex, hitDistance);
+	}
+
+	RT_TARGET("avx2")
+	static int IntersectAVX2(const SphereIntersector::Data& data, uint32_t offset, uint32_t count, const Ray& ray, float& hitDistance) {
+		float a = glm::dot(ray.Direction, ray.Direction);
+
+		const __m256 originX = _mm256_set1_ps(ray.Origin.x);
+		const __m256 originY = _mm256_set1_ps(ray.Origin.y);
+		const __m256 originZ = _mm256_set1_ps(ray.Origin.z);
+		const __m256 directionX = _mm256_set1_ps(ray.Direction.x);
+		const __m256 directionY = _mm256_set1_ps(ray.Direction.y);
+		const __m256 directionZ = _mm256_set1_ps(ray.Direction.z);
+
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 fourA = _mm256_set1_ps(4.0f * a);
+		const __m256 twoA = _mm256_set1_ps(2.0f * a);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+		__m256 bestT = _mm256_set1_ps(hitDistance);
+		__m256i bestIndex = _mm256_set1_epi32(-1);
+		__m256i index = _mm256_add_epi32(_mm256_set1_epi32((int)offset), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		const __m256i step = _mm256_set1_epi32(8);
+
+		for (uint32_t i = offset; i < offset + count; i += 8) {
+			__m256 ox = _mm256_sub_ps(originX, _mm256_load_ps(&data.CenterX[i]));
+			__m256 oy = _mm256_sub_ps(originY, _mm256_load_ps(&data.CenterY[i]));
+			__m256 oz = _mm256_sub_ps(originZ, _mm256_load_ps(&data.CenterZ[i]));
+
+			__m256 originDotDirection = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, directionX), _mm256_mul_ps(oy, directionY)), _mm256_mul_ps(oz, directionZ));
+			__m256 originDotOrigin = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz));
+
+			__m256 b = _mm256_mul_ps(two, originDotDirection);
+			__m256 c = _mm256_sub_ps(originDotOrigin, _mm256_load_ps(&data.RadiusSquared[i]));
+
+			__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(fourA, c));
+			__m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_xor_ps(b, signMask), _mm256_sqrt_ps(discriminant)), twoA);
+
+			__m256 mask = _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, bestT, _CMP_LT_OQ));
+			bestT = _mm256_blendv_ps(bestT, t, mask);
+			bestIndex = _mm256_blendv_epi8(bestIndex, index, _mm256_castps_si256(mask));
+
+			index = _mm256_add_epi32(index, step);
+		}
+
+		alignas(32) float laneT[8];
+		alignas(32) int laneIndex[8];
+		_mm256_store_ps(laneT, bestT);
+		_mm256_store_si256((__m256i*)laneIndex, bestIndex);
+
+		return ReduceLanes<8>(laneT, laneIndex, hitDistance);
+	}
+
+	static void CPUID(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#ifdef _MSC_VER
+		__cpuidex((int*)registers, (int)leaf, (int)subleaf);
+#else
+		__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	static uint64_t XGETBV() {
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((uint64_t)edx << 32) | eax;
+#endif
+	}
+#endif
+}
+
+SphereIntersector::SphereIntersector()
+	: m_Kernel(GetBestKernel())
+{}
+
+SphereIntersector::Kernel SphereIntersector::GetBestKernel() {
+	static const Kernel bestKernel = []() {
+#ifdef RT_X86
+		uint32_t registers[4];
+
+		Utils::CPUID(0, 0, registers);
+		uint32_t maxLeaf = registers[0];
+
+		Utils::CPUID(1, 0, registers);
+		bool sse41 = (registers[2] & (1u << 19)) != 0;
+		bool osxsave = (registers[2] & (1u << 27)) != 0;
+		bool avx = (registers[2] & (1u << 28)) != 0;
+
+		// AVX registers are only usable when the OS saves the YMM state on context switches
+		if (maxLeaf >= 7 && osxsave && avx && (Utils::XGETBV() & 0x6) == 0x6) {
+			Utils::CPUID(7, 0, registers);
+			if (registers[1] & (1u << 5)) {
+				return Kernel::AVX2;
+			}
+		}
+
+		if (sse41) {
+			return Kernel::SSE41;
+		}
+#endif
+		return Kernel::Scalar;
+	}();
+
+	return bestKernel;
+}
+
+const char* SphereIntersector::GetKernelName(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::SSE41: return "SSE4.1";
+		case Kernel::AVX2: return "AVX2";
+		default: return "Scalar";
+	}
+}
+
+void SphereIntersector::Build(const BVH& bvh, const std::vector<Sphere>& spheres, const std::vector<uint32_t>& sphereIndices) {
+	m_Data.CenterX.clear();
+	m_Data.CenterY.clear();
+	m_Data.CenterZ.clear();
+	m_Data.RadiusSquared.clear();
+	m_Data.SphereIndices.clear();
+
+	m_LeafOffsets.assign(sphereIndices.size(), 0);
+
+	size_t capacity = sphereIndices.size() * 2 + s_LaneCount;
+	m_Data.CenterX.reserve(capacity);
+	m_Data.CenterY.reserve(capacity);
+	m_Data.CenterZ.reserve(capacity);
+	m_Data.RadiusSquared.reserve(capacity);
+	m_Data.SphereIndices.reserve(capacity);
+
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+
+	for (const BVHNode& node : bvh.GetNodes()) {
+		if (!node.IsLeaf()) {
+			continue;
+		}
+
+		m_LeafOffsets[node.LeftFirst] = (uint32_t)m_Data.SphereIndices.size();
+
+		for (uint32_t i = 0; i < node.PrimitiveCount; i++) {
+			uint32_t sphereIndex = sphereIndices[node.LeftFirst + i];
+			const Sphere& sphere = spheres[sphereIndex];
+
+			m_Data.CenterX.push_back(sphere.Position.x);
+			m_Data.CenterY.push_back(sphere.Position.y);
+			m_Data.CenterZ.push_back(sphere.Position.z);
+			m_Data.RadiusSquared.push_back(sphere.Radius * sphere.Radius);
+			m_Data.SphereIndices.push_back((int)sphereIndex);
+		}
+
+		while (m_Data.SphereIndices.size() % s_LaneCount != 0) {
+			m_Data.CenterX.push_back(nan);
+			m_Data.CenterY.push_back(nan);
+			m_Data.CenterZ.push_back(nan);
+			m_Data.RadiusSquared.push_back(nan);
+			m_Data.SphereIndices.push_back(-1);
+		}
+	}
+}
+
+int SphereIntersector::Intersect(const Ray& ray, uint32_t firstPrimitive, uint32_t primitiveCount, float& hitDistance) const {
+	uint32_t offset = m_LeafOffsets[firstPrimitive];
+
+	int closest = -1;
+
+	switch (m_Kernel) {
+#ifdef RT_X86
+		case Kernel::AVX2:
+			closest = Utils::IntersectAVX2(m_Data, offset, (primitiveCount + 7) & ~7u, ray, hitDistance);
+			break;
+		case Kernel::SSE41:
+			closest = Utils::IntersectSSE41(m_Data, offset, (primitiveCount + 3) & ~3u, ray, hitDistance);
+			break;
+#endif
+		default:
+			closest = Utils::IntersectScalar(m_Data, offset, primitiveCount, ray, hitDistance);
+			break;
+	}
+
+	return closest < 0 ? -1 : m_Data.SphereIndices[closest];
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Ray.h"
+#include "BVH.h"
+
+#include "../Scene/Scene.h"
+#include "../Utils/AlignedAllocator.h"
+
+#include <vector>
+#include <cstdint>
+
+// Structure-of-arrays copy of the spheres referenced by a BVH, laid out leaf by leaf.
+// Every leaf starts on a 32 byte boundary and is padded with NaN spheres to a multiple
+// of s_LaneCount, so the SIMD kernels can use aligned loads and never need a tail loop.
+class SphereIntersector {
+public:
+	enum class Kernel {
+		Scalar = 0,
+		SSE41,
+		AVX2
+	};
+public:
+	SphereIntersector();
+
+	// sphereIndices maps BVH primitive order to indices in spheres
+	void Build(const BVH& bvh, const std::vector<Sphere>& spheres, const std::vector<uint32_t>& sphereIndices);
+
+	// Tests the ray against the spheres of the leaf starting at firstPrimitive.
+	// Returns the scene index of the closest sphere hit before hitDistance (and shrinks hitDistance), or -1.
+	int Intersect(const Ray& ray, uint32_t firstPrimitive, uint32_t primitiveCount, float& hitDistance) const;
+
+	void SetUseSIMD(bool useSIMD) { m_Kernel = useSIMD ? GetBestKernel() : Kernel::Scalar; }
+	Kernel GetKernel() const { return m_Kernel; }
+
+	// Widest kernel supported by this CPU, detected once with CPUID
+	static Kernel GetBestKernel();
+	static const char* GetKernelName(Kernel kernel);
+
+	// Number of spheres the kernel tests at once, used as the BVH leaf size
+	static uint32_t GetKernelWidth(Kernel kernel) { return kernel == Kernel::AVX2 ? 8 : 4; }
+public:
+	struct Data {
+		std::vector<float, AlignedAllocator<float, 32>> CenterX;
+		std::vector<float, AlignedAllocator<float, 32>> CenterY;
+		std::vector<float, AlignedAllocator<float, 32>> CenterZ;
+		std::vector<float, AlignedAllocator<float, 32>> RadiusSquared;
+
+		// Scene index of every packed sphere, -1 for padding
+		std::vector<int> SphereIndices;
+	};
+private:
+	static constexpr uint32_t s_LaneCount = 8;
+
+	Data m_Data;
+
+	// Offset into m_Data of the leaf whose first BVH primitive is the index
+	std::vector<uint32_t> m_LeafOffsets;
+
+	Kernel m_Kernel = Kernel::Scalar;
+};
@@ -0,0 +1,170 @@
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <algorithm>
+
+ThreadPool::~ThreadPool() {
+	Shutdown();
+}
+
+void ThreadPool::Resize(uint32_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	if (threadCount == GetThreadCount()) {
+		return;
+	}
+
+	Shutdown();
+
+	m_Queues.clear();
+	for (uint32_t i = 0; i < threadCount; i++) {
+		m_Queues.push_back(std::make_unique<TaskQueue>());
+	}
+
+	m_ThreadUtilization.assign(threadCount, 0.0f);
+	m_DispatchTime = 0.0f;
+
+	m_Running = true;
+
+	// Thread 0 is whoever calls Dispatch
+	for (uint32_t i = 1; i < threadCount; i++) {
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i, m_Generation);
+	}
+}
+
+void ThreadPool::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers) {
+		worker.join();
+	}
+
+	m_Workers.clear();
+}
+
+void ThreadPool::Dispatch(uint32_t taskCount, const Task& task) {
+	if (m_Queues.empty()) {
+		Resize(0);
+	}
+
+	uint32_t threadCount = GetThreadCount();
+
+	// Contiguous blocks keep neighbouring tasks (and their cache lines) on the same thread
+	for (uint32_t i = 0; i < threadCount; i++) {
+		TaskQueue& queue = *m_Queues[i];
+
+		uint32_t begin = (uint32_t)((uint64_t)taskCount * i / threadCount);
+		uint32_t end = (uint32_t)((uint64_t)taskCount * (i + 1) / threadCount);
+		for (uint32_t taskIndex = begin; taskIndex < end; taskIndex++) {
+			queue.Tasks.push_back(taskIndex);
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Task = &task;
+		m_PendingWorkers = (uint32_t)m_Workers.size();
+		m_Generation++;
+	}
+
+	m_WorkAvailable.notify_all();
+
+	RunTasks(0);
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkFinished.wait(lock, [this]() { return m_PendingWorkers == 0; });
+		m_Task = nullptr;
+	}
+
+	m_DispatchTime += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	for (uint32_t i = 0; i < threadCount; i++) {
+		m_ThreadUtilization[i] = m_DispatchTime > 0.0f ? std::min(m_Queues[i]->BusyTime / m_DispatchTime, 1.0f) : 0.0f;
+	}
+}
+
+void ThreadPool::ResetUtilization() {
+	// Workers only touch their busy time inside Dispatch
+	for (std::unique_ptr<TaskQueue>& queue : m_Queues) {
+		queue->BusyTime = 0.0f;
+	}
+
+	m_DispatchTime = 0.0f;
+	std::fill(m_ThreadUtilization.begin(), m_ThreadUtilization.end(), 0.0f);
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex, uint64_t generation) {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [this, generation]() { return !m_Running || m_Generation != generation; });
+
+			if (!m_Running) {
+				return;
+			}
+
+			generation = m_Generation;
+		}
+
+		RunTasks(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_PendingWorkers--;
+		}
+
+		m_WorkFinished.notify_one();
+	}
+}
+
+void ThreadPool::RunTasks(uint32_t threadIndex) {
+	TaskQueue& queue = *m_Queues[threadIndex];
+
+	uint32_t taskIndex;
+	while (PopTask(threadIndex, taskIndex) || StealTask(threadIndex, taskIndex)) {
+		auto start = std::chrono::steady_clock::now();
+		(*m_Task)(taskIndex, threadIndex);
+		queue.BusyTime += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+bool ThreadPool::PopTask(uint32_t threadIndex, uint32_t& taskIndex) {
+	TaskQueue& queue = *m_Queues[threadIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+
+	if (queue.Tasks.empty()) {
+		return false;
+	}
+
+	taskIndex = queue.Tasks.front();
+	queue.Tasks.pop_front();
+	return true;
+}
+
+bool ThreadPool::StealTask(uint32_t threadIndex, uint32_t& taskIndex) {
+	uint32_t threadCount = GetThreadCount();
+
+	for (uint32_t i = 1; i < threadCount; i++) {
+		TaskQueue& victim = *m_Queues[(threadIndex + i) % threadCount];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+
+		if (victim.Tasks.empty()) {
+			continue;
+		}
+
+		taskIndex = victim.Tasks.back();
+		victim.Tasks.pop_back();
+		return true;
+	}
+
+	return false;
+}
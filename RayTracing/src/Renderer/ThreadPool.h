@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+// Fixed-size pool of worker threads with one task deque per thread.
+// Every Dispatch hands out a contiguous block of task indices to each thread,
+// threads that run out of work steal from the back of the other deques.
+class ThreadPool {
+public:
+	using Task = std::function<void(uint32_t taskIndex, uint32_t threadIndex)>;
+public:
+	ThreadPool() = default;
+	~ThreadPool();
+
+	// A thread count of 0 uses every hardware thread. The calling thread counts as one of them.
+	void Resize(uint32_t threadCount);
+	uint32_t GetThreadCount() const { return (uint32_t)m_Queues.size(); }
+
+	// Runs task(i, thread) for every i in [0, taskCount) and blocks until all of them completed
+	void Dispatch(uint32_t taskCount, const Task& task);
+
+	// Fraction of the time in dispatches since the last ResetUtilization each thread spent running tasks,
+	// so a frame made of several dispatches is measured as a whole
+	void ResetUtilization();
+	const std::vector<float>& GetThreadUtilization() const { return m_ThreadUtilization; }
+private:
+	struct alignas(64) TaskQueue {
+		std::mutex Mutex;
+		std::deque<uint32_t> Tasks;
+		float BusyTime = 0.0f;
+	};
+
+	void Shutdown();
+	void WorkerLoop(uint32_t threadIndex, uint64_t generation);
+	void RunTasks(uint32_t threadIndex);
+
+	bool PopTask(uint32_t threadIndex, uint32_t& taskIndex);
+	bool StealTask(uint32_t threadIndex, uint32_t& taskIndex);
+private:
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<TaskQueue>> m_Queues;
+	std::vector<float> m_ThreadUtilization;
+	float m_DispatchTime = 0.0f; // Seconds, since the last ResetUtilization
+
+	const Task* m_Task = nullptr;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkFinished;
+
+	uint64_t m_Generation = 0;
+	uint32_t m_PendingWorkers = 0;
+	bool m_Running = false;
+};
@@ -0,0 +1,181 @@
+#include "Tonemapper.h"
+#include "SphereIntersector.h"
+
+#include <array>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define RT_X86
+	#include <immintrin.h>
+
+	#ifdef _MSC_VER
+		#define RT_TARGET(features)
+	#else
+		#define RT_TARGET(features) __attribute__((target(features)))
+	#endif
+#endif
+
+// The SIMD path does the exact same float operations in the same order as the scalar path
+// (no FMA, clamping written as max then min), so both produce identical images.
+
+namespace Utils {
+	// Linear [0, 1] to 8 bit sRGB, fine enough that neighbouring entries never skip an output value
+	static constexpr uint32_t s_SRGBTableSize = 4096;
+
+	static const uint8_t* GetSRGBTable() {
+		static const std::array<uint8_t, s_SRGBTableSize> table = []() {
+			std::array<uint8_t, s_SRGBTableSize> result;
+			for (uint32_t i = 0; i < s_SRGBTableSize; i++) {
+				double linear = (double)i / (double)(s_SRGBTableSize - 1);
+				double encoded = linear <= 0.0031308 ? 12.92 * linear : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+				result[i] = (uint8_t)(encoded * 255.0 + 0.5);
+			}
+			return result;
+		}();
+
+		return table.data();
+	}
+
+	static constexpr float s_ACESA = 2.51f;
+	static constexpr float s_ACESB = 0.03f;
+	static constexpr float s_ACESC = 2.43f;
+	static constexpr float s_ACESD = 0.59f;
+	static constexpr float s_ACESE = 0.14f;
+
+	static float ACES(float x) {
+		float numerator = x * (s_ACESA * x + s_ACESB);
+		float denominator = x * (s_ACESC * x + s_ACESD) + s_ACESE;
+		return numerator / denominator;
+	}
+
+	static void ResolveScalar(Tonemapper::Type type, const float* accumulation, uint32_t* image, size_t pixelCount, float scale) {
+		const bool encode = type != Tonemapper::Type::None;
+		const float quantize = encode ? (float)(s_SRGBTableSize - 1) : 255.0f;
+		const float bias = encode ? 0.5f : 0.0f;
+		const uint8_t* table = GetSRGBTable();
+
+		for (size_t i = 0; i < pixelCount; i++) {
+			uint32_t pixel = 0xff000000;
+
+			for (int channel = 0; channel < 3; channel++) {
+				float value = accumulation[i * 3 + channel] * scale;
+				if (type == Tonemapper::Type::ACES) {
+					value = ACES(value);
+				}
+
+				value = value > 0.0f ? value : 0.0f;
+				value = value < 1.0f ? value : 1.0f;
+
+				int32_t quantized = (int32_t)(value * quantize + bias);
+				pixel |= (uint32_t)(encode ? table[quantized] : quantized) << (channel * 8);
+			}
+
+			image[i] = pixel;
+		}
+	}
+
+#ifdef RT_X86
+	RT_TARGET("sse4.1")
+	static void ResolveSSE41(Tonemapper::Type type, const float* accumulation, uint32_t* image, size_t pixelCount, float scale) {
+		const bool encode = type != Tonemapper::Type::None;
+		const uint8_t* table = GetSRGBTable();
+
+		const __m128 scaleV = _mm_set1_ps(scale);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 quantize = _mm_set1_ps(encode ? (float)(s_SRGBTableSize - 1) : 255.0f);
+		const __m128 bias = _mm_set1_ps(encode ? 0.5f : 0.0f);
+
+		const __m128 acesA = _mm_set1_ps(s_ACESA);
+		const __m128 acesB = _mm_set1_ps(s_ACESB);
+		const __m128 acesC = _mm_set1_ps(s_ACESC);
+		const __m128 acesD = _mm_set1_ps(s_ACESD);
+		const __m128 acesE = _mm_set1_ps(s_ACESE);
+
+		// 12 packed RGB bytes to 4 RGBA pixels, the alpha bytes are filled in afterwards
+		const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+		size_t i = 0;
+		for (; i + 4 <= pixelCount; i += 4) {
+			// Channels are independent, so the 12 floats of 4 pixels are processed without deinterleaving
+			__m128i quantized[3];
+			for (int j = 0; j < 3; j++) {
+				__m128 value = _mm_mul_ps(_mm_loadu_ps(accumulation + i * 3 + j * 4), scaleV);
+
+				if (type == Tonemapper::Type::ACES) {
+					__m128 numerator = _mm_mul_ps(value, _mm_add_ps(_mm_mul_ps(acesA, value), acesB));
+					__m128 denominator = _mm_add_ps(_mm_mul_ps(value, _mm_add_ps(_mm_mul_ps(acesC, value), acesD)), acesE);
+					value = _mm_div_ps(numerator, denominator);
+				}
+
+				// max returns the second operand for NaN, so NaNs end up black like in the scalar path
+				value = _mm_min_ps(_mm_max_ps(value, zero), one);
+				quantized[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, quantize), bias));
+			}
+
+			__m128i bytes;
+			if (encode) {
+				alignas(16) int32_t indices[12];
+				alignas(16) uint8_t encoded[16] = {};
+				_mm_store_si128((__m128i*)indices + 0, quantized[0]);
+				_mm_store_si128((__m128i*)indices + 1, quantized[1]);
+				_mm_store_si128((__m128i*)indices + 2, quantized[2]);
+
+				for (int j = 0; j < 12; j++) {
+					encoded[j] = table[indices[j]];
+				}
+
+				bytes = _mm_load_si128((const __m128i*)encoded);
+			} else {
+				__m128i words = _mm_packus_epi32(quantized[0], quantized[1]);
+				__m128i lastWords = _mm_packus_epi32(quantized[2], quantized[2]);
+				bytes = _mm_packus_epi16(words, lastWords);
+			}
+
+			__m128i pixels = _mm_or_si128(_mm_shuffle_epi8(bytes, expand), alpha);
+			_mm_storeu_si128((__m128i*)(image + i), pixels);
+		}
+
+		ResolveScalar(type, accumulation + i * 3, image + i, pixelCount - i, scale);
+	}
+#endif
+}
+
+void Tonemapper::Resolve(Type type, const glm::vec3* accumulation, uint32_t* image, size_t pixelCount, float scale, bool useSIMD) {
+	static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "The resolve kernels read the accumulation buffer as a flat float array");
+	const float* data = (const float*)accumulation;
+
+#ifdef RT_X86
+	if (useSIMD && SphereIntersector::GetBestKernel() != SphereIntersector::Kernel::Scalar) {
+		Utils::ResolveSSE41(type, data, image, pixelCount, scale);
+		return;
+	}
+#endif
+
+	Utils::ResolveScalar(type, data, image, pixelCount, scale);
+}
+
+const char* Tonemapper::GetTypeName(Type type) {
+	switch (type) {
+		case Type::None:
+			return "None";
+		case Type::sRGB:
+			return "sRGB";
+		case Type::ACES:
+			return "ACES";
+	}
+
+	return "Unknown";
+}
+
+bool Tonemapper::TryParseType(const std::string& name, Type& type) {
+	for (Type candidate : { Type::None, Type::sRGB, Type::ACES }) {
+		if (name == GetTypeName(candidate)) {
+			type = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Turns accumulated linear radiance into the RGBA8 image that gets displayed or written to disk.
+// The whole image is resolved in one pass after tracing, 4 pixels at a time with SSE4.1 when available.
+class Tonemapper {
+public:
+	enum class Type {
+		None = 0, // Linear values clamped to [0, 1], how the renderer always looked
+		sRGB,     // Clamped and encoded with the sRGB transfer function
+		ACES      // ACES filmic curve (Narkowicz fit), then sRGB encoded
+	};
+public:
+	// accumulation holds the sum of all samples, scale is 1 / sample count. Alpha is always 255.
+	static void Resolve(Type type, const glm::vec3* accumulation, uint32_t* image, size_t pixelCount, float scale, bool useSIMD);
+
+	static const char* GetTypeName(Type type);
+	static bool TryParseType(const std::string& name, Type& type);
+};
@@ -0,0 +1,95 @@
+#include "TriangleIntersector.h"
+
+#include <utility>
+
+namespace Utils {
+	// Twice the signed area of the 2D triangle (origin, a, b), in double precision when float cannot tell the sign
+	static float EdgeFunction(float ax, float ay, float bx, float by) {
+		float result = ax * by - ay * bx;
+		if (result == 0.0f) {
+			result = (float)((double)ax * (double)by - (double)ay * (double)bx);
+		}
+
+		return result;
+	}
+}
+
+void TriangleIntersector::Build(const BVH& bvh, const MeshGeometry& geometry) {
+	const std::vector<uint32_t>& primitiveIndices = bvh.GetPrimitiveIndices();
+
+	m_Vertices.resize(primitiveIndices.size() * 3);
+	m_TriangleIndices.resize(primitiveIndices.size());
+
+	for (size_t i = 0; i < primitiveIndices.size(); i++) {
+		uint32_t triangle = primitiveIndices[i];
+		m_TriangleIndices[i] = triangle;
+
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			m_Vertices[i * 3 + corner] = geometry.Positions[geometry.Indices[triangle * 3 + corner]];
+		}
+	}
+}
+
+TriangleIntersector::PreparedRay TriangleIntersector::Prepare(const Ray& ray) {
+	PreparedRay prepared;
+	prepared.Origin = ray.Origin;
+
+	glm::vec3 absDirection = glm::abs(ray.Direction);
+	prepared.AxisZ = absDirection.x > absDirection.y ? (absDirection.x > absDirection.z ? 0 : 2) : (absDirection.y > absDirection.z ? 1 : 2);
+	prepared.AxisX = (prepared.AxisZ + 1) % 3;
+	prepared.AxisY = (prepared.AxisX + 1) % 3;
+
+	// Keeps the winding of the triangles, so the sign of the edge functions means the same for every ray
+	if (ray.Direction[prepared.AxisZ] < 0.0f) {
+		std::swap(prepared.AxisX, prepared.AxisY);
+	}
+
+	prepared.Shear.x = ray.Direction[prepared.AxisX] / ray.Direction[prepared.AxisZ];
+	prepared.Shear.y = ray.Direction[prepared.AxisY] / ray.Direction[prepared.AxisZ];
+	prepared.Shear.z = 1.0f / ray.Direction[prepared.AxisZ];
+
+	return prepared;
+}
+
+int TriangleIntersector::Intersect(const PreparedRay& ray, uint32_t firstPrimitive, uint32_t primitiveCount, float& hitDistance) const {
+	int closest = -1;
+
+	const int kx = ray.AxisX, ky = ray.AxisY, kz = ray.AxisZ;
+
+	for (uint32_t i = firstPrimitive; i < firstPrimitive + primitiveCount; i++) {
+		const glm::vec3 a = m_Vertices[i * 3 + 0] - ray.Origin;
+		const glm::vec3 b = m_Vertices[i * 3 + 1] - ray.Origin;
+		const glm::vec3 c = m_Vertices[i * 3 + 2] - ray.Origin;
+
+		// Vertices in the sheared space, where the ray starts at the origin and points along +Z
+		float ax = a[kx] - ray.Shear.x * a[kz];
+		float ay = a[ky] - ray.Shear.y * a[kz];
+		float bx = b[kx] - ray.Shear.x * b[kz];
+		float by = b[ky] - ray.Shear.y * b[kz];
+		float cx = c[kx] - ray.Shear.x * c[kz];
+		float cy = c[ky] - ray.Shear.y * c[kz];
+
+		float u = Utils::EdgeFunction(cx, cy, bx, by);
+		float v = Utils::EdgeFunction(ax, ay, cx, cy);
+		float w = Utils::EdgeFunction(bx, by, ax, ay);
+
+		// Inside when all three have the same sign, either sign since triangles are two sided
+		if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f)) {
+			continue;
+		}
+
+		float determinant = u + v + w;
+		if (determinant == 0.0f) {
+			continue;
+		}
+
+		// Distance along the (not necessarily normalized) ray direction, from the barycentric weighted depths
+		float t = (u * ray.Shear.z * a[kz] + v * ray.Shear.z * b[kz] + w * ray.Shear.z * c[kz]) / determinant;
+		if (t > 0.0f && t < hitDistance) {
+			hitDistance = t;
+			closest = (int)m_TriangleIndices[i];
+		}
+	}
+
+	return closest;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Ray.h"
+#include "BVH.h"
+
+#include "../Scene/Scene.h"
+
+#include <vector>
+#include <cstdint>
+
+// Copy of the triangles referenced by a BVH, three vertices per triangle in BVH primitive order, so the
+// triangles of a leaf are next to each other in memory instead of scattered through the index buffer.
+//
+// The test is the watertight one by Woop, Benthin and Wald (2013). The ray is sheared so it points along
+// +Z and the triangle is tested in 2D, with edge functions that are evaluated the same way for both
+// triangles sharing an edge. A ray through a shared edge or vertex hits at least one of them, it never
+// slips through the gap between two triangles of a closed mesh.
+class TriangleIntersector {
+public:
+	// The part of the test that only depends on the ray, shared by all triangles it is tested against
+	struct PreparedRay {
+		glm::vec3 Origin;
+		glm::vec3 Shear; // x and y shear towards the dominant axis, z scales it to the ray's length
+		int AxisX, AxisY, AxisZ; // AxisZ is the dominant axis of the direction
+	};
+public:
+	TriangleIntersector() = default;
+
+	void Build(const BVH& bvh, const MeshGeometry& geometry);
+
+	static PreparedRay Prepare(const Ray& ray);
+
+	// Tests the ray against the triangles of the leaf starting at firstPrimitive. Returns the index of the
+	// closest triangle in the mesh hit before hitDistance (and shrinks hitDistance), or -1. Triangles are two sided.
+	int Intersect(const PreparedRay& ray, uint32_t firstPrimitive, uint32_t primitiveCount, float& hitDistance) const;
+private:
+	std::vector<glm::vec3> m_Vertices;
+	std::vector<uint32_t> m_TriangleIndices; // Mesh triangle of every packed triangle
+};
@@ -1,10 +1,8 @@
 #include "Camera.h"
 
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/quaternion.hpp>
-#include <glm/gtx/quaternion.hpp>
+#include "../Utils/Profiler.h"
 
-#include "Walnut/Input/Input.h"
+#include <glm/gtc/matrix_transform.hpp>
 
 Camera::Camera(float verticalFOV, float nearClip, float farClip) {
 	m_Data.VerticalFOV = verticalFOV;
@@ -13,92 +11,42 @@ Camera::Camera(float verticalFOV, float nearClip, float farClip) {
 	m_Data.Position = glm::vec3(0.0f, 0.0f, 6.0f);
 }
 
-bool Camera::OnUpdate(const float& ts, const bool& viewportFocused) {
-	glm::vec2 mousePos = Walnut::Input::GetMousePosition();
-	glm::vec2 delta = (mousePos - m_LastMousePosition) * 0.002f;
-	m_LastMousePosition = mousePos;
+void Camera::OnResize(uint32_t width, uint32_t height) {
+	if (width == m_ViewportWidth && height == m_ViewportHeight)
+		return;
 
-	if (m_ViewportWidth != 0 && m_ViewportHeight != 0) {
-		RecalculateView();
-		RecalculateProjection();
-		RecalculateRayDirections();
-	}
+	m_ViewportWidth = width;
+	m_ViewportHeight = height;
 
-	if (!Walnut::Input::IsMouseButtonDown(Walnut::MouseButton::Right)) {
-		Walnut::Input::SetCursorMode(Walnut::CursorMode::Normal);
-		return false;
-	}
+	m_Dirty = true;
+	Recalculate();
+}
 
-	if (!viewportFocused) {
+bool Camera::Recalculate() {
+	if (m_ViewportWidth == 0 || m_ViewportHeight == 0) {
 		return false;
 	}
 
-	Walnut::Input::SetCursorMode(Walnut::CursorMode::Locked);
-
-	bool moved = false;
-
-	glm::vec3 rightDirection = glm::cross(m_ForwardDirection, m_UpDirection);
-
-	float speed = m_Data.NormalMovementSpeed;
-
-	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::LeftShift)) {
-		speed = m_Data.FastMovementSpeed;
-	}
-
-	// Movement
-	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::W)) {
-		m_Data.Position += m_ForwardDirection * speed * ts;
-		moved = true;
-	} else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::S)) {
-		m_Data.Position -= m_ForwardDirection * speed * ts;
-		moved = true;
-	}
-
-	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::A)) {
-		m_Data.Position -= rightDirection * speed * ts;
-		moved = true;
-	} else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::D)) {
-		m_Data.Position += rightDirection * speed * ts;
-		moved = true;
-	}
-
-	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::LeftControl)) {
-		m_Data.Position -= m_UpDirection * speed * ts;
-		moved = true;
-	} else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::Space)) {
-		m_Data.Position += m_UpDirection * speed * ts;
-		moved = true;
-	}
-
-	// Rotation
-	if (delta.x != 0.0f || delta.y != 0.0f) {
-		float pitchDelta = delta.y * m_Data.RotationSpeed;
-		float yawDelta = delta.x * m_Data.RotationSpeed;
+	bool changed = m_Dirty ||
+		m_Data.Position != m_CachedData.Position ||
+		m_Data.VerticalFOV != m_CachedData.VerticalFOV ||
+		m_Data.NearClip != m_CachedData.NearClip ||
+		m_Data.FarClip != m_CachedData.FarClip ||
+		m_ForwardDirection != m_CachedForwardDirection;
 
-		glm::quat q = glm::normalize(glm::cross(glm::angleAxis(-pitchDelta, rightDirection),
-			glm::angleAxis(-yawDelta, m_UpDirection)));
-		m_ForwardDirection = glm::rotate(q, m_ForwardDirection);
-
-		moved = true;
+	if (!changed) {
+		return false;
 	}
 
-	/*if (moved) {
-		RecalculateView();
-		RecalculateRayDirections();
-	}*/
-
-	return moved;
-}
-
-void Camera::OnResize(uint32_t width, uint32_t height) {
-	if (width == m_ViewportWidth && height == m_ViewportHeight)
-		return;
-
-	m_ViewportWidth = width;
-	m_ViewportHeight = height;
-
+	RecalculateView();
 	RecalculateProjection();
 	RecalculateRayDirections();
+
+	m_CachedData = m_Data;
+	m_CachedForwardDirection = m_ForwardDirection;
+	m_Dirty = false;
+
+	return true;
 }
 
 void Camera::RecalculateProjection() {
@@ -112,16 +60,19 @@ void Camera::RecalculateView() {
 }
 
 void Camera::RecalculateRayDirections() {
-	m_RayDirections.resize(m_ViewportWidth * m_ViewportHeight);
+	RT_PROFILE_SCOPE("Camera::RecalculateRayDirections");
 
-	for (uint32_t y = 0; y < m_ViewportHeight; y++) {
-		for (uint32_t x = 0; x < m_ViewportWidth; x++) {
-			glm::vec2 coord = { (float)x / (float)m_ViewportWidth, (float)y / (float)m_ViewportHeight };
-			coord = coord * 2.0f - 1.0f; // -1 -> 1
+	auto rayDirection = [this](float x, float y) {
+		glm::vec2 coord = { x / (float)m_ViewportWidth, y / (float)m_ViewportHeight };
+		coord = coord * 2.0f - 1.0f; // -1 -> 1
 
-			glm::vec4 target = m_InverseProjection * glm::vec4(coord.x, coord.y, 1, 1);
-			glm::vec3 rayDirection = glm::vec3(m_InverseView * glm::vec4(glm::normalize(glm::vec3(target) / target.w), 0)); // World space
-			m_RayDirections[x + y * m_ViewportWidth] = rayDirection;
-		}
-	}
-}
\ No newline at end of file
+		glm::vec4 target = m_InverseProjection * glm::vec4(coord.x, coord.y, 1, 1);
+		return glm::vec3(m_InverseView * glm::vec4(glm::vec3(target) / target.w, 0)); // World space
+	};
+
+	// The inverse of a perspective projection keeps w constant for a fixed depth, so the unnormalized
+	// direction is affine in (x, y) and three evaluations describe every pixel
+	m_RayDirectionOrigin = rayDirection(0.0f, 0.0f);
+	m_RayDirectionStepX = rayDirection(1.0f, 0.0f) - m_RayDirectionOrigin;
+	m_RayDirectionStepY = rayDirection(0.0f, 1.0f) - m_RayDirectionOrigin;
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <vector>
+#include <cstdint>
 
 struct CameraData {
 	glm::vec3 Position = glm::vec3(0.0f, 0.0f, 6.0f);
@@ -21,6 +21,10 @@ public:
 	bool OnUpdate(const float& ts, const bool& viewportFocused);
 	void OnResize(uint32_t width, uint32_t height);
 
+	// Rebuilds the matrices and primary ray parameters if the viewport, CameraData or orientation
+	// changed since the last call. Returns true if anything was rebuilt.
+	bool Recalculate();
+
 	const glm::mat4& GetProjection() const { return m_Projection; }
 	const glm::mat4& GetInverseProjection() const { return m_InverseProjection; }
 	const glm::mat4& GetView() const { return m_View; }
@@ -29,10 +33,15 @@ public:
 	const glm::vec3& GetPosition() const { return m_Data.Position; }
 	const glm::vec3& GetDirection() const { return m_ForwardDirection; }
 
-	const std::vector<glm::vec3>& GetRayDirections() const { return m_RayDirections; }
+	// World space direction of the primary ray through pixel (x, y), (0, 0) being the bottom left corner
+	glm::vec3 GetRayDirection(float x, float y) const {
+		return glm::normalize(m_RayDirectionOrigin + m_RayDirectionStepX * x + m_RayDirectionStepY * y);
+	}
 
 	CameraData& GetCameraData() { return m_Data; }
 private:
+	void HandleInput(const float& ts, const bool& viewportFocused);
+
 	void RecalculateProjection();
 	void RecalculateView();
 	void RecalculateRayDirections();
@@ -47,8 +56,15 @@ private:
 	glm::vec3 m_ForwardDirection{ 0.0f, 0.0f, -1.0f };
 	glm::vec3 m_UpDirection{ 0.0f, 1.0f, 0.0f };
 
-	// Cached ray directions
-	std::vector<glm::vec3> m_RayDirections;
+	// Unnormalized primary ray direction is m_RayDirectionOrigin + x * m_RayDirectionStepX + y * m_RayDirectionStepY
+	glm::vec3 m_RayDirectionOrigin{ 0.0f, 0.0f, -1.0f };
+	glm::vec3 m_RayDirectionStepX{ 0.0f };
+	glm::vec3 m_RayDirectionStepY{ 0.0f };
+
+	// State the matrices were last built from
+	CameraData m_CachedData;
+	glm::vec3 m_CachedForwardDirection{ 0.0f };
+	bool m_Dirty = true;
 
 	glm::vec2 m_LastMousePosition{ 0.0f, 0.0f };
 
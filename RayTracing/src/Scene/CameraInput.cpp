@@ -0,0 +1,68 @@
+#include "Camera.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "Walnut/Input/Input.h"
+
+// Interactive controls live apart from Camera.cpp so RayTracingCLI can use Camera without Walnut's input system
+bool Camera::OnUpdate(const float& ts, const bool& viewportFocused) {
+	HandleInput(ts, viewportFocused);
+
+	// Also catches edits to CameraData from the Scene panel
+	return Recalculate();
+}
+
+void Camera::HandleInput(const float& ts, const bool& viewportFocused) {
+	glm::vec2 mousePos = Walnut::Input::GetMousePosition();
+	glm::vec2 delta = (mousePos - m_LastMousePosition) * 0.002f;
+	m_LastMousePosition = mousePos;
+
+	if (!Walnut::Input::IsMouseButtonDown(Walnut::MouseButton::Right)) {
+		Walnut::Input::SetCursorMode(Walnut::CursorMode::Normal);
+		return;
+	}
+
+	if (!viewportFocused) {
+		return;
+	}
+
+	Walnut::Input::SetCursorMode(Walnut::CursorMode::Locked);
+
+	glm::vec3 rightDirection = glm::cross(m_ForwardDirection, m_UpDirection);
+
+	float speed = m_Data.NormalMovementSpeed;
+
+	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::LeftShift)) {
+		speed = m_Data.FastMovementSpeed;
+	}
+
+	// Movement
+	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::W)) {
+		m_Data.Position += m_ForwardDirection * speed * ts;
+	} else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::S)) {
+		m_Data.Position -= m_ForwardDirection * speed * ts;
+	}
+
+	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::A)) {
+		m_Data.Position -= rightDirection * speed * ts;
+	} else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::D)) {
+		m_Data.Position += rightDirection * speed * ts;
+	}
+
+	if (Walnut::Input::IsKeyDown(Walnut::KeyCode::LeftControl)) {
+		m_Data.Position -= m_UpDirection * speed * ts;
+	} else if (Walnut::Input::IsKeyDown(Walnut::KeyCode::Space)) {
+		m_Data.Position += m_UpDirection * speed * ts;
+	}
+
+	// Rotation
+	if (delta.x != 0.0f || delta.y != 0.0f) {
+		float pitchDelta = delta.y * m_Data.RotationSpeed;
+		float yawDelta = delta.x * m_Data.RotationSpeed;
+
+		glm::quat q = glm::normalize(glm::cross(glm::angleAxis(-pitchDelta, rightDirection),
+			glm::angleAxis(-yawDelta, m_UpDirection)));
+		m_ForwardDirection = glm::rotate(q, m_ForwardDirection);
+	}
+}
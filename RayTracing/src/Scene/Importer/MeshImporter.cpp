@@ -0,0 +1,529 @@
+#include "MeshImporter.h"
+
+#include "../../Utils/MappedFile.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unordered_map>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+namespace Utils {
+	static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+	// Next line without its line ending, false at the end of the file
+	static bool NextLine(const char*& cursor, const char* end, std::string_view& line) {
+		if (cursor >= end) {
+			return false;
+		}
+
+		const char* lineEnd = (const char*)memchr(cursor, '\n', (size_t)(end - cursor));
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+
+		line = std::string_view(cursor, (size_t)(lineEnd - cursor));
+		if (!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
+
+		cursor = lineEnd < end ? lineEnd + 1 : end;
+		return true;
+	}
+
+	// Next whitespace separated token, false if only whitespace is left
+	static bool NextToken(const char*& cursor, const char* end, std::string_view& token) {
+		while (cursor < end && IsSpace(*cursor)) {
+			cursor++;
+		}
+
+		const char* start = cursor;
+		while (cursor < end && !IsSpace(*cursor)) {
+			cursor++;
+		}
+
+		token = std::string_view(start, (size_t)(cursor - start));
+		return !token.empty();
+	}
+
+	// from_chars needs no terminator and ignores the locale, but does not accept a leading plus sign
+	template<typename T>
+	static bool ParseNumber(std::string_view token, T& value) {
+		if (!token.empty() && token.front() == '+') {
+			token.remove_prefix(1);
+		}
+
+		return std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc();
+	}
+
+	static std::string GetLowercaseExtension(const std::filesystem::path& filepath) {
+		std::string extension = filepath.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+		return extension;
+	}
+
+	static void AddPolygon(MeshGeometry& geometry, const std::vector<uint32_t>& polygon) {
+		for (size_t i = 1; i + 1 < polygon.size(); i++) {
+			geometry.Indices.push_back(polygon[0]);
+			geometry.Indices.push_back(polygon[i]);
+			geometry.Indices.push_back(polygon[i + 1]);
+		}
+	}
+
+	enum class PLYFormat {
+		ASCII = 0,
+		BinaryLittleEndian,
+		BinaryBigEndian
+	};
+
+	enum class PLYType {
+		Invalid = 0,
+		Int8, UInt8,
+		Int16, UInt16,
+		Int32, UInt32,
+		Float32, Float64
+	};
+
+	struct PLYProperty {
+		std::string_view Name;
+		PLYType Type = PLYType::Invalid;
+		PLYType CountType = PLYType::Invalid; // Lists only
+	};
+
+	struct PLYElement {
+		std::string_view Name;
+		uint64_t Count = 0;
+		std::vector<PLYProperty> Properties;
+
+		int FindProperty(std::string_view name) const {
+			for (size_t i = 0; i < Properties.size(); i++) {
+				if (Properties[i].Name == name) {
+					return (int)i;
+				}
+			}
+			return -1;
+		}
+	};
+
+	// ASCII values have no fixed size, so the header count is only trusted this far before reading
+	static constexpr uint64_t s_MaxASCIIReserve = 1 << 16;
+
+	static PLYType ParsePLYType(std::string_view name) {
+		if (name == "char" || name == "int8") return PLYType::Int8;
+		if (name == "uchar" || name == "uint8") return PLYType::UInt8;
+		if (name == "short" || name == "int16") return PLYType::Int16;
+		if (name == "ushort" || name == "uint16") return PLYType::UInt16;
+		if (name == "int" || name == "int32") return PLYType::Int32;
+		if (name == "uint" || name == "uint32") return PLYType::UInt32;
+		if (name == "float" || name == "float32") return PLYType::Float32;
+		if (name == "double" || name == "float64") return PLYType::Float64;
+		return PLYType::Invalid;
+	}
+
+	static size_t GetPLYTypeSize(PLYType type) {
+		switch (type) {
+			case PLYType::Int8:
+			case PLYType::UInt8:
+				return 1;
+			case PLYType::Int16:
+			case PLYType::UInt16:
+				return 2;
+			case PLYType::Int32:
+			case PLYType::UInt32:
+			case PLYType::Float32:
+				return 4;
+			case PLYType::Float64:
+				return 8;
+			default:
+				return 0;
+		}
+	}
+
+	// How many of the element's items can still be in the file, so a bogus header count can't make the reserve fail
+	static uint64_t GetReserveCount(const PLYElement& element, PLYFormat format, size_t remainingSize) {
+		if (format == PLYFormat::ASCII) {
+			return std::min(element.Count, s_MaxASCIIReserve);
+		}
+
+		// Lists are counted by their count alone, the smallest they can be
+		size_t elementSize = 0;
+		for (const PLYProperty& property : element.Properties) {
+			elementSize += GetPLYTypeSize(property.CountType != PLYType::Invalid ? property.CountType : property.Type);
+		}
+
+		return elementSize > 0 ? std::min(element.Count, (uint64_t)(remainingSize / elementSize)) : 0;
+	}
+
+	// Reads the values of a PLY body one at a time, whatever its format and type
+	class PLYReader {
+	public:
+		PLYReader(const char* cursor, const char* end, PLYFormat format)
+			: m_Cursor(cursor), m_End(end), m_Format(format)
+		{
+			const uint16_t one = 1;
+			bool littleEndian = *(const uint8_t*)&one == 1;
+			m_Swap = format != PLYFormat::ASCII && littleEndian != (format == PLYFormat::BinaryLittleEndian);
+		}
+
+		bool Read(PLYType type, double& value) {
+			if (m_Format == PLYFormat::ASCII) {
+				std::string_view token;
+				return NextToken(m_Cursor, m_End, token) && ParseNumber(token, value);
+			}
+
+			size_t size = GetPLYTypeSize(type);
+			if ((size_t)(m_End - m_Cursor) < size) {
+				return false;
+			}
+
+			uint8_t bytes[8];
+			memcpy(bytes, m_Cursor, size);
+			m_Cursor += size;
+
+			if (m_Swap) {
+				std::reverse(bytes, bytes + size);
+			}
+
+			switch (type) {
+				case PLYType::Int8: value = (double)ReadAs<int8_t>(bytes); break;
+				case PLYType::UInt8: value = (double)ReadAs<uint8_t>(bytes); break;
+				case PLYType::Int16: value = (double)ReadAs<int16_t>(bytes); break;
+				case PLYType::UInt16: value = (double)ReadAs<uint16_t>(bytes); break;
+				case PLYType::Int32: value = (double)ReadAs<int32_t>(bytes); break;
+				case PLYType::UInt32: value = (double)ReadAs<uint32_t>(bytes); break;
+				case PLYType::Float32: value = (double)ReadAs<float>(bytes); break;
+				case PLYType::Float64: value = ReadAs<double>(bytes); break;
+				default: return false;
+			}
+
+			return true;
+		}
+
+		size_t GetRemainingSize() const { return (size_t)(m_End - m_Cursor); }
+	private:
+		template<typename T>
+		static T ReadAs(const uint8_t* bytes) {
+			T result;
+			memcpy(&result, bytes, sizeof(T));
+			return result;
+		}
+	private:
+		const char* m_Cursor;
+		const char* m_End;
+		PLYFormat m_Format;
+		bool m_Swap = false;
+	};
+}
+
+bool MeshImporter::IsSupported(const std::filesystem::path& filepath) {
+	std::string extension = Utils::GetLowercaseExtension(filepath);
+	return extension == ".obj" || extension == ".ply";
+}
+
+std::shared_ptr<MeshGeometry> MeshImporter::Import(const std::filesystem::path& filepath) {
+	spdlog::info("MeshImporter - Attempting to import mesh: {0}", filepath.string());
+
+	if (!IsSupported(filepath)) {
+		spdlog::error("MeshImporter - Unsupported mesh format, expected .obj or .ply: {0}", filepath.string());
+		return nullptr;
+	}
+
+	MappedFile file;
+	if (!file.Open(filepath)) {
+		return nullptr;
+	}
+
+	const char* begin = (const char*)file.GetData();
+	const char* end = begin + file.GetSize();
+
+	std::shared_ptr<MeshGeometry> geometry = std::make_shared<MeshGeometry>();
+
+	bool imported = Utils::GetLowercaseExtension(filepath) == ".obj" ? ImportOBJ(begin, end, *geometry) : ImportPLY(begin, end, *geometry);
+
+	if (!imported) {
+		spdlog::error("MeshImporter - Could not import mesh: {0}", filepath.string());
+		return nullptr;
+	}
+
+	if (geometry->GetTriangleCount() == 0) {
+		spdlog::warn("MeshImporter - Mesh has no triangles: {0}", filepath.string());
+		return nullptr;
+	}
+
+	geometry->Positions.shrink_to_fit();
+	geometry->Indices.shrink_to_fit();
+
+	spdlog::info("MeshImporter - Imported {0} triangles, {1} vertices", geometry->GetTriangleCount(), geometry->Positions.size());
+
+	return geometry;
+}
+
+void MeshImporter::ImportSceneMeshes(Scene& scene) {
+	// Seeded with the geometry already loaded, so a mesh added for a file that is in use shares it
+	std::unordered_map<std::string, std::shared_ptr<const MeshGeometry>> geometries;
+	for (const Mesh& mesh : scene.Meshes) {
+		if (mesh.Geometry) {
+			geometries.emplace(mesh.Filepath, mesh.Geometry);
+		}
+	}
+
+	bool imported = false;
+
+	for (Mesh& mesh : scene.Meshes) {
+		if (mesh.Geometry || mesh.Filepath.empty()) {
+			continue;
+		}
+
+		auto it = geometries.find(mesh.Filepath);
+		if (it == geometries.end()) {
+			it = geometries.emplace(mesh.Filepath, Import(mesh.Filepath)).first;
+		}
+
+		mesh.Geometry = it->second;
+		imported |= mesh.Geometry != nullptr;
+	}
+
+	if (imported) {
+		scene.MarkMeshesChanged();
+	}
+}
+
+bool MeshImporter::ImportOBJ(const char* begin, const char* end, MeshGeometry& geometry) {
+	std::vector<uint32_t> polygon;
+
+	const char* cursor = begin;
+	std::string_view line;
+	uint32_t lineNumber = 0;
+
+	while (Utils::NextLine(cursor, end, line)) {
+		lineNumber++;
+
+		const char* lineCursor = line.data();
+		const char* lineEnd = line.data() + line.size();
+
+		std::string_view keyword;
+		if (!Utils::NextToken(lineCursor, lineEnd, keyword)) {
+			continue;
+		}
+
+		// Normals, texture coordinates, groups and materials are skipped along with everything else
+		if (keyword == "v") {
+			glm::vec3 position;
+			for (int i = 0; i < 3; i++) {
+				std::string_view token;
+				if (!Utils::NextToken(lineCursor, lineEnd, token) || !Utils::ParseNumber(token, position[i])) {
+					spdlog::error("MeshImporter - Invalid vertex on line {0}", lineNumber);
+					return false;
+				}
+			}
+
+			geometry.Positions.push_back(position);
+		} else if (keyword == "f") {
+			polygon.clear();
+
+			// Each corner is v, v/vt, v//vn or v/vt/vn, only v is used
+			std::string_view token;
+			while (Utils::NextToken(lineCursor, lineEnd, token)) {
+				int64_t index = 0;
+				std::from_chars(token.data(), token.data() + token.size(), index);
+
+				// Indices start at 1, negative ones count back from the last vertex read so far
+				int64_t vertex = index > 0 ? index - 1 : (int64_t)geometry.Positions.size() + index;
+				if (index == 0 || vertex < 0 || vertex >= (int64_t)geometry.Positions.size()) {
+					spdlog::error("MeshImporter - Invalid face on line {0}", lineNumber);
+					return false;
+				}
+
+				polygon.push_back((uint32_t)vertex);
+			}
+
+			Utils::AddPolygon(geometry, polygon);
+		}
+	}
+
+	return true;
+}
+
+bool MeshImporter::ImportPLY(const char* begin, const char* end, MeshGeometry& geometry) {
+	const char* cursor = begin;
+	std::string_view line;
+
+	if (!Utils::NextLine(cursor, end, line) || line != "ply") {
+		spdlog::error("MeshImporter - Not a PLY file");
+		return false;
+	}
+
+	Utils::PLYFormat format = Utils::PLYFormat::ASCII;
+	std::vector<Utils::PLYElement> elements;
+
+	while (true) {
+		if (!Utils::NextLine(cursor, end, line)) {
+			spdlog::error("MeshImporter - PLY header has no end_header");
+			return false;
+		}
+
+		const char* lineCursor = line.data();
+		const char* lineEnd = line.data() + line.size();
+
+		std::string_view keyword;
+		if (!Utils::NextToken(lineCursor, lineEnd, keyword)) {
+			continue;
+		}
+
+		if (keyword == "end_header") {
+			break;
+		}
+
+		// comment and obj_info lines are skipped
+		std::string_view token;
+		if (keyword == "format") {
+			Utils::NextToken(lineCursor, lineEnd, token);
+			if (token == "ascii") {
+				format = Utils::PLYFormat::ASCII;
+			} else if (token == "binary_little_endian") {
+				format = Utils::PLYFormat::BinaryLittleEndian;
+			} else if (token == "binary_big_endian") {
+				format = Utils::PLYFormat::BinaryBigEndian;
+			} else {
+				spdlog::error("MeshImporter - Unsupported PLY format: {0}", token);
+				return false;
+			}
+		} else if (keyword == "element") {
+			Utils::PLYElement& element = elements.emplace_back();
+			Utils::NextToken(lineCursor, lineEnd, element.Name);
+			if (!Utils::NextToken(lineCursor, lineEnd, token) || !Utils::ParseNumber(token, element.Count)) {
+				spdlog::error("MeshImporter - Invalid PLY element: {0}", line);
+				return false;
+			}
+		} else if (keyword == "property") {
+			if (elements.empty()) {
+				spdlog::error("MeshImporter - PLY property outside of an element: {0}", line);
+				return false;
+			}
+
+			Utils::PLYProperty property;
+			Utils::NextToken(lineCursor, lineEnd, token);
+			if (token == "list") {
+				Utils::NextToken(lineCursor, lineEnd, token);
+				property.CountType = Utils::ParsePLYType(token);
+				Utils::NextToken(lineCursor, lineEnd, token);
+				property.Type = Utils::ParsePLYType(token);
+
+				if (property.CountType == Utils::PLYType::Invalid) {
+					spdlog::error("MeshImporter - Invalid PLY property: {0}", line);
+					return false;
+				}
+			} else {
+				property.Type = Utils::ParsePLYType(token);
+			}
+			Utils::NextToken(lineCursor, lineEnd, property.Name);
+
+			if (property.Type == Utils::PLYType::Invalid) {
+				spdlog::error("MeshImporter - Invalid PLY property: {0}", line);
+				return false;
+			}
+
+			elements.back().Properties.push_back(property);
+		}
+	}
+
+	Utils::PLYReader reader(cursor, end, format);
+	std::vector<uint32_t> polygon;
+
+	for (const Utils::PLYElement& element : elements) {
+		bool isVertex = element.Name == "vertex";
+		bool isFace = element.Name == "face";
+
+		int positionProperties[3] = { element.FindProperty("x"), element.FindProperty("y"), element.FindProperty("z") };
+		int indexProperty = element.FindProperty("vertex_indices");
+		if (indexProperty < 0) {
+			indexProperty = element.FindProperty("vertex_index");
+		}
+
+		if (isVertex) {
+			if (positionProperties[0] < 0 || positionProperties[1] < 0 || positionProperties[2] < 0) {
+				spdlog::error("MeshImporter - PLY vertices have no x, y and z");
+				return false;
+			}
+			geometry.Positions.reserve(Utils::GetReserveCount(element, format, reader.GetRemainingSize()));
+		} else if (isFace) {
+			if (indexProperty < 0 || element.Properties[indexProperty].CountType == Utils::PLYType::Invalid) {
+				spdlog::error("MeshImporter - PLY faces have no vertex_indices list");
+				return false;
+			}
+			geometry.Indices.reserve(Utils::GetReserveCount(element, format, reader.GetRemainingSize()) * 3);
+		}
+
+		// Other elements (edges, materials, ...) are read past in the same way
+		for (uint64_t i = 0; i < element.Count; i++) {
+			glm::vec3 position{ 0.0f };
+			polygon.clear();
+
+			for (int p = 0; p < (int)element.Properties.size(); p++) {
+				const Utils::PLYProperty& property = element.Properties[p];
+				double value = 0.0;
+
+				if (property.CountType == Utils::PLYType::Invalid) {
+					if (!reader.Read(property.Type, value)) {
+						spdlog::error("MeshImporter - PLY file ends in element {0}", element.Name);
+						return false;
+					}
+
+					for (int axis = 0; axis < 3; axis++) {
+						if (isVertex && p == positionProperties[axis]) {
+							position[axis] = (float)value;
+						}
+					}
+					continue;
+				}
+
+				double count = 0.0;
+				if (!reader.Read(property.CountType, count)) {
+					spdlog::error("MeshImporter - PLY file ends in element {0}", element.Name);
+					return false;
+				}
+
+				// Every value takes at least a byte, also in ASCII, and the negation catches NaN
+				if (!(count >= 0.0 && count <= (double)reader.GetRemainingSize())) {
+					spdlog::error("MeshImporter - Invalid PLY list count in element {0}: {1}", element.Name, count);
+					return false;
+				}
+
+				for (uint64_t j = 0; j < (uint64_t)count; j++) {
+					if (!reader.Read(property.Type, value)) {
+						spdlog::error("MeshImporter - PLY file ends in element {0}", element.Name);
+						return false;
+					}
+
+					if (isFace && p == indexProperty) {
+						if (value < 0.0 || value >= 4294967296.0) {
+							spdlog::error("MeshImporter - Invalid PLY vertex index: {0}", value);
+							return false;
+						}
+						polygon.push_back((uint32_t)value);
+					}
+				}
+			}
+
+			if (isVertex) {
+				geometry.Positions.push_back(position);
+			} else if (isFace) {
+				Utils::AddPolygon(geometry, polygon);
+			}
+		}
+	}
+
+	// Faces may come before the vertices, so indices are only checked once everything is read
+	uint32_t vertexCount = (uint32_t)geometry.Positions.size();
+	for (uint32_t index : geometry.Indices) {
+		if (index >= vertexCount) {
+			spdlog::error("MeshImporter - PLY face refers to vertex {0}, but there are only {1}", index, vertexCount);
+			return false;
+		}
+	}
+
+	return true;
+}
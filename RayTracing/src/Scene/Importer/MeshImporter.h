@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../Scene.h"
+
+#include <filesystem>
+#include <memory>
+
+// Loads triangle meshes from Wavefront OBJ and PLY (ASCII or binary) files. The file is mapped and parsed
+// in a single pass straight into the vertex and index buffers, there is no intermediate copy of the text
+// or of the elements. Polygons are split into triangle fans. Normals, texture coordinates and any other
+// vertex attributes are skipped, the renderer only uses the geometric normal.
+class MeshImporter {
+public:
+	static bool IsSupported(const std::filesystem::path& filepath);
+
+	// Null if the file could not be read or holds no triangles
+	static std::shared_ptr<MeshGeometry> Import(const std::filesystem::path& filepath);
+
+	// Imports the geometry of every mesh that has none yet, meshes referencing the same file share it
+	static void ImportSceneMeshes(Scene& scene);
+private:
+	static bool ImportOBJ(const char* begin, const char* end, MeshGeometry& geometry);
+	static bool ImportPLY(const char* begin, const char* end, MeshGeometry& geometry);
+};
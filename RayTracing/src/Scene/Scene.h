@@ -3,9 +3,13 @@
 #include "../Utils/Color.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
 
 struct Sky {
 	bool Enabled = false;
@@ -39,7 +43,7 @@ struct Material {
 	glm::vec3 EmissionColor = Color::Black;
 	float EmissionPower = 0.0f;
 
-	glm::vec3& GetEmission() const { return EmissionColor * EmissionPower; }
+	glm::vec3 GetEmission() const { return EmissionColor * EmissionPower; }
 
 	bool operator==(const Material& other) {
 		return (
@@ -70,12 +74,146 @@ struct Sphere {
 	}
 };
 
+// Translation, then rotation in degrees around Z, Y and X, then scale, as used by instances and meshes
+inline glm::mat4 ComposeTransform(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+	transform = glm::rotate(transform, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	transform = glm::rotate(transform, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	transform = glm::rotate(transform, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	return glm::scale(transform, scale);
+}
+
+// A group of spheres stored once and placed any number of times by instances. Sphere positions are
+// relative to the prototype's origin, material indices refer to the scene's materials.
+struct Prototype {
+	std::string Name = "New Prototype";
+	std::vector<Sphere> Spheres;
+};
+
+struct Instance {
+	bool Enabled = true;
+	int PrototypeIndex = 0;
+
+	glm::vec3 Position{ 0.0f };
+	glm::vec3 Rotation{ 0.0f }; // Degrees, applied around X, then Y, then Z
+	glm::vec3 Scale{ 1.0f };
+
+	// Replaces the material of every sphere in the prototype, -1 keeps the prototype's materials
+	int MaterialIndex = -1;
+
+	// Prototype space to world space
+	glm::mat4 GetTransform() const { return ComposeTransform(Position, Rotation, Scale); }
+
+	bool operator==(const Instance& other) {
+		return (
+			this->Enabled == other.Enabled &&
+			this->PrototypeIndex == other.PrototypeIndex &&
+			this->Position == other.Position &&
+			this->Rotation == other.Rotation &&
+			this->Scale == other.Scale &&
+			this->MaterialIndex == other.MaterialIndex
+		);
+	}
+};
+
+// Indexed triangles as loaded by MeshImporter, three indices per triangle
+struct MeshGeometry {
+	std::vector<glm::vec3> Positions;
+	std::vector<uint32_t> Indices;
+
+	uint32_t GetTriangleCount() const { return (uint32_t)(Indices.size() / 3); }
+};
+
+// A triangle mesh placed in the scene. Only the reference is saved with the scene, the geometry is
+// loaded from Filepath (relative to the working directory) and shared by meshes referencing the same file.
+struct Mesh {
+	bool Enabled = true;
+	std::string Filepath;
+
+	glm::vec3 Position{ 0.0f };
+	glm::vec3 Rotation{ 0.0f }; // Degrees, applied around X, then Y, then Z
+	glm::vec3 Scale{ 1.0f };
+
+	int MaterialIndex = 0;
+
+	// Null until imported, or when the file could not be loaded
+	std::shared_ptr<const MeshGeometry> Geometry;
+
+	// Mesh space to world space
+	glm::mat4 GetTransform() const { return ComposeTransform(Position, Rotation, Scale); }
+
+	bool operator==(const Mesh& other) {
+		return (
+			this->Enabled == other.Enabled &&
+			this->Filepath == other.Filepath &&
+			this->Position == other.Position &&
+			this->Rotation == other.Rotation &&
+			this->Scale == other.Scale &&
+			this->MaterialIndex == other.MaterialIndex &&
+			this->Geometry == other.Geometry
+		);
+	}
+};
+
+// Revision counters, bumped whenever the matching part of a scene changes. They all come from one
+// global counter, so a new or reloaded scene never reuses a revision an observer has already seen
+// and changes can be detected by comparing integers instead of scene contents.
+struct SceneRevisions {
+	uint64_t Sky = 0;
+	uint64_t Lights = 0;
+	uint64_t Spheres = 0;
+	uint64_t Materials = 0;
+	uint64_t Prototypes = 0;
+	uint64_t Instances = 0;
+	uint64_t Meshes = 0;
+
+	static uint64_t Next() {
+		static std::atomic<uint64_t> s_Revision = 0;
+		return ++s_Revision;
+	}
+};
+
 struct Scene {
 	std::string Name = "New Scene";
 
-	Sky Sky;
+	::Sky Sky;
 
 	std::vector<Sphere> Spheres;
 	std::vector<Material> Materials;
 	std::vector<Light> Lights;
+
+	std::vector<Prototype> Prototypes;
+	std::vector<Instance> Instances;
+
+	std::vector<Mesh> Meshes;
+
+	// Whoever modifies Sky, Lights, Spheres, Materials, Prototypes, Instances or Meshes must call the matching Mark*Changed
+	SceneRevisions Revisions;
+
+	Scene() { MarkAllChanged(); }
+
+	void MarkSkyChanged() { Revisions.Sky = SceneRevisions::Next(); }
+	void MarkLightsChanged() { Revisions.Lights = SceneRevisions::Next(); }
+	void MarkSpheresChanged() { Revisions.Spheres = SceneRevisions::Next(); }
+	void MarkMaterialsChanged() { Revisions.Materials = SceneRevisions::Next(); }
+	void MarkPrototypesChanged() { Revisions.Prototypes = SceneRevisions::Next(); }
+	void MarkInstancesChanged() { Revisions.Instances = SceneRevisions::Next(); }
+	void MarkMeshesChanged() { Revisions.Meshes = SceneRevisions::Next(); }
+
+	void MarkAllChanged() {
+		MarkSkyChanged();
+		MarkLightsChanged();
+		MarkSpheresChanged();
+		MarkMaterialsChanged();
+		MarkPrototypesChanged();
+		MarkInstancesChanged();
+		MarkMeshesChanged();
+	}
+
+	// Changes whenever any part of the scene does
+	uint64_t GetRevision() const {
+		uint64_t revision = glm::max(glm::max(Revisions.Sky, Revisions.Lights), glm::max(Revisions.Spheres, Revisions.Materials));
+		revision = glm::max(revision, glm::max(Revisions.Prototypes, Revisions.Instances));
+		return glm::max(revision, Revisions.Meshes);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "SceneBinarySerializer.h"
+
+#include "../../Utils/MappedFile.h"
+
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+
+namespace Utils {
+	static constexpr char s_Magic[8] = { 'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0' };
+	static constexpr uint32_t s_ByteOrderMarker = 0x01020304;
+	static constexpr uint64_t s_SectionAlignment = 64;
+
+	static constexpr uint32_t s_EnabledFlag = 1 << 0;
+
+	struct Section {
+		uint64_t Offset = 0;
+		uint64_t Count = 0;
+	};
+
+	struct FileHeader {
+		char Magic[8];
+		uint32_t Version;
+		uint32_t ByteOrder;
+		uint64_t FileSize;
+
+		float SkyColor[3];
+		uint32_t SkyFlags;
+
+		// Offset into the string table
+		uint32_t NameOffset;
+		uint32_t NameLength;
+
+		Section Lights;
+		Section Spheres;
+		Section Materials;
+		Section Strings; // Count is in bytes
+
+		Section Prototypes;
+		Section PrototypeSpheres;
+		Section Instances;
+		Section Meshes;
+	};
+
+	struct LightRecord {
+		float Position[3];
+		uint32_t Flags;
+	};
+
+	struct SphereRecord {
+		float Position[3];
+		float Radius;
+		int32_t MaterialIndex;
+		uint32_t Flags;
+	};
+
+	struct MaterialRecord {
+		float Albedo[3];
+		float Roughness;
+		float EmissionColor[3];
+		float EmissionPower;
+		float Metallic;
+
+		// Offset into the string table
+		uint32_t NameOffset;
+		uint32_t NameLength;
+		uint32_t Reserved;
+	};
+
+	struct PrototypeRecord {
+		// Range of the PrototypeSpheres section
+		uint64_t FirstSphere;
+		uint64_t SphereCount;
+
+		// Offset into the string table
+		uint32_t NameOffset;
+		uint32_t NameLength;
+	};
+
+	struct InstanceRecord {
+		float Position[3];
+		float Rotation[3];
+		float Scale[3];
+		int32_t PrototypeIndex;
+		int32_t MaterialIndex;
+		uint32_t Flags;
+	};
+
+	struct MeshRecord {
+		float Position[3];
+		float Rotation[3];
+		float Scale[3];
+		int32_t MaterialIndex;
+		uint32_t Flags;
+
+		// Offset into the string table, only the reference is stored
+		uint32_t FilepathOffset;
+		uint32_t FilepathLength;
+		uint32_t Reserved;
+	};
+
+	static_assert(sizeof(FileHeader) == 176, "FileHeader layout changed, bump the version");
+	static_assert(sizeof(LightRecord) == 16, "LightRecord layout changed, bump the version");
+	static_assert(sizeof(SphereRecord) == 24, "SphereRecord layout changed, bump the version");
+	static_assert(sizeof(MaterialRecord) == 48, "MaterialRecord layout changed, bump the version");
+	static_assert(sizeof(PrototypeRecord) == 24, "PrototypeRecord layout changed, bump the version");
+	static_assert(sizeof(InstanceRecord) == 48, "InstanceRecord layout changed, bump the version");
+	static_assert(sizeof(MeshRecord) == 56, "MeshRecord layout changed, bump the version");
+	static_assert(std::is_trivially_copyable_v<FileHeader>, "Records are written and read as raw bytes");
+
+	static uint64_t AlignOffset(uint64_t offset) {
+		return (offset + s_SectionAlignment - 1) / s_SectionAlignment * s_SectionAlignment;
+	}
+
+	static void WriteVec3(float* destination, const glm::vec3& v) {
+		destination[0] = v.x;
+		destination[1] = v.y;
+		destination[2] = v.z;
+	}
+
+	static glm::vec3 ReadVec3(const float* source) {
+		return glm::vec3(source[0], source[1], source[2]);
+	}
+
+	static void WriteSphere(SphereRecord& record, const Sphere& sphere) {
+		WriteVec3(record.Position, sphere.Position);
+		record.Radius = sphere.Radius;
+		record.MaterialIndex = sphere.MaterialIndex;
+		record.Flags = sphere.Enabled ? s_EnabledFlag : 0;
+	}
+
+	static void ReadSphere(Sphere& sphere, const SphereRecord& record) {
+		sphere.Enabled = (record.Flags & s_EnabledFlag) != 0;
+		sphere.Position = ReadVec3(record.Position);
+		sphere.Radius = record.Radius;
+		sphere.MaterialIndex = record.MaterialIndex;
+	}
+
+	// Names typed into the scene panel live in an oversized buffer, only store up to the terminator
+	static uint32_t AppendString(std::string& strings, const std::string& value, uint32_t& length) {
+		uint32_t offset = (uint32_t)strings.size();
+		length = (uint32_t)strnlen(value.c_str(), value.size());
+		strings.append(value.c_str(), length);
+		return offset;
+	}
+
+	static bool IsSectionValid(const Section& section, size_t recordSize, uint64_t fileSize) {
+		if (section.Count == 0) {
+			return true;
+		}
+
+		return section.Offset % s_SectionAlignment == 0 &&
+			section.Offset <= fileSize &&
+			section.Count <= (fileSize - section.Offset) / recordSize;
+	}
+
+	static bool IsStringValid(uint32_t offset, uint32_t length, const Section& strings) {
+		return (uint64_t)offset + length <= strings.Count;
+	}
+}
+
+SceneBinarySerializer::SceneBinarySerializer(Scene& scene)
+	: m_Scene(scene)
+{}
+
+bool SceneBinarySerializer::Serialize(const std::filesystem::path& filepath) {
+	spdlog::info("SceneBinarySerializer - Saving Scene: {0}", m_Scene.Name);
+
+	Utils::FileHeader header = {};
+	memcpy(header.Magic, Utils::s_Magic, sizeof(header.Magic));
+	header.Version = s_Version;
+	header.ByteOrder = Utils::s_ByteOrderMarker;
+
+	Utils::WriteVec3(header.SkyColor, m_Scene.Sky.Color);
+	header.SkyFlags = m_Scene.Sky.Enabled ? Utils::s_EnabledFlag : 0;
+
+	std::string strings = m_Scene.Name;
+	header.NameOffset = 0;
+	header.NameLength = (uint32_t)m_Scene.Name.size();
+
+	std::vector<Utils::LightRecord> lights(m_Scene.Lights.size());
+	for (size_t i = 0; i < lights.size(); i++) {
+		const Light& light = m_Scene.Lights[i];
+		Utils::WriteVec3(lights[i].Position, light.Position);
+		lights[i].Flags = light.Enabled ? Utils::s_EnabledFlag : 0;
+	}
+
+	std::vector<Utils::SphereRecord> spheres(m_Scene.Spheres.size());
+	for (size_t i = 0; i < spheres.size(); i++) {
+		Utils::WriteSphere(spheres[i], m_Scene.Spheres[i]);
+	}
+
+	std::vector<Utils::MaterialRecord> materials(m_Scene.Materials.size());
+	for (size_t i = 0; i < materials.size(); i++) {
+		const Material& material = m_Scene.Materials[i];
+		Utils::WriteVec3(materials[i].Albedo, material.Albedo);
+		materials[i].Roughness = material.Roughness;
+		Utils::WriteVec3(materials[i].EmissionColor, material.EmissionColor);
+		materials[i].EmissionPower = material.EmissionPower;
+		materials[i].Metallic = material.Metallic;
+		materials[i].NameOffset = Utils::AppendString(strings, material.Name, materials[i].NameLength);
+		materials[i].Reserved = 0;
+	}
+
+	std::vector<Utils::PrototypeRecord> prototypes(m_Scene.Prototypes.size());
+	std::vector<Utils::SphereRecord> prototypeSpheres;
+	for (size_t i = 0; i < prototypes.size(); i++) {
+		const Prototype& prototype = m_Scene.Prototypes[i];
+		prototypes[i].FirstSphere = prototypeSpheres.size();
+		prototypes[i].SphereCount = prototype.Spheres.size();
+		prototypes[i].NameOffset = Utils::AppendString(strings, prototype.Name, prototypes[i].NameLength);
+
+		for (const Sphere& sphere : prototype.Spheres) {
+			Utils::WriteSphere(prototypeSpheres.emplace_back(), sphere);
+		}
+	}
+
+	std::vector<Utils::InstanceRecord> instances(m_Scene.Instances.size());
+	for (size_t i = 0; i < instances.size(); i++) {
+		const Instance& instance = m_Scene.Instances[i];
+		Utils::WriteVec3(instances[i].Position, instance.Position);
+		Utils::WriteVec3(instances[i].Rotation, instance.Rotation);
+		Utils::WriteVec3(instances[i].Scale, instance.Scale);
+		instances[i].PrototypeIndex = instance.PrototypeIndex;
+		instances[i].MaterialIndex = instance.MaterialIndex;
+		instances[i].Flags = instance.Enabled ? Utils::s_EnabledFlag : 0;
+	}
+
+	std::vector<Utils::MeshRecord> meshes(m_Scene.Meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++) {
+		const Mesh& mesh = m_Scene.Meshes[i];
+		Utils::WriteVec3(meshes[i].Position, mesh.Position);
+		Utils::WriteVec3(meshes[i].Rotation, mesh.Rotation);
+		Utils::WriteVec3(meshes[i].Scale, mesh.Scale);
+		meshes[i].MaterialIndex = mesh.MaterialIndex;
+		meshes[i].Flags = mesh.Enabled ? Utils::s_EnabledFlag : 0;
+		meshes[i].FilepathOffset = Utils::AppendString(strings, mesh.Filepath, meshes[i].FilepathLength);
+		meshes[i].Reserved = 0;
+	}
+
+	uint64_t offset = sizeof(Utils::FileHeader);
+	auto placeSection = [&offset](Utils::Section& section, uint64_t count, size_t recordSize) {
+		offset = Utils::AlignOffset(offset);
+		section.Offset = offset;
+		section.Count = count;
+		offset += count * recordSize;
+	};
+
+	placeSection(header.Lights, lights.size(), sizeof(Utils::LightRecord));
+	placeSection(header.Spheres, spheres.size(), sizeof(Utils::SphereRecord));
+	placeSection(header.Materials, materials.size(), sizeof(Utils::MaterialRecord));
+	placeSection(header.Prototypes, prototypes.size(), sizeof(Utils::PrototypeRecord));
+	placeSection(header.PrototypeSpheres, prototypeSpheres.size(), sizeof(Utils::SphereRecord));
+	placeSection(header.Instances, instances.size(), sizeof(Utils::InstanceRecord));
+	placeSection(header.Meshes, meshes.size(), sizeof(Utils::MeshRecord));
+	placeSection(header.Strings, strings.size(), 1);
+	header.FileSize = offset;
+
+	std::ofstream fout(filepath, std::ios::binary);
+	if (!fout) {
+		spdlog::error("SceneBinarySerializer - Could not open file for writing: {0}", filepath.string());
+		return false;
+	}
+
+	auto writeSection = [&fout](const Utils::Section& section, const void* data, size_t size) {
+		static constexpr char s_Padding[Utils::s_SectionAlignment] = {};
+		fout.write(s_Padding, (std::streamsize)(section.Offset - (uint64_t)fout.tellp()));
+		fout.write((const char*)data, (std::streamsize)size);
+	};
+
+	fout.write((const char*)&header, sizeof(header));
+	writeSection(header.Lights, lights.data(), lights.size() * sizeof(Utils::LightRecord));
+	writeSection(header.Spheres, spheres.data(), spheres.size() * sizeof(Utils::SphereRecord));
+	writeSection(header.Materials, materials.data(), materials.size() * sizeof(Utils::MaterialRecord));
+	writeSection(header.Prototypes, prototypes.data(), prototypes.size() * sizeof(Utils::PrototypeRecord));
+	writeSection(header.PrototypeSpheres, prototypeSpheres.data(), prototypeSpheres.size() * sizeof(Utils::SphereRecord));
+	writeSection(header.Instances, instances.data(), instances.size() * sizeof(Utils::InstanceRecord));
+	writeSection(header.Meshes, meshes.data(), meshes.size() * sizeof(Utils::MeshRecord));
+	writeSection(header.Strings, strings.data(), strings.size());
+
+	if (!fout) {
+		spdlog::error("SceneBinarySerializer - Error writing Scene file: {0}", filepath.string());
+		return false;
+	}
+
+	spdlog::info("SceneBinarySerializer - Saving complete");
+
+	return true;
+}
+
+bool SceneBinarySerializer::Deserialize(const std::filesystem::path& filepath) {
+	spdlog::info("SceneBinarySerializer - Attempting to read Scene file: {0}", filepath.string());
+
+	MappedFile file;
+	if (!file.Open(filepath)) {
+		return false;
+	}
+
+	if (file.GetSize() < sizeof(Utils::FileHeader)) {
+		spdlog::error("SceneBinarySerializer - File is too small to be a scene: {0}", filepath.string());
+		return false;
+	}
+
+	Utils::FileHeader header;
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	if (memcmp(header.Magic, Utils::s_Magic, sizeof(header.Magic)) != 0) {
+		spdlog::error("SceneBinarySerializer - Not a binary scene file: {0}", filepath.string());
+		return false;
+	}
+
+	if (header.ByteOrder != Utils::s_ByteOrderMarker || header.Version != s_Version) {
+		spdlog::error("SceneBinarySerializer - Unsupported scene file version {0}, expected {1}", header.Version, s_Version);
+		return false;
+	}
+
+	uint64_t fileSize = file.GetSize();
+	bool valid = header.FileSize == fileSize &&
+		Utils::IsSectionValid(header.Lights, sizeof(Utils::LightRecord), fileSize) &&
+		Utils::IsSectionValid(header.Spheres, sizeof(Utils::SphereRecord), fileSize) &&
+		Utils::IsSectionValid(header.Materials, sizeof(Utils::MaterialRecord), fileSize) &&
+		Utils::IsSectionValid(header.Prototypes, sizeof(Utils::PrototypeRecord), fileSize) &&
+		Utils::IsSectionValid(header.PrototypeSpheres, sizeof(Utils::SphereRecord), fileSize) &&
+		Utils::IsSectionValid(header.Instances, sizeof(Utils::InstanceRecord), fileSize) &&
+		Utils::IsSectionValid(header.Meshes, sizeof(Utils::MeshRecord), fileSize) &&
+		Utils::IsSectionValid(header.Strings, 1, fileSize) &&
+		Utils::IsStringValid(header.NameOffset, header.NameLength, header.Strings);
+
+	if (!valid) {
+		spdlog::error("SceneBinarySerializer - Scene file is truncated or corrupt: {0}", filepath.string());
+		return false;
+	}
+
+	const uint8_t* data = file.GetData();
+	const char* strings = (const char*)(data + header.Strings.Offset);
+
+	const Utils::MaterialRecord* materials = (const Utils::MaterialRecord*)(data + header.Materials.Offset);
+	for (uint64_t i = 0; i < header.Materials.Count; i++) {
+		if (!Utils::IsStringValid(materials[i].NameOffset, materials[i].NameLength, header.Strings)) {
+			spdlog::error("SceneBinarySerializer - Scene file is truncated or corrupt: {0}", filepath.string());
+			return false;
+		}
+	}
+
+	const Utils::PrototypeRecord* prototypes = (const Utils::PrototypeRecord*)(data + header.Prototypes.Offset);
+	for (uint64_t i = 0; i < header.Prototypes.Count; i++) {
+		bool validSpheres = prototypes[i].FirstSphere <= header.PrototypeSpheres.Count &&
+			prototypes[i].SphereCount <= header.PrototypeSpheres.Count - prototypes[i].FirstSphere;
+
+		if (!validSpheres || !Utils::IsStringValid(prototypes[i].NameOffset, prototypes[i].NameLength, header.Strings)) {
+			spdlog::error("SceneBinarySerializer - Scene file is truncated or corrupt: {0}", filepath.string());
+			return false;
+		}
+	}
+
+	const Utils::MeshRecord* meshes = (const Utils::MeshRecord*)(data + header.Meshes.Offset);
+	for (uint64_t i = 0; i < header.Meshes.Count; i++) {
+		if (!Utils::IsStringValid(meshes[i].FilepathOffset, meshes[i].FilepathLength, header.Strings)) {
+			spdlog::error("SceneBinarySerializer - Scene file is truncated or corrupt: {0}", filepath.string());
+			return false;
+		}
+	}
+
+	m_Scene.Name.assign(strings + header.NameOffset, header.NameLength);
+
+	spdlog::info("SceneBinarySerializer - Loading Scene: {0}", m_Scene.Name);
+
+	m_Scene.Sky.Enabled = (header.SkyFlags & Utils::s_EnabledFlag) != 0;
+	m_Scene.Sky.Color = Utils::ReadVec3(header.SkyColor);
+
+	// Sections start on 64 byte boundaries of a page aligned mapping, so the records can be read in place
+	const Utils::LightRecord* lights = (const Utils::LightRecord*)(data + header.Lights.Offset);
+	m_Scene.Lights.resize(header.Lights.Count);
+	for (uint64_t i = 0; i < header.Lights.Count; i++) {
+		Light& light = m_Scene.Lights[i];
+		light.Enabled = (lights[i].Flags & Utils::s_EnabledFlag) != 0;
+		light.Position = Utils::ReadVec3(lights[i].Position);
+	}
+
+	const Utils::SphereRecord* spheres = (const Utils::SphereRecord*)(data + header.Spheres.Offset);
+	m_Scene.Spheres.resize(header.Spheres.Count);
+	for (uint64_t i = 0; i < header.Spheres.Count; i++) {
+		Utils::ReadSphere(m_Scene.Spheres[i], spheres[i]);
+	}
+
+	m_Scene.Materials.resize(header.Materials.Count);
+	for (uint64_t i = 0; i < header.Materials.Count; i++) {
+		Material& material = m_Scene.Materials[i];
+		material.Name.assign(strings + materials[i].NameOffset, materials[i].NameLength);
+		material.Albedo = Utils::ReadVec3(materials[i].Albedo);
+		material.Roughness = materials[i].Roughness;
+		material.Metallic = materials[i].Metallic;
+		material.EmissionColor = Utils::ReadVec3(materials[i].EmissionColor);
+		material.EmissionPower = materials[i].EmissionPower;
+	}
+
+	const Utils::SphereRecord* prototypeSpheres = (const Utils::SphereRecord*)(data + header.PrototypeSpheres.Offset);
+	m_Scene.Prototypes.resize(header.Prototypes.Count);
+	for (uint64_t i = 0; i < header.Prototypes.Count; i++) {
+		Prototype& prototype = m_Scene.Prototypes[i];
+		prototype.Name.assign(strings + prototypes[i].NameOffset, prototypes[i].NameLength);
+
+		prototype.Spheres.resize(prototypes[i].SphereCount);
+		for (uint64_t j = 0; j < prototypes[i].SphereCount; j++) {
+			Utils::ReadSphere(prototype.Spheres[j], prototypeSpheres[prototypes[i].FirstSphere + j]);
+		}
+	}
+
+	const Utils::InstanceRecord* instances = (const Utils::InstanceRecord*)(data + header.Instances.Offset);
+	m_Scene.Instances.resize(header.Instances.Count);
+	for (uint64_t i = 0; i < header.Instances.Count; i++) {
+		Instance& instance = m_Scene.Instances[i];
+		instance.Enabled = (instances[i].Flags & Utils::s_EnabledFlag) != 0;
+		instance.PrototypeIndex = instances[i].PrototypeIndex;
+		instance.Position = Utils::ReadVec3(instances[i].Position);
+		instance.Rotation = Utils::ReadVec3(instances[i].Rotation);
+		instance.Scale = Utils::ReadVec3(instances[i].Scale);
+		instance.MaterialIndex = instances[i].MaterialIndex;
+	}
+
+	m_Scene.Meshes.resize(header.Meshes.Count);
+	for (uint64_t i = 0; i < header.Meshes.Count; i++) {
+		Mesh& mesh = m_Scene.Meshes[i];
+		mesh.Enabled = (meshes[i].Flags & Utils::s_EnabledFlag) != 0;
+		mesh.Filepath.assign(strings + meshes[i].FilepathOffset, meshes[i].FilepathLength);
+		mesh.Position = Utils::ReadVec3(meshes[i].Position);
+		mesh.Rotation = Utils::ReadVec3(meshes[i].Rotation);
+		mesh.Scale = Utils::ReadVec3(meshes[i].Scale);
+		mesh.MaterialIndex = meshes[i].MaterialIndex;
+		mesh.Geometry = nullptr;
+	}
+
+	m_Scene.MarkAllChanged();
+
+	spdlog::info("SceneBinarySerializer - Loading complete");
+
+	return true;
+}
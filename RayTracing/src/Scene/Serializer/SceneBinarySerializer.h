@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../Scene.h"
+
+#include <filesystem>
+#include <cstdint>
+
+// Binary counterpart of SceneSerializer for large scenes. The file is a fixed header followed by flat
+// arrays of fixed size records (lights, spheres, materials, prototypes, the spheres of all prototypes one
+// after the other, instances, mesh references) and a string table for the names and mesh paths, each array
+// starting on a 64 byte boundary. Loading maps the file and converts the records in a single pass, there
+// is no parsing and no intermediate document in memory.
+//
+// Values are stored in the byte order of the writer, files from a machine with the other byte order are
+// rejected, as are files with another version. Bump s_Version whenever a record layout changes.
+class SceneBinarySerializer {
+public:
+	static constexpr const char* s_Extension = ".rtscene";
+	static constexpr uint32_t s_Version = 3;
+public:
+	SceneBinarySerializer(Scene& scene);
+
+	bool Serialize(const std::filesystem::path& filepath);
+	bool Deserialize(const std::filesystem::path& filepath);
+
+	static bool IsBinaryScene(const std::filesystem::path& filepath) { return filepath.extension() == s_Extension; }
+private:
+	Scene& m_Scene;
+};
@@ -1,6 +1,6 @@
 #include "SceneSerializer.h"
 
-#include "Walnut/Core/Log.h"
+#include <spdlog/spdlog.h>
 
 #include <fstream>
 
@@ -54,7 +54,10 @@ bool SceneSerializer::Serialize(const std::filesystem::path & filepath) {
 				SerializeSky(out);
 				SerializeLights(out);
 				SerializeSpheres(out);
-				SerializeMaterials(out);			
+				SerializeMaterials(out);
+				SerializePrototypes(out);
+				SerializeInstances(out);
+				SerializeMeshes(out);
 			}
 			out << YAML::EndMap; // Scene
 		}
@@ -108,6 +111,36 @@ void SceneSerializer::SerializeMaterials(YAML::Emitter& out) {
 	out << YAML::EndSeq;
 }
 
+void SceneSerializer::SerializePrototypes(YAML::Emitter& out) {
+	spdlog::info("SceneSerializer - Saving Prototypes");
+
+	out << YAML::Key << "Prototypes" << YAML::Value << YAML::BeginSeq;
+	for (const Prototype& prototype : m_Scene.Prototypes) {
+		SerializePrototype(out, prototype);
+	}
+	out << YAML::EndSeq;
+}
+
+void SceneSerializer::SerializeInstances(YAML::Emitter& out) {
+	spdlog::info("SceneSerializer - Saving Instances");
+
+	out << YAML::Key << "Instances" << YAML::Value << YAML::BeginSeq;
+	for (const Instance& instance : m_Scene.Instances) {
+		SerializeInstance(out, instance);
+	}
+	out << YAML::EndSeq;
+}
+
+void SceneSerializer::SerializeMeshes(YAML::Emitter& out) {
+	spdlog::info("SceneSerializer - Saving Meshes");
+
+	out << YAML::Key << "Meshes" << YAML::Value << YAML::BeginSeq;
+	for (const Mesh& mesh : m_Scene.Meshes) {
+		SerializeMesh(out, mesh);
+	}
+	out << YAML::EndSeq;
+}
+
 void SceneSerializer::SerializeLight(YAML::Emitter& out, const Light& light) {
 	out << YAML::BeginMap;
 	out << YAML::Key << "Light" << YAML::Value;
@@ -144,12 +177,55 @@ void SceneSerializer::SerializeMaterial(YAML::Emitter& out, const Material& mate
 	out << YAML::EndMap;
 }
 
+void SceneSerializer::SerializePrototype(YAML::Emitter& out, const Prototype& prototype) {
+	out << YAML::BeginMap;
+	out << YAML::Key << "Prototype" << YAML::Value;
+	out << YAML::BeginMap;
+	out << YAML::Key << "Name" << YAML::Value << prototype.Name;
+	out << YAML::Key << "Spheres" << YAML::Value << YAML::BeginSeq;
+	for (const Sphere& sphere : prototype.Spheres) {
+		SerializeSphere(out, sphere);
+	}
+	out << YAML::EndSeq;
+	out << YAML::EndMap;
+	out << YAML::EndMap;
+}
+
+void SceneSerializer::SerializeInstance(YAML::Emitter& out, const Instance& instance) {
+	out << YAML::BeginMap;
+	out << YAML::Key << "Instance" << YAML::Value;
+	out << YAML::BeginMap;
+	out << YAML::Key << "Enabled" << YAML::Value << instance.Enabled;
+	out << YAML::Key << "PrototypeIndex" << YAML::Value << instance.PrototypeIndex;
+	out << YAML::Key << "Position" << YAML::Value << instance.Position;
+	out << YAML::Key << "Rotation" << YAML::Value << instance.Rotation;
+	out << YAML::Key << "Scale" << YAML::Value << instance.Scale;
+	out << YAML::Key << "MaterialIndex" << YAML::Value << instance.MaterialIndex;
+	out << YAML::EndMap;
+	out << YAML::EndMap;
+}
+
+void SceneSerializer::SerializeMesh(YAML::Emitter& out, const Mesh& mesh) {
+	// Only the reference, the geometry stays in its own file
+	out << YAML::BeginMap;
+	out << YAML::Key << "Mesh" << YAML::Value;
+	out << YAML::BeginMap;
+	out << YAML::Key << "Enabled" << YAML::Value << mesh.Enabled;
+	out << YAML::Key << "Filepath" << YAML::Value << mesh.Filepath;
+	out << YAML::Key << "Position" << YAML::Value << mesh.Position;
+	out << YAML::Key << "Rotation" << YAML::Value << mesh.Rotation;
+	out << YAML::Key << "Scale" << YAML::Value << mesh.Scale;
+	out << YAML::Key << "MaterialIndex" << YAML::Value << mesh.MaterialIndex;
+	out << YAML::EndMap;
+	out << YAML::EndMap;
+}
+
 bool SceneSerializer::Deserialize(const std::filesystem::path& filepath) {
 	YAML::Node data;
 	try {
-		spdlog::info("SceneSerializer - Attempting to read Scene file: {0}", filepath);
+		spdlog::info("SceneSerializer - Attempting to read Scene file: {0}", filepath.string());
 		data = YAML::LoadFile(filepath.string());
-	} catch (YAML::Exception e) {
+	} catch (const YAML::Exception& e) {
 		spdlog::error("SceneSerializer - Error reading Scene file: {0}", e.msg);
 		return false;
 	}
@@ -167,11 +243,19 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath) {
 	m_Scene.Lights.clear();
 	m_Scene.Spheres.clear();
 	m_Scene.Materials.clear();
+	m_Scene.Prototypes.clear();
+	m_Scene.Instances.clear();
+	m_Scene.Meshes.clear();
 
 	DeserializeSky(sceneNode);
 	DeserializeLights(sceneNode);
 	DeserializeSpheres(sceneNode);
 	DeserializeMaterials(sceneNode);
+	DeserializePrototypes(sceneNode);
+	DeserializeInstances(sceneNode);
+	DeserializeMeshes(sceneNode);
+
+	m_Scene.MarkAllChanged();
 
 	spdlog::info("SceneSerializer - Loading complete");
 
@@ -179,7 +263,7 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath) {
 }
 
 void SceneSerializer::DeserializeSky(YAML::Node& sceneNode) {
-	auto& skyNode = sceneNode["Sky"];
+	auto skyNode = sceneNode["Sky"];
 	if (skyNode) {
 		spdlog::info("SceneSerializer - Loading Sky");
 		m_Scene.Sky.Enabled = skyNode["Enabled"].as<bool>();
@@ -188,45 +272,75 @@ void SceneSerializer::DeserializeSky(YAML::Node& sceneNode) {
 }
 
 void SceneSerializer::DeserializeLights(YAML::Node& sceneNode) {
-	auto& lightsNode = sceneNode["Lights"];
+	auto lightsNode = sceneNode["Lights"];
 	if (lightsNode) {
 		spdlog::info("SceneSerializer - Loading Lights");
-		for (auto& lightNode : lightsNode) {
+		for (auto lightNode : lightsNode) {
 			DeserializeLight(lightNode);
 		}
 	}
 }
 
 void SceneSerializer::DeserializeSpheres(YAML::Node& sceneNode) {
-	auto& spheresNode = sceneNode["Spheres"];
+	auto spheresNode = sceneNode["Spheres"];
 	if (spheresNode) {
 		spdlog::info("SceneSerializer - Loading Spheres");
-		for (auto& sphereNode : spheresNode) {
-			DeserializeSphere(sphereNode);
+		for (auto sphereNode : spheresNode) {
+			DeserializeSphere(sphereNode, m_Scene.Spheres);
 		}
 	}
 }
 
 void SceneSerializer::DeserializeMaterials(YAML::Node& sceneNode) {
-	auto& materialsNode = sceneNode["Materials"];
+	auto materialsNode = sceneNode["Materials"];
 	if (materialsNode) {
 		spdlog::info("SceneSerializer - Loading Materials");
-		for (auto& materialNode : materialsNode) {
+		for (auto materialNode : materialsNode) {
 			DeserializeMaterial(materialNode);
 		}
 	}
 }
 
+void SceneSerializer::DeserializePrototypes(YAML::Node& sceneNode) {
+	auto prototypesNode = sceneNode["Prototypes"];
+	if (prototypesNode) {
+		spdlog::info("SceneSerializer - Loading Prototypes");
+		for (auto prototypeNode : prototypesNode) {
+			DeserializePrototype(prototypeNode);
+		}
+	}
+}
+
+void SceneSerializer::DeserializeInstances(YAML::Node& sceneNode) {
+	auto instancesNode = sceneNode["Instances"];
+	if (instancesNode) {
+		spdlog::info("SceneSerializer - Loading Instances");
+		for (auto instanceNode : instancesNode) {
+			DeserializeInstance(instanceNode);
+		}
+	}
+}
+
+void SceneSerializer::DeserializeMeshes(YAML::Node& sceneNode) {
+	auto meshesNode = sceneNode["Meshes"];
+	if (meshesNode) {
+		spdlog::info("SceneSerializer - Loading Meshes");
+		for (auto meshNode : meshesNode) {
+			DeserializeMesh(meshNode);
+		}
+	}
+}
+
 void SceneSerializer::DeserializeLight(YAML::Node& lightNode) {
-	auto& light = lightNode["Light"];
+	auto light = lightNode["Light"];
 	Light& newLight = m_Scene.Lights.emplace_back();
 	newLight.Enabled = light["Enabled"].as<bool>();
 	newLight.Position = light["Position"].as<glm::vec3>();
 }
 
-void SceneSerializer::DeserializeSphere(YAML::Node& sphereNode) {
-	auto& sphere = sphereNode["Sphere"];
-	Sphere& newSphere = m_Scene.Spheres.emplace_back();
+void SceneSerializer::DeserializeSphere(YAML::Node& sphereNode, std::vector<Sphere>& spheres) {
+	auto sphere = sphereNode["Sphere"];
+	Sphere& newSphere = spheres.emplace_back();
 	newSphere.Enabled = sphere["Enabled"].as<bool>();
 	newSphere.Position = sphere["Position"].as<glm::vec3>();
 	newSphere.Radius = sphere["Radius"].as<float>();
@@ -234,7 +348,7 @@ void SceneSerializer::DeserializeSphere(YAML::Node& sphereNode) {
 }
 
 void SceneSerializer::DeserializeMaterial(YAML::Node& materialNode) {
-	auto& material = materialNode["Material"];
+	auto material = materialNode["Material"];
 	Material& newMaterial = m_Scene.Materials.emplace_back();
 	newMaterial.Name = material["Name"].as<std::string>();
 	newMaterial.Albedo = material["Albedo"].as<glm::vec3>();
@@ -243,3 +357,38 @@ void SceneSerializer::DeserializeMaterial(YAML::Node& materialNode) {
 	newMaterial.EmissionColor = material["EmissionColor"].as<glm::vec3>();
 	newMaterial.EmissionPower = material["EmissionPower"].as<float>();
 }
+
+void SceneSerializer::DeserializePrototype(YAML::Node& prototypeNode) {
+	auto prototype = prototypeNode["Prototype"];
+	Prototype& newPrototype = m_Scene.Prototypes.emplace_back();
+	newPrototype.Name = prototype["Name"].as<std::string>();
+
+	auto spheresNode = prototype["Spheres"];
+	if (spheresNode) {
+		for (auto sphereNode : spheresNode) {
+			DeserializeSphere(sphereNode, newPrototype.Spheres);
+		}
+	}
+}
+
+void SceneSerializer::DeserializeInstance(YAML::Node& instanceNode) {
+	auto instance = instanceNode["Instance"];
+	Instance& newInstance = m_Scene.Instances.emplace_back();
+	newInstance.Enabled = instance["Enabled"].as<bool>();
+	newInstance.PrototypeIndex = instance["PrototypeIndex"].as<int>();
+	newInstance.Position = instance["Position"].as<glm::vec3>();
+	newInstance.Rotation = instance["Rotation"].as<glm::vec3>();
+	newInstance.Scale = instance["Scale"].as<glm::vec3>();
+	newInstance.MaterialIndex = instance["MaterialIndex"].as<int>();
+}
+
+void SceneSerializer::DeserializeMesh(YAML::Node& meshNode) {
+	auto mesh = meshNode["Mesh"];
+	Mesh& newMesh = m_Scene.Meshes.emplace_back();
+	newMesh.Enabled = mesh["Enabled"].as<bool>();
+	newMesh.Filepath = mesh["Filepath"].as<std::string>();
+	newMesh.Position = mesh["Position"].as<glm::vec3>();
+	newMesh.Rotation = mesh["Rotation"].as<glm::vec3>();
+	newMesh.Scale = mesh["Scale"].as<glm::vec3>();
+	newMesh.MaterialIndex = mesh["MaterialIndex"].as<int>();
+}
\ No newline at end of file
@@ -17,19 +17,31 @@ private:
 	void SerializeLights(YAML::Emitter& out);
 	void SerializeSpheres(YAML::Emitter& out);
 	void SerializeMaterials(YAML::Emitter& out);
+	void SerializePrototypes(YAML::Emitter& out);
+	void SerializeInstances(YAML::Emitter& out);
+	void SerializeMeshes(YAML::Emitter& out);
 
 	void SerializeLight(YAML::Emitter& out, const Light& light);
 	void SerializeSphere(YAML::Emitter& out, const Sphere& sphere);
 	void SerializeMaterial(YAML::Emitter& out, const Material& material);
+	void SerializePrototype(YAML::Emitter& out, const Prototype& prototype);
+	void SerializeInstance(YAML::Emitter& out, const Instance& instance);
+	void SerializeMesh(YAML::Emitter& out, const Mesh& mesh);
 
 	void DeserializeSky(YAML::Node& sceneNode);
 	void DeserializeLights(YAML::Node& sceneNode);
 	void DeserializeSpheres(YAML::Node& sceneNode);
 	void DeserializeMaterials(YAML::Node& sceneNode);
+	void DeserializePrototypes(YAML::Node& sceneNode);
+	void DeserializeInstances(YAML::Node& sceneNode);
+	void DeserializeMeshes(YAML::Node& sceneNode);
 
 	void DeserializeLight(YAML::Node& lightNode);
-	void DeserializeSphere(YAML::Node& sphereNode);
+	void DeserializeSphere(YAML::Node& sphereNode, std::vector<Sphere>& spheres);
 	void DeserializeMaterial(YAML::Node& materialNode);
+	void DeserializePrototype(YAML::Node& prototypeNode);
+	void DeserializeInstance(YAML::Node& instanceNode);
+	void DeserializeMesh(YAML::Node& meshNode);
 private:
 	Scene& m_Scene;
 };
\ No newline at end of file
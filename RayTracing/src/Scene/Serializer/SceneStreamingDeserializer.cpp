@@ -0,0 +1,438 @@
+#include "SceneStreamingDeserializer.h"
+
+#include <yaml-cpp/yaml.h>
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <string_view>
+#include <iterator>
+#include <cstdlib>
+#include <cstring>
+
+namespace Utils {
+	static bool ParseBool(const std::string& value, bool fallback) {
+		// SceneSerializer always writes these two, anything else goes through yaml-cpp's own rules
+		if (value == "true") {
+			return true;
+		}
+		if (value == "false") {
+			return false;
+		}
+
+		return YAML::Node(value).as<bool>(fallback);
+	}
+
+	static float ParseFloat(const std::string& value, float fallback) {
+		char* end = nullptr;
+		float result = std::strtof(value.c_str(), &end);
+		return end != value.c_str() ? result : fallback;
+	}
+
+	static int ParseInt(const std::string& value, int fallback) {
+		char* end = nullptr;
+		long result = std::strtol(value.c_str(), &end, 10);
+		return end != value.c_str() ? (int)result : fallback;
+	}
+
+	// Counts the entry keys with a plain text search, which is much cheaper than parsing. A name that
+	// happens to contain one of the keys only makes the reservation a little larger, and so do the spheres of prototypes.
+	static void CountEntries(const std::filesystem::path& filepath, size_t& lightCount, size_t& sphereCount, size_t& materialCount, size_t& instanceCount, size_t& meshCount) {
+		static constexpr std::string_view s_Keys[] = { "Light:", "Sphere:", "Material:", "Instance:", "Mesh:" };
+		static constexpr size_t s_Overlap = 8; // Longest key minus one, so keys split between chunks are found once
+		static constexpr size_t s_ChunkSize = 1 << 20;
+
+		size_t* counts[] = { &lightCount, &sphereCount, &materialCount, &instanceCount, &meshCount };
+		lightCount = sphereCount = materialCount = instanceCount = meshCount = 0;
+
+		std::ifstream fin(filepath, std::ios::binary);
+		std::string buffer(s_ChunkSize + s_Overlap, '\0');
+		size_t carried = 0;
+
+		while (fin) {
+			fin.read(buffer.data() + carried, s_ChunkSize);
+			size_t size = carried + (size_t)fin.gcount();
+
+			std::string_view chunk(buffer.data(), size);
+			for (size_t i = 0; i < std::size(s_Keys); i++) {
+				for (size_t position = chunk.find(s_Keys[i]); position != std::string_view::npos; position = chunk.find(s_Keys[i], position + 1)) {
+					// Matches that start in the carried over bytes were counted with the previous chunk
+					if (position + s_Keys[i].size() > carried) {
+						(*counts[i])++;
+					}
+				}
+			}
+
+			carried = glm::min(size, s_Overlap);
+			memmove(buffer.data(), buffer.data() + size - carried, carried);
+		}
+	}
+}
+
+SceneStreamingDeserializer::SceneStreamingDeserializer(Scene& scene)
+	: m_Scene(scene)
+{}
+
+bool SceneStreamingDeserializer::Deserialize(const std::filesystem::path& filepath) {
+	spdlog::info("SceneStreamingDeserializer - Attempting to read Scene file: {0}", filepath.string());
+
+	std::ifstream fin(filepath);
+	if (!fin) {
+		spdlog::error("SceneStreamingDeserializer - Could not open Scene file: {0}", filepath.string());
+		return false;
+	}
+
+	m_LoadingScene = Scene();
+	m_Stack.clear();
+	m_FoundScene = false;
+	m_LoadingSpheres = nullptr;
+
+	ReserveCapacity(filepath);
+
+	try {
+		YAML::Parser parser(fin);
+		parser.HandleNextDocument(*this);
+	} catch (const YAML::Exception& e) {
+		spdlog::error("SceneStreamingDeserializer - Error reading Scene file: {0}", e.msg);
+		return false;
+	}
+
+	if (!m_FoundScene) {
+		spdlog::error("SceneStreamingDeserializer - No Scene in file: {0}", filepath.string());
+		return false;
+	}
+
+	spdlog::info("SceneStreamingDeserializer - Loaded Scene: {0}", m_LoadingScene.Name);
+
+	m_Scene.Name = std::move(m_LoadingScene.Name);
+	m_Scene.Sky = m_LoadingScene.Sky;
+	m_Scene.Lights = std::move(m_LoadingScene.Lights);
+	m_Scene.Spheres = std::move(m_LoadingScene.Spheres);
+	m_Scene.Materials = std::move(m_LoadingScene.Materials);
+	m_Scene.Prototypes = std::move(m_LoadingScene.Prototypes);
+	m_Scene.Instances = std::move(m_LoadingScene.Instances);
+	m_Scene.Meshes = std::move(m_LoadingScene.Meshes);
+	m_Scene.MarkAllChanged();
+
+	m_LoadingScene = Scene();
+
+	return true;
+}
+
+void SceneStreamingDeserializer::ReserveCapacity(const std::filesystem::path& filepath) {
+	size_t lightCount, sphereCount, materialCount, instanceCount, meshCount;
+	Utils::CountEntries(filepath, lightCount, sphereCount, materialCount, instanceCount, meshCount);
+
+	m_LoadingScene.Lights.reserve(lightCount);
+	m_LoadingScene.Spheres.reserve(sphereCount);
+	m_LoadingScene.Materials.reserve(materialCount);
+	m_LoadingScene.Instances.reserve(instanceCount);
+	m_LoadingScene.Meshes.reserve(meshCount);
+}
+
+void SceneStreamingDeserializer::OnDocumentStart(const YAML::Mark& /*mark*/) {}
+
+void SceneStreamingDeserializer::OnDocumentEnd() {}
+
+void SceneStreamingDeserializer::OnNull(const YAML::Mark& /*mark*/, YAML::anchor_t /*anchor*/) {
+	if (m_Stack.empty()) {
+		return;
+	}
+
+	// An empty value (e.g. "Lights:" with nothing after it) keeps the defaults
+	Frame& frame = m_Stack.back();
+	if (frame.IsMap) {
+		frame.Key.clear();
+		frame.ExpectingKey = !frame.ExpectingKey;
+	}
+}
+
+void SceneStreamingDeserializer::OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor) {
+	// SceneSerializer never writes anchors, resolving them would mean keeping the anchored nodes around
+	spdlog::warn("SceneStreamingDeserializer - Aliases are not supported, ignoring alias at line {0}", mark.line + 1);
+	OnNull(mark, anchor);
+}
+
+void SceneStreamingDeserializer::OnScalar(const YAML::Mark& /*mark*/, const std::string& /*tag*/, YAML::anchor_t /*anchor*/, const std::string& value) {
+	if (m_Stack.empty()) {
+		return;
+	}
+
+	Frame& frame = m_Stack.back();
+	if (!frame.IsMap) {
+		if (frame.Type == State::Vector && frame.Component < 3) {
+			(*frame.Vector)[frame.Component++] = Utils::ParseFloat(value, 0.0f);
+		}
+		return;
+	}
+
+	if (frame.ExpectingKey) {
+		frame.Key = value;
+		frame.ExpectingKey = false;
+	} else {
+		OnValue(value);
+		frame.ExpectingKey = true;
+	}
+}
+
+void SceneStreamingDeserializer::OnSequenceStart(const YAML::Mark& /*mark*/, const std::string& /*tag*/, YAML::anchor_t /*anchor*/, YAML::EmitterStyle::value /*style*/) {
+	m_Stack.push_back(CreateChildFrame(false));
+}
+
+void SceneStreamingDeserializer::OnSequenceEnd() {
+	OnContainerEnd();
+}
+
+void SceneStreamingDeserializer::OnMapStart(const YAML::Mark& /*mark*/, const std::string& /*tag*/, YAML::anchor_t /*anchor*/, YAML::EmitterStyle::value /*style*/) {
+	m_Stack.push_back(CreateChildFrame(true));
+}
+
+void SceneStreamingDeserializer::OnMapEnd() {
+	OnContainerEnd();
+}
+
+SceneStreamingDeserializer::Frame SceneStreamingDeserializer::CreateChildFrame(bool isMap) {
+	Frame child;
+	child.IsMap = isMap;
+
+	if (m_Stack.empty()) {
+		child.Type = isMap ? State::Root : State::Skip;
+		return child;
+	}
+
+	const Frame& parent = m_Stack.back();
+	const std::string& key = parent.Key;
+
+	// Entries of the Lights, Spheres, Materials, Prototypes, Instances and Meshes sequences are maps with a single key
+	switch (parent.Type) {
+		case State::Root:
+			if (isMap && key == "Scene") {
+				child.Type = State::Scene;
+				m_FoundScene = true;
+			}
+			break;
+		case State::Scene:
+			if (isMap && key == "Sky") {
+				child.Type = State::Sky;
+			} else if (!isMap && key == "Lights") {
+				child.Type = State::Lights;
+			} else if (!isMap && key == "Spheres") {
+				child.Type = State::Spheres;
+				m_LoadingSpheres = &m_LoadingScene.Spheres;
+			} else if (!isMap && key == "Materials") {
+				child.Type = State::Materials;
+			} else if (!isMap && key == "Prototypes") {
+				child.Type = State::Prototypes;
+			} else if (!isMap && key == "Instances") {
+				child.Type = State::Instances;
+			} else if (!isMap && key == "Meshes") {
+				child.Type = State::Meshes;
+			}
+			break;
+		case State::Sky:
+			if (!isMap && key == "Color") {
+				child.Type = State::Vector;
+				child.Vector = &m_LoadingScene.Sky.Color;
+			}
+			break;
+		case State::Lights:
+			child.Type = isMap ? State::LightEntry : State::Skip;
+			break;
+		case State::LightEntry:
+			if (isMap && key == "Light") {
+				m_LoadingScene.Lights.emplace_back();
+				child.Type = State::Light;
+			}
+			break;
+		case State::Light:
+			if (!isMap && key == "Position") {
+				child.Type = State::Vector;
+				child.Vector = &m_LoadingScene.Lights.back().Position;
+			}
+			break;
+		case State::Spheres:
+			child.Type = isMap ? State::SphereEntry : State::Skip;
+			break;
+		case State::SphereEntry:
+			if (isMap && key == "Sphere") {
+				m_LoadingSpheres->emplace_back();
+				child.Type = State::Sphere;
+			}
+			break;
+		case State::Sphere:
+			if (!isMap && key == "Position") {
+				child.Type = State::Vector;
+				child.Vector = &m_LoadingSpheres->back().Position;
+			}
+			break;
+		case State::Materials:
+			child.Type = isMap ? State::MaterialEntry : State::Skip;
+			break;
+		case State::MaterialEntry:
+			if (isMap && key == "Material") {
+				m_LoadingScene.Materials.emplace_back();
+				child.Type = State::Material;
+			}
+			break;
+		case State::Material:
+			if (!isMap && key == "Albedo") {
+				child.Type = State::Vector;
+				child.Vector = &m_LoadingScene.Materials.back().Albedo;
+			} else if (!isMap && key == "EmissionColor") {
+				child.Type = State::Vector;
+				child.Vector = &m_LoadingScene.Materials.back().EmissionColor;
+			}
+			break;
+		case State::Prototypes:
+			child.Type = isMap ? State::PrototypeEntry : State::Skip;
+			break;
+		case State::PrototypeEntry:
+			if (isMap && key == "Prototype") {
+				m_LoadingScene.Prototypes.emplace_back();
+				child.Type = State::Prototype;
+			}
+			break;
+		case State::Prototype:
+			if (!isMap && key == "Spheres") {
+				child.Type = State::Spheres;
+				m_LoadingSpheres = &m_LoadingScene.Prototypes.back().Spheres;
+			}
+			break;
+		case State::Instances:
+			child.Type = isMap ? State::InstanceEntry : State::Skip;
+			break;
+		case State::InstanceEntry:
+			if (isMap && key == "Instance") {
+				m_LoadingScene.Instances.emplace_back();
+				child.Type = State::Instance;
+			}
+			break;
+		case State::Instance: {
+			Instance& instance = m_LoadingScene.Instances.back();
+			if (!isMap && key == "Position") {
+				child.Type = State::Vector;
+				child.Vector = &instance.Position;
+			} else if (!isMap && key == "Rotation") {
+				child.Type = State::Vector;
+				child.Vector = &instance.Rotation;
+			} else if (!isMap && key == "Scale") {
+				child.Type = State::Vector;
+				child.Vector = &instance.Scale;
+			}
+			break;
+		}
+		case State::Meshes:
+			child.Type = isMap ? State::MeshEntry : State::Skip;
+			break;
+		case State::MeshEntry:
+			if (isMap && key == "Mesh") {
+				m_LoadingScene.Meshes.emplace_back();
+				child.Type = State::Mesh;
+			}
+			break;
+		case State::Mesh: {
+			Mesh& mesh = m_LoadingScene.Meshes.back();
+			if (!isMap && key == "Position") {
+				child.Type = State::Vector;
+				child.Vector = &mesh.Position;
+			} else if (!isMap && key == "Rotation") {
+				child.Type = State::Vector;
+				child.Vector = &mesh.Rotation;
+			} else if (!isMap && key == "Scale") {
+				child.Type = State::Vector;
+				child.Vector = &mesh.Scale;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+
+	return child;
+}
+
+void SceneStreamingDeserializer::OnValue(const std::string& value) {
+	const Frame& frame = m_Stack.back();
+	const std::string& key = frame.Key;
+
+	switch (frame.Type) {
+		case State::Scene:
+			if (key == "Name") {
+				m_LoadingScene.Name = value;
+			}
+			break;
+		case State::Sky:
+			if (key == "Enabled") {
+				m_LoadingScene.Sky.Enabled = Utils::ParseBool(value, m_LoadingScene.Sky.Enabled);
+			}
+			break;
+		case State::Light: {
+			Light& light = m_LoadingScene.Lights.back();
+			if (key == "Enabled") {
+				light.Enabled = Utils::ParseBool(value, light.Enabled);
+			}
+			break;
+		}
+		case State::Sphere: {
+			Sphere& sphere = m_LoadingSpheres->back();
+			if (key == "Enabled") {
+				sphere.Enabled = Utils::ParseBool(value, sphere.Enabled);
+			} else if (key == "Radius") {
+				sphere.Radius = Utils::ParseFloat(value, sphere.Radius);
+			} else if (key == "MaterialIndex") {
+				sphere.MaterialIndex = Utils::ParseInt(value, sphere.MaterialIndex);
+			}
+			break;
+		}
+		case State::Material: {
+			Material& material = m_LoadingScene.Materials.back();
+			if (key == "Name") {
+				material.Name = value;
+			} else if (key == "Roughness") {
+				material.Roughness = Utils::ParseFloat(value, material.Roughness);
+			} else if (key == "Metallic") {
+				material.Metallic = Utils::ParseFloat(value, material.Metallic);
+			} else if (key == "EmissionPower") {
+				material.EmissionPower = Utils::ParseFloat(value, material.EmissionPower);
+			}
+			break;
+		}
+		case State::Prototype:
+			if (key == "Name") {
+				m_LoadingScene.Prototypes.back().Name = value;
+			}
+			break;
+		case State::Instance: {
+			Instance& instance = m_LoadingScene.Instances.back();
+			if (key == "Enabled") {
+				instance.Enabled = Utils::ParseBool(value, instance.Enabled);
+			} else if (key == "PrototypeIndex") {
+				instance.PrototypeIndex = Utils::ParseInt(value, instance.PrototypeIndex);
+			} else if (key == "MaterialIndex") {
+				instance.MaterialIndex = Utils::ParseInt(value, instance.MaterialIndex);
+			}
+			break;
+		}
+		case State::Mesh: {
+			Mesh& mesh = m_LoadingScene.Meshes.back();
+			if (key == "Enabled") {
+				mesh.Enabled = Utils::ParseBool(value, mesh.Enabled);
+			} else if (key == "Filepath") {
+				mesh.Filepath = value;
+			} else if (key == "MaterialIndex") {
+				mesh.MaterialIndex = Utils::ParseInt(value, mesh.MaterialIndex);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void SceneStreamingDeserializer::OnContainerEnd() {
+	m_Stack.pop_back();
+
+	// The container was the value of the parent's current key
+	if (!m_Stack.empty() && m_Stack.back().IsMap) {
+		m_Stack.back().ExpectingKey = true;
+	}
+}
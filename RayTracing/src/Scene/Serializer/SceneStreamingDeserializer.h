@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../Scene.h"
+
+#include <yaml-cpp/eventhandler.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Loads the YAML written by SceneSerializer from the parser's event stream instead of building a
+// YAML::Node tree first, so memory use stays at roughly the size of the Scene itself. Lights, spheres,
+// materials, prototypes, instances and mesh references are appended straight into the Scene, which is
+// reserved up front from a quick count of the entries in the file. Unknown keys are skipped, missing
+// keys keep their default values.
+class SceneStreamingDeserializer : private YAML::EventHandler {
+public:
+	SceneStreamingDeserializer(Scene& scene);
+
+	bool Deserialize(const std::filesystem::path& filepath);
+private:
+	enum class State {
+		Root, Scene, Skip,
+		Sky,
+		Lights, LightEntry, Light,
+		Spheres, SphereEntry, Sphere,
+		Materials, MaterialEntry, Material,
+		Prototypes, PrototypeEntry, Prototype,
+		Instances, InstanceEntry, Instance,
+		Meshes, MeshEntry, Mesh,
+		Vector
+	};
+
+	struct Frame {
+		State Type = State::Skip;
+		bool IsMap = false;
+		bool ExpectingKey = true;
+		std::string Key;
+
+		// Only used by State::Vector
+		glm::vec3* Vector = nullptr;
+		int Component = 0;
+	};
+private:
+	virtual void OnDocumentStart(const YAML::Mark& mark) override;
+	virtual void OnDocumentEnd() override;
+
+	virtual void OnNull(const YAML::Mark& mark, YAML::anchor_t anchor) override;
+	virtual void OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor) override;
+	virtual void OnScalar(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor, const std::string& value) override;
+
+	virtual void OnSequenceStart(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value style) override;
+	virtual void OnSequenceEnd() override;
+
+	virtual void OnMapStart(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value style) override;
+	virtual void OnMapEnd() override;
+
+	// Decides what a map or sequence that starts at the current position holds
+	Frame CreateChildFrame(bool isMap);
+	void OnValue(const std::string& value);
+	void OnContainerEnd();
+
+	void ReserveCapacity(const std::filesystem::path& filepath);
+private:
+	Scene& m_Scene;
+
+	// Filled while parsing and moved into m_Scene once the whole file parsed, so a broken file leaves m_Scene untouched
+	Scene m_LoadingScene;
+	std::vector<Frame> m_Stack;
+	bool m_FoundScene = false;
+
+	// The scene's spheres or those of the prototype being read, sphere entries are appended here
+	std::vector<Sphere>* m_LoadingSpheres = nullptr;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+	#include <malloc.h>
+#endif
+
+// Allocator for std::vector that returns memory aligned to Alignment bytes, so SIMD code can use aligned loads
+template<typename T, size_t Alignment>
+class AlignedAllocator {
+public:
+	using value_type = T;
+
+	template<typename U>
+	struct rebind {
+		using other = AlignedAllocator<U, Alignment>;
+	};
+public:
+	AlignedAllocator() = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(size_t count) {
+		size_t size = (count * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+
+#ifdef _MSC_VER
+		void* memory = _aligned_malloc(size, Alignment);
+#else
+		void* memory = std::aligned_alloc(Alignment, size);
+#endif
+
+		if (!memory) {
+			throw std::bad_alloc();
+		}
+
+		return static_cast<T*>(memory);
+	}
+
+	void deallocate(T* memory, size_t) {
+#ifdef _MSC_VER
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+	template<typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
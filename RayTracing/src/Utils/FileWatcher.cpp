@@ -0,0 +1,217 @@
+#include "FileWatcher.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+
+#if defined(WL_PLATFORM_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+#elif defined(__linux__)
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+FileWatcher::~FileWatcher() {
+	Stop();
+}
+
+#if defined(WL_PLATFORM_WINDOWS)
+
+bool FileWatcher::Watch(const std::filesystem::path& filepath, const Callback& callback) {
+	Stop();
+
+	std::filesystem::path directory = std::filesystem::absolute(filepath).parent_path();
+
+	HANDLE directoryHandle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+	if (directoryHandle == INVALID_HANDLE_VALUE) {
+		spdlog::warn("FileWatcher - Could not watch directory: {0}", directory.string());
+		return false;
+	}
+
+	m_DirectoryHandle = directoryHandle;
+	m_StopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+	m_Filename = filepath.filename();
+	m_Callback = callback;
+
+	m_Running = true;
+	m_Thread = std::thread(&FileWatcher::WatchLoop, this);
+
+	return true;
+}
+
+void FileWatcher::Stop() {
+	if (!m_Running) {
+		return;
+	}
+
+	m_Running = false;
+	SetEvent(m_StopEvent);
+	m_Thread.join();
+
+	CloseHandle(m_DirectoryHandle);
+	CloseHandle(m_StopEvent);
+	m_DirectoryHandle = nullptr;
+	m_StopEvent = nullptr;
+}
+
+void FileWatcher::WatchLoop() {
+	alignas(DWORD) uint8_t buffer[4096];
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+	HANDLE events[] = { overlapped.hEvent, m_StopEvent };
+
+	while (m_Running) {
+		ResetEvent(overlapped.hEvent);
+
+		BOOL started = ReadDirectoryChangesW(m_DirectoryHandle, buffer, sizeof(buffer), FALSE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped, nullptr);
+
+		if (!started) {
+			spdlog::warn("FileWatcher - ReadDirectoryChangesW failed, no longer watching {0}", m_Filename.string());
+			break;
+		}
+
+		if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+			CancelIo(m_DirectoryHandle);
+			GetOverlappedResult(m_DirectoryHandle, &overlapped, nullptr, TRUE);
+			break;
+		}
+
+		DWORD bytesReturned = 0;
+		if (!GetOverlappedResult(m_DirectoryHandle, &overlapped, &bytesReturned, FALSE) || bytesReturned == 0) {
+			// The buffer overflowed, so assume the file might have changed
+			m_Callback();
+			continue;
+		}
+
+		bool changed = false;
+		for (uint8_t* entry = buffer;;) {
+			const FILE_NOTIFY_INFORMATION* information = (const FILE_NOTIFY_INFORMATION*)entry;
+			std::wstring filename(information->FileName, information->FileNameLength / sizeof(WCHAR));
+
+			if (filename == m_Filename.wstring()) {
+				changed = true;
+			}
+
+			if (information->NextEntryOffset == 0) {
+				break;
+			}
+			entry += information->NextEntryOffset;
+		}
+
+		if (changed) {
+			m_Callback();
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+#elif defined(__linux__)
+
+bool FileWatcher::Watch(const std::filesystem::path& filepath, const Callback& callback) {
+	Stop();
+
+	std::filesystem::path directory = std::filesystem::absolute(filepath).parent_path();
+
+	m_InotifyHandle = inotify_init1(IN_CLOEXEC);
+	if (m_InotifyHandle < 0 || inotify_add_watch(m_InotifyHandle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(m_StopPipe) != 0) {
+		spdlog::warn("FileWatcher - Could not watch directory: {0}", directory.string());
+
+		if (m_InotifyHandle >= 0) {
+			close(m_InotifyHandle);
+			m_InotifyHandle = -1;
+		}
+		return false;
+	}
+
+	m_Filename = filepath.filename();
+	m_Callback = callback;
+
+	m_Running = true;
+	m_Thread = std::thread(&FileWatcher::WatchLoop, this);
+
+	return true;
+}
+
+void FileWatcher::Stop() {
+	if (!m_Running) {
+		return;
+	}
+
+	m_Running = false;
+	char wake = 0;
+	(void)!write(m_StopPipe[1], &wake, 1);
+	m_Thread.join();
+
+	close(m_InotifyHandle);
+	close(m_StopPipe[0]);
+	close(m_StopPipe[1]);
+	m_InotifyHandle = -1;
+	m_StopPipe[0] = m_StopPipe[1] = -1;
+}
+
+void FileWatcher::WatchLoop() {
+	alignas(inotify_event) char buffer[4096];
+
+	pollfd descriptors[] = {
+		{ m_InotifyHandle, POLLIN, 0 },
+		{ m_StopPipe[0], POLLIN, 0 }
+	};
+
+	while (m_Running) {
+		if (poll(descriptors, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		if (descriptors[1].revents) {
+			break;
+		}
+
+		ssize_t length = read(m_InotifyHandle, buffer, sizeof(buffer));
+		if (length <= 0) {
+			continue;
+		}
+
+		bool changed = false;
+		for (char* entry = buffer; entry < buffer + length;) {
+			const inotify_event* event = (const inotify_event*)entry;
+
+			if (event->len > 0 && m_Filename == event->name) {
+				changed = true;
+			}
+
+			entry += sizeof(inotify_event) + event->len;
+		}
+
+		if (changed) {
+			m_Callback();
+		}
+	}
+}
+
+#else
+
+bool FileWatcher::Watch(const std::filesystem::path& filepath, const Callback& callback) {
+	spdlog::warn("FileWatcher - File watching is not supported on this platform: {0}", filepath.string());
+	return false;
+}
+
+void FileWatcher::Stop() {}
+
+void FileWatcher::WatchLoop() {}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+// Watches a single file for changes using the OS change notifications (ReadDirectoryChangesW on
+// Windows, inotify on Linux). The directory is watched rather than the file so editors that save
+// by writing a new file and renaming it over the old one are still picked up.
+class FileWatcher {
+public:
+	using Callback = std::function<void()>;
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// The callback runs on the watcher thread. Returns false if the directory cannot be watched
+	// or the platform has no change notifications, in which case the file is simply not watched.
+	bool Watch(const std::filesystem::path& filepath, const Callback& callback);
+	void Stop();
+private:
+	void WatchLoop();
+private:
+	std::filesystem::path m_Filename;
+	Callback m_Callback;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_Running = false;
+
+#if defined(WL_PLATFORM_WINDOWS)
+	void* m_DirectoryHandle = nullptr;
+	void* m_StopEvent = nullptr;
+#elif defined(__linux__)
+	int m_InotifyHandle = -1;
+	int m_StopPipe[2] = { -1, -1 };
+#endif
+};
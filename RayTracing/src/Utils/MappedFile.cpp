@@ -0,0 +1,124 @@
+#include "MappedFile.h"
+
+#include <spdlog/spdlog.h>
+
+#if defined(WL_PLATFORM_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#if defined(WL_PLATFORM_WINDOWS)
+
+bool MappedFile::Open(const std::filesystem::path& filepath) {
+	Close();
+
+	HANDLE fileHandle = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		spdlog::error("MappedFile - Could not open file: {0}", filepath.string());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		spdlog::error("MappedFile - File is empty or its size cannot be read: {0}", filepath.string());
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	if (!data) {
+		spdlog::error("MappedFile - Could not map file: {0}", filepath.string());
+		if (mappingHandle) {
+			CloseHandle(mappingHandle);
+		}
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	m_FileHandle = fileHandle;
+	m_MappingHandle = mappingHandle;
+	m_Data = (const uint8_t*)data;
+	m_Size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Close() {
+	if (!m_Data) {
+		return;
+	}
+
+	UnmapViewOfFile(m_Data);
+	CloseHandle(m_MappingHandle);
+	CloseHandle(m_FileHandle);
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_MappingHandle = nullptr;
+	m_FileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& filepath) {
+	Close();
+
+	int fileHandle = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fileHandle < 0) {
+		spdlog::error("MappedFile - Could not open file: {0}", filepath.string());
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileHandle, &fileStatus) != 0 || fileStatus.st_size == 0) {
+		spdlog::error("MappedFile - File is empty or its size cannot be read: {0}", filepath.string());
+		close(fileHandle);
+		return false;
+	}
+
+	size_t size = (size_t)fileStatus.st_size;
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+
+	// The mapping keeps its own reference to the file
+	close(fileHandle);
+
+	if (data == MAP_FAILED) {
+		spdlog::error("MappedFile - Could not map file: {0}", filepath.string());
+		return false;
+	}
+
+	// Loaders walk the arrays front to back, let the kernel read ahead
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	m_Data = (const uint8_t*)data;
+	m_Size = size;
+
+	return true;
+}
+
+void MappedFile::Close() {
+	if (!m_Data) {
+		return;
+	}
+
+	munmap((void*)m_Data, m_Size);
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+#endif
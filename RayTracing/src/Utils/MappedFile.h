@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. The contents are paged in by the OS on first access,
+// so nothing is read up front and the pages can be shared with other processes mapping the same file.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::filesystem::path& filepath);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+
+	// The mapping starts on a page boundary, so any offset that is aligned within the file is aligned in memory
+	const uint8_t* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+
+#if defined(WL_PLATFORM_WINDOWS)
+	void* m_FileHandle = nullptr;
+	void* m_MappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,222 @@
+#include "Profiler.h"
+
+#include <yaml-cpp/yaml.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <cstring>
+
+namespace Utils {
+	// Relaxed atomics, so the main thread may copy a slot while its thread overwrites it. The copy is dropped
+	// afterwards if that happened, see CopyEvents.
+	struct EventSlot {
+		std::atomic<const char*> Name = nullptr;
+		std::atomic<uint64_t> Start = 0;
+		std::atomic<uint64_t> Duration = 0;
+	};
+
+	// Written by the owning thread only, read by the main thread once per frame
+	struct ThreadEvents {
+		uint32_t ThreadIndex = 0;
+
+		std::unique_ptr<EventSlot[]> Events;
+		std::atomic<uint64_t> Head = 0; // Total number of events ever recorded
+		uint64_t ReadIndex = 0;
+	};
+
+	// Only taken the first and last time a thread records and by the main thread between frames
+	static std::mutex s_RegistryMutex;
+	static std::vector<std::unique_ptr<ThreadEvents>> s_Threads;
+	static std::vector<ThreadEvents*> s_FreeThreads; // Rings of threads that exited
+	static std::vector<Profiler::Event> s_CopiedEvents;
+
+	static const uint64_t s_StartTime = Profiler::GetTime();
+	static uint64_t s_LastFrameStart = 0;
+
+	// Hands the thread's ring back when the thread exits. Thread pools replace all their workers on every
+	// resize, the next thread that records takes the ring over instead of allocating another one.
+	struct ThreadEventsOwner {
+		ThreadEvents* Events = nullptr;
+
+		~ThreadEventsOwner() {
+			if (Events) {
+				std::lock_guard<std::mutex> lock(s_RegistryMutex);
+				s_FreeThreads.push_back(Events);
+			}
+		}
+	};
+
+	static ThreadEvents& GetThreadEvents() {
+		thread_local ThreadEventsOwner owner;
+		if (!owner.Events) {
+			std::lock_guard<std::mutex> lock(s_RegistryMutex);
+
+			if (!s_FreeThreads.empty()) {
+				// The old thread's events stay in the ring until they are overwritten, so they still end up in the trace
+				owner.Events = s_FreeThreads.back();
+				s_FreeThreads.pop_back();
+			} else {
+				std::unique_ptr<ThreadEvents>& created = s_Threads.emplace_back(std::make_unique<ThreadEvents>());
+				created->ThreadIndex = (uint32_t)s_Threads.size() - 1;
+				created->Events = std::make_unique<EventSlot[]>(Profiler::s_EventCapacity);
+				owner.Events = created.get();
+			}
+		}
+
+		return *owner.Events;
+	}
+
+	static void AddStageTime(std::vector<Profiler::StageTime>& stageTimes, const char* name, uint64_t duration) {
+		// The same literal can have a different address in every translation unit
+		auto it = std::find_if(stageTimes.begin(), stageTimes.end(), [name](const Profiler::StageTime& stageTime) {
+			return stageTime.Name == name || strcmp(stageTime.Name, name) == 0;
+		});
+
+		if (it == stageTimes.end()) {
+			it = stageTimes.insert(stageTimes.end(), { name, 0.0f, 0 });
+		}
+
+		it->Time += (float)((double)duration / 1.0e6);
+		it->Calls++;
+	}
+
+	static uint64_t GetFirstEventIndex(uint64_t head, uint64_t readIndex) {
+		// Older events were overwritten. The slot of event head - capacity is the one the next event goes into,
+		// so it may be half written already.
+		uint64_t oldest = head >= Profiler::s_EventCapacity ? head - Profiler::s_EventCapacity + 1 : 0;
+		return std::max(readIndex, oldest);
+	}
+
+	// Copies the events from readIndex up to the head into s_CopiedEvents and returns that head. Works like a
+	// seqlock: the head is read again after copying, and events whose slots were reused meanwhile are dropped.
+	static uint64_t CopyEvents(const ThreadEvents& threadEvents, uint64_t readIndex) {
+		s_CopiedEvents.clear();
+
+		uint64_t head = threadEvents.Head.load(std::memory_order_acquire);
+		uint64_t first = GetFirstEventIndex(head, readIndex);
+		for (uint64_t i = first; i < head; i++) {
+			const EventSlot& slot = threadEvents.Events[i & (Profiler::s_EventCapacity - 1)];
+			s_CopiedEvents.push_back({
+				slot.Name.load(std::memory_order_relaxed),
+				slot.Start.load(std::memory_order_relaxed),
+				slot.Duration.load(std::memory_order_relaxed)
+			});
+		}
+
+		// Pairs with the fence in Record: if a copy saw part of a newer event, the head read here is at least that event's index
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t intact = GetFirstEventIndex(threadEvents.Head.load(std::memory_order_relaxed), first);
+		s_CopiedEvents.erase(s_CopiedEvents.begin(), s_CopiedEvents.begin() + (size_t)std::min(intact, head) - (size_t)first);
+
+		return head;
+	}
+}
+
+std::atomic<bool> Profiler::s_Enabled = false;
+std::vector<Profiler::StageTime> Profiler::s_StageTimes;
+float Profiler::s_FrameTimes[Profiler::s_FrameHistorySize] = {};
+uint32_t Profiler::s_FrameTimeOffset = 0;
+
+uint64_t Profiler::GetTime() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t duration) {
+	Utils::ThreadEvents& threadEvents = Utils::GetThreadEvents();
+
+	uint64_t head = threadEvents.Head.load(std::memory_order_relaxed);
+
+	// Keeps the head published by the last event ahead of overwriting the slot, for CopyEvents
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Utils::EventSlot& slot = threadEvents.Events[head & (s_EventCapacity - 1)];
+	slot.Name.store(name, std::memory_order_relaxed);
+	slot.Start.store(start, std::memory_order_relaxed);
+	slot.Duration.store(duration, std::memory_order_relaxed);
+
+	threadEvents.Head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::NewFrame() {
+	uint64_t now = GetTime();
+	if (Utils::s_LastFrameStart != 0) {
+		s_FrameTimes[s_FrameTimeOffset] = (float)((double)(now - Utils::s_LastFrameStart) / 1.0e6);
+		s_FrameTimeOffset = (s_FrameTimeOffset + 1) % s_FrameHistorySize;
+	}
+	Utils::s_LastFrameStart = now;
+
+	s_StageTimes.clear();
+
+	std::lock_guard<std::mutex> lock(Utils::s_RegistryMutex);
+
+	for (const std::unique_ptr<Utils::ThreadEvents>& threadEvents : Utils::s_Threads) {
+		threadEvents->ReadIndex = Utils::CopyEvents(*threadEvents, threadEvents->ReadIndex);
+		for (const Event& event : Utils::s_CopiedEvents) {
+			Utils::AddStageTime(s_StageTimes, event.Name, event.Duration);
+		}
+	}
+
+	std::sort(s_StageTimes.begin(), s_StageTimes.end(), [](const StageTime& a, const StageTime& b) { return a.Time > b.Time; });
+}
+
+bool Profiler::ExportChromeTrace(const std::filesystem::path& filepath) {
+	// Flow maps with quoted strings are valid JSON
+	YAML::Emitter out;
+	out.SetStringFormat(YAML::DoubleQuoted);
+	out.SetMapFormat(YAML::Flow);
+	out.SetSeqFormat(YAML::Flow);
+
+	out << YAML::BeginMap;
+	out << YAML::Key << "traceEvents" << YAML::Value << YAML::BeginSeq;
+	{
+		std::lock_guard<std::mutex> lock(Utils::s_RegistryMutex);
+
+		for (const std::unique_ptr<Utils::ThreadEvents>& threadEvents : Utils::s_Threads) {
+			out << YAML::BeginMap;
+			out << YAML::Key << "name" << YAML::Value << "thread_name";
+			out << YAML::Key << "ph" << YAML::Value << "M";
+			out << YAML::Key << "pid" << YAML::Value << 0;
+			out << YAML::Key << "tid" << YAML::Value << threadEvents->ThreadIndex;
+			out << YAML::Key << "args" << YAML::Value << YAML::BeginMap;
+			out << YAML::Key << "name" << YAML::Value << "Thread " + std::to_string(threadEvents->ThreadIndex);
+			out << YAML::EndMap;
+			out << YAML::EndMap;
+
+			// Timestamps are in microseconds
+			Utils::CopyEvents(*threadEvents, 0);
+			for (const Event& event : Utils::s_CopiedEvents) {
+				out << YAML::BeginMap;
+				out << YAML::Key << "name" << YAML::Value << event.Name;
+				out << YAML::Key << "ph" << YAML::Value << "X";
+				out << YAML::Key << "ts" << YAML::Value << (double)(event.Start - Utils::s_StartTime) / 1.0e3;
+				out << YAML::Key << "dur" << YAML::Value << (double)event.Duration / 1.0e3;
+				out << YAML::Key << "pid" << YAML::Value << 0;
+				out << YAML::Key << "tid" << YAML::Value << threadEvents->ThreadIndex;
+				out << YAML::EndMap;
+			}
+		}
+	}
+	out << YAML::EndSeq;
+	out << YAML::Key << "displayTimeUnit" << YAML::Value << "ms";
+	out << YAML::EndMap;
+
+	if (filepath.has_parent_path()) {
+		std::error_code error;
+		std::filesystem::create_directories(filepath.parent_path(), error);
+	}
+
+	std::ofstream fout(filepath);
+	if (!fout) {
+		spdlog::error("Profiler - Could not write Chrome trace: {0}", filepath.string());
+		return false;
+	}
+
+	fout << out.c_str() << '\n';
+	spdlog::info("Profiler - Chrome trace written to {0}", filepath.string());
+
+	return true;
+}
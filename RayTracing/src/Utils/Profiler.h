@@ -0,0 +1,89 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// Scoped timers for finding out where a frame's time goes. Every thread records into its own ring
+// buffer, so recording never takes a lock. Once per rendered frame the thread that renders collects the
+// new events into a per stage breakdown. The rings keep the last events of every thread for a Chrome trace
+// (chrome://tracing or ui.perfetto.dev).
+//
+// Recording is off by default. Scopes are meant for tiles and stages, a scope per ray or per sample
+// would cost more than the work it measures.
+class Profiler {
+public:
+	struct Event {
+		const char* Name = nullptr; // Must outlive the profiler, in practice a string literal
+		uint64_t Start = 0;         // Nanoseconds, see GetTime
+		uint64_t Duration = 0;
+	};
+
+	struct StageTime {
+		const char* Name = nullptr;
+		float Time = 0.0f; // Milliseconds
+		uint32_t Calls = 0;
+	};
+
+	static constexpr uint32_t s_EventCapacity = 1 << 16; // Per thread, a power of two
+	static constexpr uint32_t s_FrameHistorySize = 240;
+public:
+	static void SetEnabled(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+	static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+	static uint64_t GetTime();
+
+	static void Record(const char* name, uint64_t start, uint64_t duration);
+
+	// Collects everything recorded since the last call. Called once per rendered frame, always on the same thread,
+	// which is the only one that may read the stage and frame times. Other threads may keep recording meanwhile,
+	// events they overwrite before being read are left out.
+	static void NewFrame();
+
+	// From the last completed frame, longest first
+	static const std::vector<StageTime>& GetStageTimes() { return s_StageTimes; }
+
+	// Rolling history in milliseconds, the oldest entry is at GetFrameTimeOffset
+	static const float* GetFrameTimes() { return s_FrameTimes; }
+	static uint32_t GetFrameTimeOffset() { return s_FrameTimeOffset; }
+
+	// Writes the events still in the ring buffers, other threads may keep recording as with NewFrame
+	static bool ExportChromeTrace(const std::filesystem::path& filepath);
+private:
+	static std::atomic<bool> s_Enabled;
+
+	static std::vector<StageTime> s_StageTimes;
+
+	static float s_FrameTimes[s_FrameHistorySize];
+	static uint32_t s_FrameTimeOffset;
+};
+
+class ProfileScope {
+public:
+	ProfileScope(const char* name)
+		: m_Name(name), m_Start(Profiler::IsEnabled() ? Profiler::GetTime() : 0)
+	{}
+
+	~ProfileScope() {
+		if (m_Start != 0) {
+			Profiler::Record(m_Name, m_Start, Profiler::GetTime() - m_Start);
+		}
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	const char* m_Name;
+	uint64_t m_Start;
+};
+
+// Compiled out of Dist builds
+#ifndef WL_DIST
+	#define RT_PROFILE_CONCAT_IMPL(a, b) a##b
+	#define RT_PROFILE_CONCAT(a, b) RT_PROFILE_CONCAT_IMPL(a, b)
+
+	#define RT_PROFILE_SCOPE(name) ProfileScope RT_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+	#define RT_PROFILE_SCOPE(name)
+#endif
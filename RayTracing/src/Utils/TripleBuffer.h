@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands values from one writer thread to one reader thread without locks and without copying them.
+// The writer always fills a buffer nobody else looks at, and publishing swaps it into the latest slot.
+// The reader takes over the latest buffer whenever there is a new one and keeps it for as long as it
+// likes, the writer never touches it in the meantime. The writer and the reader may be the same thread.
+//
+// Buffers are reused, so the write buffer holds whatever was published two or three times ago.
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer side
+	T& GetWriteBuffer() { return m_Buffers[m_WriteIndex]; }
+
+	// The buffer published last, it stays intact while the writer fills the next one
+	const T& GetPublishedBuffer() const { return m_Buffers[m_PublishedIndex]; }
+
+	void Publish() {
+		// Release makes the buffer visible to the reader, acquire gets back a buffer it has let go of
+		uint32_t previous = m_LatestIndex.exchange(m_WriteIndex | s_NewBufferBit, std::memory_order_acq_rel);
+
+		m_PublishedIndex = m_WriteIndex;
+		m_WriteIndex = previous & ~s_NewBufferBit;
+	}
+
+	// Reader side. Takes over the latest published buffer, false if there is nothing newer than the
+	// current read buffer. The read buffer stays valid and unchanged until the next call.
+	bool AcquireLatest() {
+		if (!(m_LatestIndex.load(std::memory_order_relaxed) & s_NewBufferBit)) {
+			return false;
+		}
+
+		uint32_t previous = m_LatestIndex.exchange(m_ReadIndex, std::memory_order_acq_rel);
+		m_ReadIndex = previous & ~s_NewBufferBit;
+
+		return true;
+	}
+
+	const T& GetReadBuffer() const { return m_Buffers[m_ReadIndex]; }
+private:
+	static constexpr uint32_t s_NewBufferBit = 1 << 2; // Set in m_LatestIndex until the reader takes the buffer
+
+	T m_Buffers[3];
+
+	// Each buffer is in exactly one of the three slots
+	uint32_t m_WriteIndex = 0;               // Writer only
+	std::atomic<uint32_t> m_LatestIndex = 1;
+	uint32_t m_ReadIndex = 2;                // Reader only
+
+	uint32_t m_PublishedIndex = 1;           // Writer only, the latest or the read slot
+};
@@ -0,0 +1,158 @@
+#include "Benchmarks.h"
+#include "SceneGenerator.h"
+
+#include "Renderer/BVH.h"
+#include "Renderer/ThreadPool.h"
+#include "Scene/Scene.h"
+
+#include <spdlog/spdlog.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Utils {
+	struct BVHBenchmarkOptions {
+		std::vector<uint32_t> SphereCounts = { 1000, 10000, 100000, 1000000 };
+
+		uint32_t Runs = 5;
+		uint32_t MaxThreads = 0;
+		uint32_t LeafSize = 4;
+
+		float Jitter = 0.5f; // Of a sphere's radius, how far spheres move before the refit
+	};
+
+	static void PrintBVHBenchmarkUsage() {
+		printf(
+			"Usage: RayTracingBenchmark bvh [options]\n"
+			"\n"
+			"Options:\n"
+			"      --spheres <n,n,...>       Sphere counts of the generated scenes (default: 1000,10000,100000,1000000)\n"
+			"  -r, --runs <count>            Builds and refits per measurement, the median is reported (default: 5)\n"
+			"  -t, --threads <count>         Highest thread count, 0 = all (default: 0)\n"
+			"  -l, --leaf-size <count>       Maximum primitives per leaf (default: 4)\n"
+			"  -j, --jitter <fraction>       How far spheres move before the refit, relative to their radius (default: 0.5)\n"
+		);
+	}
+
+	static bool ParseBVHBenchmarkArguments(int argc, char** argv, BVHBenchmarkOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (argument == "--spheres" && hasValue) {
+				if (!ParseCountList(argv[++i], options.SphereCounts)) {
+					return false;
+				}
+			} else if ((argument == "-r" || argument == "--runs") && hasValue) {
+				options.Runs = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-t" || argument == "--threads") && hasValue) {
+				options.MaxThreads = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-l" || argument == "--leaf-size") && hasValue) {
+				options.LeafSize = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-j" || argument == "--jitter") && hasValue) {
+				options.Jitter = std::strtof(argv[++i], nullptr);
+			} else {
+				return false;
+			}
+		}
+
+		return options.Runs > 0 && options.LeafSize > 0 && options.Jitter >= 0.0f;
+	}
+
+	// 1, 2, 4, ... up to and always including maxThreads
+	static std::vector<uint32_t> GetBVHThreadCounts(uint32_t maxThreads) {
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2) {
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back(maxThreads);
+
+		return threadCounts;
+	}
+
+	static void GetSphereBounds(const std::vector<Sphere>& spheres, std::vector<BoundingBox>& sphereBounds) {
+		sphereBounds.resize(spheres.size());
+		for (size_t i = 0; i < spheres.size(); i++) {
+			sphereBounds[i].Min = spheres[i].Position - glm::vec3(glm::abs(spheres[i].Radius));
+			sphereBounds[i].Max = spheres[i].Position + glm::vec3(glm::abs(spheres[i].Radius));
+		}
+	}
+
+	static float GetMedian(std::vector<float> values) {
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+}
+
+int RunBVHBenchmark(int argc, char** argv) {
+	Utils::BVHBenchmarkOptions options;
+	if (!Utils::ParseBVHBenchmarkArguments(argc, argv, options)) {
+		Utils::PrintBVHBenchmarkUsage();
+		return 1;
+	}
+
+	spdlog::set_level(spdlog::level::warn);
+
+	uint32_t maxThreads = options.MaxThreads > 0 ? options.MaxThreads : glm::max(1u, std::thread::hardware_concurrency());
+	std::vector<uint32_t> threadCounts = Utils::GetBVHThreadCounts(maxThreads);
+
+	ThreadPool threadPool;
+
+	printf("\n%-10s %-8s %12s %8s %12s %10s %10s %12s\n", "Spheres", "Threads", "Build (ms)", "Speedup", "Refit (ms)", "Nodes", "SAH cost", "Refit cost");
+
+	for (uint32_t sphereCount : options.SphereCounts) {
+		Scene scene = SceneGenerator::RandomSpheres(sphereCount);
+
+		std::vector<BoundingBox> sphereBounds;
+		Utils::GetSphereBounds(scene.Spheres, sphereBounds);
+
+		// The same moved spheres for every thread count
+		std::mt19937 random(sphereCount);
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+		for (Sphere& sphere : scene.Spheres) {
+			sphere.Position += glm::vec3(offset(random), offset(random), offset(random)) * sphere.Radius * options.Jitter;
+		}
+
+		std::vector<BoundingBox> movedBounds;
+		Utils::GetSphereBounds(scene.Spheres, movedBounds);
+
+		float singleThreadBuildTime = 0.0f;
+
+		for (uint32_t threads : threadCounts) {
+			threadPool.Resize(threads);
+
+			std::vector<float> buildTimes, refitTimes;
+			BVH bvh;
+			float buildCost = 0.0f;
+
+			for (uint32_t run = 0; run < options.Runs; run++) {
+				bvh.Build(sphereBounds, options.LeafSize, &threadPool);
+				buildTimes.push_back(bvh.GetBuildTime());
+				buildCost = bvh.GetCost();
+
+				bvh.Refit(movedBounds, &threadPool);
+				refitTimes.push_back(bvh.GetRefitTime());
+			}
+
+			float buildTime = Utils::GetMedian(buildTimes);
+			if (threads == 1) {
+				singleThreadBuildTime = buildTime;
+			}
+
+			float speedup = buildTime > 0.0f && singleThreadBuildTime > 0.0f ? singleThreadBuildTime / buildTime : 0.0f;
+
+			printf("%-10u %-8u %12.3f %7.2fx %12.3f %10u %10.2f %12.2f\n", sphereCount, threads, buildTime, speedup,
+				Utils::GetMedian(refitTimes), bvh.GetNodeCount(), buildCost, bvh.GetCost());
+			fflush(stdout);
+		}
+	}
+
+	return 0;
+}
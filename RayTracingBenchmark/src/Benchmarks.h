@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Every benchmark parses its own arguments (everything after the benchmark name) and returns the process exit code
+
+// Image error against a high sample count reference versus sample count, for every sampler
+int RunSamplerBenchmark(int argc, char** argv);
+
+// Load time and peak memory of every scene loader on generated scenes
+int RunSceneLoadingBenchmark(int argc, char** argv);
+
+// Rays per second of the per-pixel and wavefront integrators, with and without ray binning
+int RunRayBinningBenchmark(int argc, char** argv);
+
+// Rays per second, primary versus secondary throughput and thread scaling on generated scenes, written as JSON
+int RunPerformanceBenchmark(int argc, char** argv);
+
+// BVH build and refit time versus primitive count and thread count, with the SAH cost of the trees
+int RunBVHBenchmark(int argc, char** argv);
+
+// Path the benchmark was started with, for benchmarks that measure in a child process
+const char* GetExecutablePath();
+
+// Parses a comma separated list of positive counts such as "10000,100000"
+bool ParseCountList(const char* value, std::vector<uint32_t>& counts);
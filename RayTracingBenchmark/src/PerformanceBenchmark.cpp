@@ -0,0 +1,359 @@
+#include "Benchmarks.h"
+#include "SceneGenerator.h"
+
+#include "Renderer/Renderer.h"
+#include "Scene/Camera.h"
+#include "Scene/Scene.h"
+
+#include "Walnut/Timer.h"
+
+#include <yaml-cpp/yaml.h>
+#include <spdlog/spdlog.h>
+
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Utils {
+	enum class GeneratedScene {
+		RandomSpheres = 0,
+		SphereGrid,
+		GroundSphere,
+		EmissiveSpheres
+	};
+
+	struct GeneratedSceneInfo {
+		const char* Name;
+		GeneratedScene Type;
+	};
+
+	static const GeneratedSceneInfo s_Scenes[] = {
+		{ "random", GeneratedScene::RandomSpheres },
+		{ "grid", GeneratedScene::SphereGrid },
+		{ "ground", GeneratedScene::GroundSphere },
+		{ "emissive", GeneratedScene::EmissiveSpheres },
+	};
+
+	struct PerformanceBenchmarkOptions {
+		std::vector<const GeneratedSceneInfo*> Scenes;
+		uint32_t SphereCount = 100000;
+
+		uint32_t Width = 640;
+		uint32_t Height = 360;
+		uint32_t Samples = 8;
+
+		int RayBounces = 5;
+		int Seed = 0;
+		uint32_t MaxThreads = 0;
+
+		std::string OutputPath = "performance.json";
+		std::string Label;
+	};
+
+	struct Measurement {
+		uint64_t Rays = 0;
+		double Milliseconds = 0.0;
+
+		double GetMraysPerSecond() const { return Milliseconds > 0.0 ? (double)Rays / (Milliseconds * 1000.0) : 0.0; }
+	};
+
+	struct ThreadScalingResult {
+		uint32_t Threads;
+		Measurement Result;
+	};
+
+	struct SceneResult {
+		const char* Name;
+		uint32_t SphereCount;
+		float BVHBuildTime;
+
+		Measurement Total;
+		Measurement Primary;
+		Measurement Secondary;
+
+		std::vector<ThreadScalingResult> ThreadScaling;
+	};
+
+	static void PrintPerformanceBenchmarkUsage() {
+		printf(
+			"Usage: RayTracingBenchmark performance [options]\n"
+			"\n"
+			"Options:\n"
+			"      --scenes <name,...>       Generated scenes: random, grid, ground, emissive (default: all)\n"
+			"      --spheres <count>         Spheres per generated scene (default: 100000)\n"
+			"  -w, --width <pixels>          Image width (default: 640)\n"
+			"  -h, --height <pixels>         Image height (default: 360)\n"
+			"  -s, --samples <count>         Samples per pixel (default: 8)\n"
+			"  -b, --bounces <count>         Ray bounces (default: 5)\n"
+			"      --seed <value>            Sampler seed (default: 0)\n"
+			"  -t, --threads <count>         Highest thread count of the scaling runs, 0 = all (default: 0)\n"
+			"  -o, --output <file>           JSON results (default: performance.json)\n"
+			"      --label <text>            Stored in the JSON to tell runs apart, e.g. a commit hash\n"
+		);
+	}
+
+	static bool ParseSceneList(const std::string& value, std::vector<const GeneratedSceneInfo*>& scenes) {
+		scenes.clear();
+
+		size_t start = 0;
+		while (start <= value.size()) {
+			size_t end = value.find(',', start);
+			if (end == std::string::npos) {
+				end = value.size();
+			}
+
+			std::string name = value.substr(start, end - start);
+			const GeneratedSceneInfo* found = nullptr;
+			for (const GeneratedSceneInfo& scene : s_Scenes) {
+				if (name == scene.Name) {
+					found = &scene;
+				}
+			}
+
+			if (!found) {
+				return false;
+			}
+
+			scenes.push_back(found);
+			start = end + 1;
+		}
+
+		return !scenes.empty();
+	}
+
+	static bool ParsePerformanceBenchmarkArguments(int argc, char** argv, PerformanceBenchmarkOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (argument == "--scenes" && hasValue) {
+				if (!ParseSceneList(argv[++i], options.Scenes)) {
+					return false;
+				}
+			} else if (argument == "--spheres" && hasValue) {
+				options.SphereCount = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-w" || argument == "--width") && hasValue) {
+				options.Width = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-h" || argument == "--height") && hasValue) {
+				options.Height = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-s" || argument == "--samples") && hasValue) {
+				options.Samples = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-b" || argument == "--bounces") && hasValue) {
+				options.RayBounces = std::atoi(argv[++i]);
+			} else if (argument == "--seed" && hasValue) {
+				options.Seed = std::atoi(argv[++i]);
+			} else if ((argument == "-t" || argument == "--threads") && hasValue) {
+				options.MaxThreads = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-o" || argument == "--output") && hasValue) {
+				options.OutputPath = argv[++i];
+			} else if (argument == "--label" && hasValue) {
+				options.Label = argv[++i];
+			} else {
+				return false;
+			}
+		}
+
+		if (options.Scenes.empty()) {
+			for (const GeneratedSceneInfo& scene : s_Scenes) {
+				options.Scenes.push_back(&scene);
+			}
+		}
+
+		return options.SphereCount > 0 && options.Width > 0 && options.Height > 0 && options.Samples > 0 && options.RayBounces > 0;
+	}
+
+	static Scene GenerateScene(GeneratedScene type, uint32_t sphereCount) {
+		switch (type) {
+			case GeneratedScene::RandomSpheres:
+				return SceneGenerator::RandomSpheres(sphereCount);
+			case GeneratedScene::SphereGrid:
+				return SceneGenerator::SphereGrid(glm::max(1u, (uint32_t)std::round(std::cbrt((double)sphereCount))));
+			case GeneratedScene::GroundSphere:
+				return SceneGenerator::GroundSphere(sphereCount);
+			case GeneratedScene::EmissiveSpheres:
+				return SceneGenerator::EmissiveSpheres(sphereCount);
+		}
+
+		return Scene();
+	}
+
+	// 1, 2, 4, ... up to and always including maxThreads
+	static std::vector<uint32_t> GetThreadCounts(uint32_t maxThreads) {
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2) {
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back(maxThreads);
+
+		return threadCounts;
+	}
+
+	// Renders the same samples from the first one again, so every run of a scene traces identical paths
+	static Measurement Measure(Renderer& renderer, const Scene& scene, const Camera& camera, uint32_t samples, int rayBounces, uint32_t threads) {
+		Renderer::Settings& settings = renderer.GetSettings();
+		settings.RayBounces = rayBounces;
+		settings.Multithreading = threads > 1;
+		settings.ThreadCount = (int)threads;
+
+		renderer.ResetFrameIndex();
+
+		Measurement measurement;
+
+		Walnut::Timer timer;
+		for (uint32_t sample = 0; sample < samples; sample++) {
+			renderer.Render(scene, camera);
+			measurement.Rays += renderer.GetStats().RaysTraced;
+		}
+
+		measurement.Milliseconds = timer.ElapsedMillis();
+
+		return measurement;
+	}
+
+	static void WriteResults(const PerformanceBenchmarkOptions& options, const char* intersectionKernel, uint32_t maxThreads, const std::vector<SceneResult>& results) {
+		// Flow maps with quoted strings are valid JSON
+		YAML::Emitter out;
+		out.SetStringFormat(YAML::DoubleQuoted);
+		out.SetMapFormat(YAML::Flow);
+		out.SetSeqFormat(YAML::Flow);
+
+		out << YAML::BeginMap;
+		out << YAML::Key << "Label" << YAML::Value << options.Label;
+		out << YAML::Key << "Width" << YAML::Value << options.Width;
+		out << YAML::Key << "Height" << YAML::Value << options.Height;
+		out << YAML::Key << "Samples" << YAML::Value << options.Samples;
+		out << YAML::Key << "RayBounces" << YAML::Value << options.RayBounces;
+		out << YAML::Key << "Seed" << YAML::Value << options.Seed;
+		out << YAML::Key << "IntersectionKernel" << YAML::Value << intersectionKernel;
+		out << YAML::Key << "MaxThreads" << YAML::Value << maxThreads;
+
+		out << YAML::Key << "Scenes" << YAML::Value << YAML::BeginSeq;
+		for (const SceneResult& result : results) {
+			double mraysPerSecond = result.Total.GetMraysPerSecond();
+
+			out << YAML::BeginMap;
+			out << YAML::Key << "Name" << YAML::Value << result.Name;
+			out << YAML::Key << "Spheres" << YAML::Value << result.SphereCount;
+			out << YAML::Key << "BVHBuildTime" << YAML::Value << result.BVHBuildTime;
+			out << YAML::Key << "Rays" << YAML::Value << result.Total.Rays;
+			out << YAML::Key << "Time" << YAML::Value << result.Total.Milliseconds;
+			out << YAML::Key << "MraysPerSecond" << YAML::Value << mraysPerSecond;
+			out << YAML::Key << "NanosecondsPerRay" << YAML::Value << (mraysPerSecond > 0.0 ? 1000.0 / mraysPerSecond : 0.0);
+			out << YAML::Key << "PrimaryRays" << YAML::Value << result.Primary.Rays;
+			out << YAML::Key << "PrimaryMraysPerSecond" << YAML::Value << result.Primary.GetMraysPerSecond();
+			out << YAML::Key << "SecondaryRays" << YAML::Value << result.Secondary.Rays;
+			out << YAML::Key << "SecondaryMraysPerSecond" << YAML::Value << result.Secondary.GetMraysPerSecond();
+
+			double singleThreadMraysPerSecond = result.ThreadScaling.front().Result.GetMraysPerSecond();
+
+			out << YAML::Key << "ThreadScaling" << YAML::Value << YAML::BeginSeq;
+			for (const ThreadScalingResult& scaling : result.ThreadScaling) {
+				double speedup = singleThreadMraysPerSecond > 0.0 ? scaling.Result.GetMraysPerSecond() / singleThreadMraysPerSecond : 0.0;
+
+				out << YAML::BeginMap;
+				out << YAML::Key << "Threads" << YAML::Value << scaling.Threads;
+				out << YAML::Key << "MraysPerSecond" << YAML::Value << scaling.Result.GetMraysPerSecond();
+				out << YAML::Key << "Speedup" << YAML::Value << speedup;
+				out << YAML::EndMap;
+			}
+			out << YAML::EndSeq;
+
+			out << YAML::EndMap;
+		}
+		out << YAML::EndSeq;
+		out << YAML::EndMap;
+
+		std::ofstream fout(options.OutputPath);
+		if (!fout) {
+			spdlog::error("PerformanceBenchmark - Could not write results: {0}", options.OutputPath);
+			return;
+		}
+
+		fout << out.c_str() << '\n';
+		printf("\nResults written to %s\n", options.OutputPath.c_str());
+	}
+}
+
+int RunPerformanceBenchmark(int argc, char** argv) {
+	Utils::PerformanceBenchmarkOptions options;
+	if (!Utils::ParsePerformanceBenchmarkArguments(argc, argv, options)) {
+		Utils::PrintPerformanceBenchmarkUsage();
+		return 1;
+	}
+
+	spdlog::set_level(spdlog::level::warn);
+
+	uint32_t maxThreads = options.MaxThreads > 0 ? options.MaxThreads : glm::max(1u, std::thread::hardware_concurrency());
+	std::vector<uint32_t> threadCounts = Utils::GetThreadCounts(maxThreads);
+
+	Camera camera(45.0f, 0.1f, 1000.0f);
+	camera.OnResize(options.Width, options.Height);
+
+	const char* intersectionKernel = "Scalar";
+	std::vector<Utils::SceneResult> results;
+
+	printf("\n%-10s %-10s %12s %10s %14s %14s %10s %10s\n", "Scene", "Spheres", "Mrays/s", "ns/ray", "Primary Mr/s", "Secondary Mr/s", "Threads", "Speedup");
+
+	for (const Utils::GeneratedSceneInfo* sceneInfo : options.Scenes) {
+		Scene scene = Utils::GenerateScene(sceneInfo->Type, options.SphereCount);
+
+		Renderer renderer;
+		renderer.OnResize(options.Width, options.Height);
+
+		// Everything that would make the traced samples depend on timing is turned off
+		Renderer::Settings& settings = renderer.GetSettings();
+		settings.Accumulate = true;
+		settings.ProgressivePreview = false;
+		settings.FrameTimeBudget = false;
+		settings.AdaptiveSampling = false;
+		settings.Seed = options.Seed;
+
+		// Builds the BVH, so no run pays for it
+		renderer.Render(scene, camera);
+		intersectionKernel = renderer.GetStats().IntersectionKernel;
+
+		Utils::SceneResult& result = results.emplace_back();
+		result.Name = sceneInfo->Name;
+		result.SphereCount = (uint32_t)scene.Spheres.size();
+		result.BVHBuildTime = renderer.GetStats().BVHBuildTime;
+
+		for (uint32_t threads : threadCounts) {
+			result.ThreadScaling.push_back({ threads, Utils::Measure(renderer, scene, camera, options.Samples, options.RayBounces, threads) });
+		}
+
+		// Primary rays alone are measured with a single bounce, the secondary rays are whatever the full run did on top of that
+		result.Total = result.ThreadScaling.back().Result;
+		result.Primary = Utils::Measure(renderer, scene, camera, options.Samples, 1, maxThreads);
+		if (result.Total.Rays > result.Primary.Rays && result.Total.Milliseconds > result.Primary.Milliseconds) {
+			result.Secondary.Rays = result.Total.Rays - result.Primary.Rays;
+			result.Secondary.Milliseconds = result.Total.Milliseconds - result.Primary.Milliseconds;
+		}
+
+		double mraysPerSecond = result.Total.GetMraysPerSecond();
+		double singleThreadMraysPerSecond = result.ThreadScaling.front().Result.GetMraysPerSecond();
+
+		for (size_t i = 0; i < result.ThreadScaling.size(); i++) {
+			const Utils::ThreadScalingResult& scaling = result.ThreadScaling[i];
+			double speedup = singleThreadMraysPerSecond > 0.0 ? scaling.Result.GetMraysPerSecond() / singleThreadMraysPerSecond : 0.0;
+
+			if (i == 0) {
+				printf("%-10s %-10u %12.2f %10.1f %14.2f %14.2f %10u %10.2f\n", result.Name, result.SphereCount, mraysPerSecond,
+					mraysPerSecond > 0.0 ? 1000.0 / mraysPerSecond : 0.0, result.Primary.GetMraysPerSecond(), result.Secondary.GetMraysPerSecond(),
+					scaling.Threads, speedup);
+			} else {
+				printf("%-10s %-10s %12s %10s %14s %14s %10u %10.2f\n", "", "", "", "", "", "", scaling.Threads, speedup);
+			}
+		}
+		fflush(stdout);
+	}
+
+	Utils::WriteResults(options, intersectionKernel, maxThreads, results);
+
+	return 0;
+}
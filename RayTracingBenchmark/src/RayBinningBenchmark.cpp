@@ -0,0 +1,137 @@
+#include "Benchmarks.h"
+#include "SceneGenerator.h"
+
+#include "Renderer/Renderer.h"
+#include "Scene/Camera.h"
+#include "Scene/Scene.h"
+
+#include "Walnut/Timer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Utils {
+	struct RayBinningBenchmarkOptions {
+		std::vector<uint32_t> SphereCounts = { 1000, 10000, 100000, 1000000 };
+
+		uint32_t Width = 640;
+		uint32_t Height = 360;
+		uint32_t Frames = 4;
+
+		int RayBounces = 5;
+		int ThreadCount = 0;
+	};
+
+	struct IntegratorMode {
+		const char* Name;
+		Renderer::Integrator IntegratorType;
+		bool RayBinning;
+	};
+
+	static const IntegratorMode s_Modes[] = {
+		{ "per-pixel", Renderer::Integrator::PerPixel, false },
+		{ "wavefront", Renderer::Integrator::Wavefront, false },
+		{ "wavefront-binned", Renderer::Integrator::Wavefront, true },
+	};
+
+	static void PrintRayBinningBenchmarkUsage() {
+		printf(
+			"Usage: RayTracingBenchmark ray-binning [options]\n"
+			"\n"
+			"Options:\n"
+			"      --spheres <n,n,...>       Sphere counts of the generated scenes (default: 1000,10000,100000,1000000)\n"
+			"  -w, --width <pixels>          Image width (default: 640)\n"
+			"  -h, --height <pixels>         Image height (default: 360)\n"
+			"  -f, --frames <count>          Measured frames per scene and mode (default: 4)\n"
+			"  -b, --bounces <count>         Ray bounces (default: 5)\n"
+			"  -t, --threads <count>         Render threads, 0 = all (default: 0)\n"
+		);
+	}
+
+	static bool ParseRayBinningBenchmarkArguments(int argc, char** argv, RayBinningBenchmarkOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (argument == "--spheres" && hasValue) {
+				if (!ParseCountList(argv[++i], options.SphereCounts)) {
+					return false;
+				}
+			} else if ((argument == "-w" || argument == "--width") && hasValue) {
+				options.Width = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-h" || argument == "--height") && hasValue) {
+				options.Height = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-f" || argument == "--frames") && hasValue) {
+				options.Frames = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-b" || argument == "--bounces") && hasValue) {
+				options.RayBounces = std::atoi(argv[++i]);
+			} else if ((argument == "-t" || argument == "--threads") && hasValue) {
+				options.ThreadCount = std::atoi(argv[++i]);
+			} else {
+				return false;
+			}
+		}
+
+		return options.Width > 0 && options.Height > 0 && options.Frames > 0 && options.RayBounces > 0;
+	}
+}
+
+int RunRayBinningBenchmark(int argc, char** argv) {
+	Utils::RayBinningBenchmarkOptions options;
+	if (!Utils::ParseRayBinningBenchmarkArguments(argc, argv, options)) {
+		Utils::PrintRayBinningBenchmarkUsage();
+		return 1;
+	}
+
+	spdlog::set_level(spdlog::level::warn);
+
+	Camera camera(45.0f, 0.1f, 1000.0f);
+	camera.OnResize(options.Width, options.Height);
+
+	printf("\n%-10s %-18s %12s %12s %14s %14s\n", "Spheres", "Mode", "Rays", "Mrays/s", "Binning (ms)", "Frame (ms)");
+
+	for (uint32_t sphereCount : options.SphereCounts) {
+		Scene scene = SceneGenerator::RandomSpheres(sphereCount);
+
+		Renderer renderer;
+		renderer.OnResize(options.Width, options.Height);
+
+		Renderer::Settings& settings = renderer.GetSettings();
+		settings.RayBounces = options.RayBounces;
+		settings.Multithreading = options.ThreadCount != 1;
+		settings.ThreadCount = options.ThreadCount;
+
+		// Builds the BVH, so no mode pays for it
+		renderer.Render(scene, camera);
+
+		for (const Utils::IntegratorMode& mode : Utils::s_Modes) {
+			settings.IntegratorType = mode.IntegratorType;
+			settings.RayBinning = mode.RayBinning;
+
+			// Every mode traces the exact same paths, the accumulation is restarted so they also share the sample indices
+			renderer.ResetFrameIndex();
+
+			uint64_t rays = 0;
+			double binningMilliseconds = 0.0;
+
+			Walnut::Timer timer;
+			for (uint32_t frame = 0; frame < options.Frames; frame++) {
+				renderer.Render(scene, camera);
+				rays += renderer.GetStats().RaysTraced;
+				binningMilliseconds += renderer.GetStats().BinningTime;
+			}
+
+			double milliseconds = timer.ElapsedMillis();
+
+			printf("%-10u %-18s %12llu %12.2f %14.2f %14.2f\n", sphereCount, mode.Name, (unsigned long long)rays,
+				(double)rays / (milliseconds * 1000.0), binningMilliseconds / options.Frames, milliseconds / options.Frames);
+			fflush(stdout);
+		}
+	}
+
+	return 0;
+}
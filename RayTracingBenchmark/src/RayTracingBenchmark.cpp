@@ -0,0 +1,71 @@
+#include "Benchmarks.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct Benchmark {
+	const char* Name;
+	const char* Description;
+	int (*Run)(int argc, char** argv);
+};
+
+static const Benchmark s_Benchmarks[] = {
+	{ "samplers", "RMSE against a reference image versus sample count for every sampler", RunSamplerBenchmark },
+	{ "scene-loading", "Load time and peak memory of the YAML, streaming YAML and binary scene loaders", RunSceneLoadingBenchmark },
+	{ "ray-binning", "Rays per second with and without binning bounce rays, on scenes of increasing size", RunRayBinningBenchmark },
+	{ "performance", "Rays per second and thread scaling on reproducible generated scenes, written to JSON", RunPerformanceBenchmark },
+	{ "bvh", "BVH build and refit time versus sphere count and thread count", RunBVHBenchmark },
+};
+
+static const char* s_ExecutablePath = nullptr;
+
+const char* GetExecutablePath() {
+	return s_ExecutablePath;
+}
+
+bool ParseCountList(const char* value, std::vector<uint32_t>& counts) {
+	counts.clear();
+	while (*value) {
+		char* end = nullptr;
+		uint32_t count = (uint32_t)std::strtoul(value, &end, 10);
+		if (end == value || count == 0) {
+			return false;
+		}
+
+		counts.push_back(count);
+		value = *end == ',' ? end + 1 : end;
+	}
+
+	return !counts.empty();
+}
+
+namespace Utils {
+	static void PrintUsage() {
+		printf("Usage: RayTracingBenchmark <benchmark> [options]\n\nBenchmarks:\n");
+
+		for (const Benchmark& benchmark : s_Benchmarks) {
+			printf("  %-20s %s\n", benchmark.Name, benchmark.Description);
+		}
+
+		printf("\nRun a benchmark with --help for its options\n");
+	}
+}
+
+int main(int argc, char** argv) {
+	s_ExecutablePath = argv[0];
+
+	if (argc < 2) {
+		Utils::PrintUsage();
+		return 1;
+	}
+
+	for (const Benchmark& benchmark : s_Benchmarks) {
+		if (strcmp(argv[1], benchmark.Name) == 0) {
+			return benchmark.Run(argc - 1, argv + 1);
+		}
+	}
+
+	Utils::PrintUsage();
+	return 1;
+}
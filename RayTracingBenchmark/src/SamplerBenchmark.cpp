@@ -0,0 +1,175 @@
+#include "Benchmarks.h"
+
+#include "Renderer/Renderer.h"
+#include "Scene/Camera.h"
+#include "Scene/Scene.h"
+#include "Scene/Serializer/SceneSerializer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Utils {
+	struct SamplerBenchmarkOptions {
+		std::filesystem::path ScenePath = "scenes/Default.yaml";
+
+		uint32_t Width = 256;
+		uint32_t Height = 144;
+		uint32_t MaxSamples = 256;
+		uint32_t ReferenceSamples = 4096;
+
+		int RayBounces = 5;
+		int Seed = 0;
+	};
+
+	static void PrintSamplerBenchmarkUsage() {
+		printf(
+			"Usage: RayTracingBenchmark samplers [scene.yaml] [options]\n"
+			"\n"
+			"Options:\n"
+			"  -w, --width <pixels>          Image width (default: 256)\n"
+			"  -h, --height <pixels>         Image height (default: 144)\n"
+			"  -s, --samples <count>         Largest sample count measured, in powers of two (default: 256)\n"
+			"  -r, --reference <count>       Samples of the Independent reference image (default: 4096)\n"
+			"  -b, --bounces <count>         Ray bounces (default: 5)\n"
+			"      --seed <seed>             Seed of the measured renders, the reference uses seed + 1\n"
+		);
+	}
+
+	static bool ParseSamplerBenchmarkArguments(int argc, char** argv, SamplerBenchmarkOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if ((argument == "-w" || argument == "--width") && hasValue) {
+				options.Width = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-h" || argument == "--height") && hasValue) {
+				options.Height = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-s" || argument == "--samples") && hasValue) {
+				options.MaxSamples = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-r" || argument == "--reference") && hasValue) {
+				options.ReferenceSamples = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-b" || argument == "--bounces") && hasValue) {
+				options.RayBounces = std::atoi(argv[++i]);
+			} else if (argument == "--seed" && hasValue) {
+				options.Seed = std::atoi(argv[++i]);
+			} else if (argument[0] != '-') {
+				options.ScenePath = argument;
+			} else {
+				return false;
+			}
+		}
+
+		return options.Width > 0 && options.Height > 0 && options.MaxSamples > 0 && options.ReferenceSamples > 0;
+	}
+
+	// Normalized RGB of the displayed image, alpha is ignored
+	static std::vector<float> ReadImage(const Renderer& renderer) {
+		uint32_t pixelCount = renderer.GetWidth() * renderer.GetHeight();
+		const uint32_t* imageData = renderer.GetImageData();
+
+		std::vector<float> image(pixelCount * 3);
+		for (uint32_t i = 0; i < pixelCount; i++) {
+			image[i * 3 + 0] = (float)(imageData[i] & 0xff) / 255.0f;
+			image[i * 3 + 1] = (float)((imageData[i] >> 8) & 0xff) / 255.0f;
+			image[i * 3 + 2] = (float)((imageData[i] >> 16) & 0xff) / 255.0f;
+		}
+
+		return image;
+	}
+
+	static double RootMeanSquaredError(const std::vector<float>& image, const std::vector<float>& reference) {
+		double sum = 0.0;
+		for (size_t i = 0; i < image.size(); i++) {
+			double difference = (double)image[i] - (double)reference[i];
+			sum += difference * difference;
+		}
+
+		return std::sqrt(sum / (double)image.size());
+	}
+}
+
+int RunSamplerBenchmark(int argc, char** argv) {
+	Utils::SamplerBenchmarkOptions options;
+	if (!Utils::ParseSamplerBenchmarkArguments(argc, argv, options)) {
+		Utils::PrintSamplerBenchmarkUsage();
+		return 1;
+	}
+
+	Scene scene;
+	SceneSerializer sceneSerializer(scene);
+	if (!sceneSerializer.Deserialize(options.ScenePath)) {
+		spdlog::error("SamplerBenchmark - Could not load scene: {0}", options.ScenePath.string());
+		return 1;
+	}
+
+	Renderer renderer;
+	Renderer::Settings& settings = renderer.GetSettings();
+	settings.Accumulate = true;
+	settings.RayBounces = options.RayBounces;
+
+	Camera camera(45.0f, 0.1f, 1000.0f);
+	renderer.OnResize(options.Width, options.Height);
+	camera.OnResize(options.Width, options.Height);
+
+	// Independent samples with a different seed, so the reference shares no structure with any measured render
+	spdlog::info("SamplerBenchmark - Rendering {0} sample reference", options.ReferenceSamples);
+
+	settings.SamplerType = Sampler::Type::Independent;
+	settings.Seed = options.Seed + 1;
+	renderer.ResetFrameIndex();
+	for (uint32_t sample = 0; sample < options.ReferenceSamples; sample++) {
+		renderer.Render(scene, camera);
+	}
+
+	std::vector<float> reference = Utils::ReadImage(renderer);
+
+	const Sampler::Type samplerTypes[] = { Sampler::Type::Independent, Sampler::Type::Sobol, Sampler::Type::BlueNoise };
+	constexpr size_t samplerCount = sizeof(samplerTypes) / sizeof(samplerTypes[0]);
+
+	std::vector<uint32_t> sampleCounts;
+	for (uint32_t samples = 1; samples <= options.MaxSamples; samples *= 2) {
+		sampleCounts.push_back(samples);
+	}
+
+	// errors[sampler][sample count]
+	std::vector<std::vector<double>> errors(samplerCount);
+
+	settings.Seed = options.Seed;
+	for (size_t i = 0; i < samplerCount; i++) {
+		spdlog::info("SamplerBenchmark - Measuring {0}", Sampler::GetTypeName(samplerTypes[i]));
+
+		settings.SamplerType = samplerTypes[i];
+		renderer.ResetFrameIndex();
+
+		uint32_t samples = 0;
+		for (uint32_t sampleCount : sampleCounts) {
+			for (; samples < sampleCount; samples++) {
+				renderer.Render(scene, camera);
+			}
+
+			errors[i].push_back(Utils::RootMeanSquaredError(Utils::ReadImage(renderer), reference));
+		}
+	}
+
+	printf("\n%-10s", "Samples");
+	for (Sampler::Type type : samplerTypes) {
+		printf("%14s", Sampler::GetTypeName(type));
+	}
+	printf("\n");
+
+	for (size_t j = 0; j < sampleCounts.size(); j++) {
+		printf("%-10u", sampleCounts[j]);
+		for (size_t i = 0; i < samplerCount; i++) {
+			printf("%14.6f", errors[i][j]);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
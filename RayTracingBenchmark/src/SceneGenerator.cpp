@@ -0,0 +1,167 @@
+#include "SceneGenerator.h"
+
+#include "Renderer/Sampler.h"
+
+#include <cmath>
+#include <string>
+
+namespace Utils {
+	static float RandomFloat(uint32_t& state) {
+		state = Sampler::Hash(state);
+		return (float)(state >> 8) / 16777216.0f;
+	}
+
+	static float RandomFloat(uint32_t& state, float min, float max) {
+		return min + RandomFloat(state) * (max - min);
+	}
+
+	static void AddRandomMaterials(Scene& scene, uint32_t& state, int materialCount) {
+		scene.Materials.reserve(scene.Materials.size() + materialCount);
+		for (int i = 0; i < materialCount; i++) {
+			Material& material = scene.Materials.emplace_back();
+			material.Name = "Material " + std::to_string(i);
+			material.Albedo = glm::vec3(RandomFloat(state), RandomFloat(state), RandomFloat(state));
+			material.Roughness = RandomFloat(state);
+			material.Metallic = i % 3 == 0 ? 1.0f : 0.0f;
+
+			if (i == materialCount - 1) {
+				material.EmissionColor = material.Albedo;
+				material.EmissionPower = 4.0f;
+			}
+		}
+	}
+}
+
+Scene SceneGenerator::RandomSpheres(uint32_t sphereCount, uint32_t seed) {
+	uint32_t state = Sampler::Hash(seed ^ 0x9e3779b9u);
+
+	Scene scene;
+	scene.Name = "Random Spheres " + std::to_string(sphereCount);
+	scene.Sky.Enabled = true;
+
+	static constexpr int s_MaterialCount = 8;
+	Utils::AddRandomMaterials(scene, state, s_MaterialCount);
+
+	// Roughly 2% of the box volume is filled regardless of the count
+	float radius = 0.1f;
+	float halfExtent = 0.5f * std::cbrt((float)sphereCount * (4.0f / 3.0f) * 3.14159265f * radius * radius * radius / 0.02f);
+	glm::vec3 center(0.0f, 0.0f, -halfExtent);
+
+	scene.Spheres.reserve(sphereCount);
+	for (uint32_t i = 0; i < sphereCount; i++) {
+		Sphere& sphere = scene.Spheres.emplace_back();
+		sphere.Position = center + glm::vec3(
+			Utils::RandomFloat(state, -halfExtent, halfExtent),
+			Utils::RandomFloat(state, -halfExtent, halfExtent),
+			Utils::RandomFloat(state, -halfExtent, halfExtent)
+		);
+		sphere.Radius = radius * Utils::RandomFloat(state, 0.5f, 1.5f);
+		sphere.MaterialIndex = (int)(Utils::RandomFloat(state) * s_MaterialCount);
+	}
+
+	scene.MarkAllChanged();
+
+	return scene;
+}
+
+Scene SceneGenerator::SphereGrid(uint32_t countPerAxis, uint32_t seed) {
+	uint32_t state = Sampler::Hash(seed ^ 0x85ebca6bu);
+
+	Scene scene;
+	scene.Name = "Sphere Grid " + std::to_string(countPerAxis);
+	scene.Sky.Enabled = true;
+
+	static constexpr int s_MaterialCount = 8;
+	Utils::AddRandomMaterials(scene, state, s_MaterialCount);
+
+	// Same 2% volume density as RandomSpheres
+	float radius = 0.1f;
+	float spacing = std::cbrt((4.0f / 3.0f) * 3.14159265f * radius * radius * radius / 0.02f);
+	float halfExtent = 0.5f * spacing * (float)countPerAxis;
+	glm::vec3 first = glm::vec3(-halfExtent, -halfExtent, -2.0f * halfExtent) + glm::vec3(0.5f * spacing);
+
+	scene.Spheres.reserve((size_t)countPerAxis * countPerAxis * countPerAxis);
+	for (uint32_t z = 0; z < countPerAxis; z++) {
+		for (uint32_t y = 0; y < countPerAxis; y++) {
+			for (uint32_t x = 0; x < countPerAxis; x++) {
+				Sphere& sphere = scene.Spheres.emplace_back();
+				sphere.Position = first + glm::vec3((float)x, (float)y, (float)z) * spacing;
+				sphere.Radius = radius;
+				sphere.MaterialIndex = (int)(Utils::RandomFloat(state) * s_MaterialCount);
+			}
+		}
+	}
+
+	scene.MarkAllChanged();
+
+	return scene;
+}
+
+Scene SceneGenerator::GroundSphere(uint32_t sphereCount, uint32_t seed) {
+	uint32_t state = Sampler::Hash(seed ^ 0xc2b2ae35u);
+
+	Scene scene;
+	scene.Name = "Ground Sphere " + std::to_string(sphereCount);
+	scene.Sky.Enabled = true;
+
+	static constexpr int s_MaterialCount = 8;
+	Utils::AddRandomMaterials(scene, state, s_MaterialCount);
+
+	Material& groundMaterial = scene.Materials.emplace_back();
+	groundMaterial.Name = "Ground Material";
+	groundMaterial.Albedo = glm::vec3(0.0f, 0.0f, 1.0f);
+	groundMaterial.Roughness = 0.1f;
+
+	Material& sunMaterial = scene.Materials.emplace_back();
+	sunMaterial.Name = "Sun Material";
+	sunMaterial.Albedo = glm::vec3(0.8f, 0.5f, 0.2f);
+	sunMaterial.EmissionColor = sunMaterial.Albedo;
+	sunMaterial.EmissionPower = 1000.0f;
+
+	scene.Spheres.reserve(sphereCount + 2);
+
+	Sphere& ground = scene.Spheres.emplace_back();
+	ground.Position = glm::vec3(0.0f, -101.0f, 0.0f);
+	ground.Radius = 100.0f;
+	ground.MaterialIndex = s_MaterialCount;
+
+	Sphere& sun = scene.Spheres.emplace_back();
+	sun.Position = glm::vec3(3000.0f, 2000.0f, -10000.0f);
+	sun.Radius = 1000.0f;
+	sun.MaterialIndex = s_MaterialCount + 1;
+
+	// Spread over the ground so roughly a quarter of it is covered, whatever the count
+	float radius = 0.1f;
+	float halfExtent = 0.5f * std::sqrt((float)sphereCount * 3.14159265f * radius * radius / 0.25f);
+
+	for (uint32_t i = 0; i < sphereCount; i++) {
+		Sphere& sphere = scene.Spheres.emplace_back();
+		sphere.Radius = radius * Utils::RandomFloat(state, 0.5f, 1.5f);
+		sphere.Position = glm::vec3(
+			Utils::RandomFloat(state, -halfExtent, halfExtent),
+			-1.0f + sphere.Radius,
+			Utils::RandomFloat(state, -2.0f * halfExtent, 0.0f)
+		);
+		sphere.MaterialIndex = (int)(Utils::RandomFloat(state) * s_MaterialCount);
+	}
+
+	scene.MarkAllChanged();
+
+	return scene;
+}
+
+Scene SceneGenerator::EmissiveSpheres(uint32_t sphereCount, uint32_t seed) {
+	Scene scene = RandomSpheres(sphereCount, seed);
+	scene.Name = "Emissive Spheres " + std::to_string(sphereCount);
+	scene.Sky.Enabled = false;
+
+	for (size_t i = 0; i < scene.Materials.size(); i += 2) {
+		Material& material = scene.Materials[i];
+		material.EmissionColor = material.Albedo;
+		material.EmissionPower = 2.0f;
+	}
+
+	scene.MarkAllChanged();
+
+	return scene;
+}
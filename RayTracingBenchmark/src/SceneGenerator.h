@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Scene/Scene.h"
+
+#include <cstdint>
+
+// Procedural scenes for the benchmarks. The same arguments always produce the same scene.
+class SceneGenerator {
+public:
+	// sphereCount small spheres scattered through a box in front of the default camera, sized so the
+	// density stays the same for every count, plus a handful of diffuse, metallic and emissive materials
+	static Scene RandomSpheres(uint32_t sphereCount, uint32_t seed = 0);
+
+	// countPerAxis^3 equally sized spheres on a regular lattice in the same place as RandomSpheres
+	static Scene SphereGrid(uint32_t countPerAxis, uint32_t seed = 0);
+
+	// Default.yaml's layout: a huge ground sphere and a distant emissive sun, with sphereCount small
+	// spheres resting on the ground in front of the camera
+	static Scene GroundSphere(uint32_t sphereCount, uint32_t seed = 0);
+
+	// RandomSpheres without a sky, where half of the materials emit light
+	static Scene EmissiveSpheres(uint32_t sphereCount, uint32_t seed = 0);
+};
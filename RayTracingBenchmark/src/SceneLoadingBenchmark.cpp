@@ -0,0 +1,209 @@
+#include "Benchmarks.h"
+#include "SceneGenerator.h"
+
+#include "Scene/Scene.h"
+#include "Scene/Serializer/SceneSerializer.h"
+#include "Scene/Serializer/SceneStreamingDeserializer.h"
+#include "Scene/Serializer/SceneBinarySerializer.h"
+
+#include "Walnut/Timer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#if defined(WL_PLATFORM_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+	#include <Psapi.h>
+
+	#define popen _popen
+	#define pclose _pclose
+#else
+	#include <sys/resource.h>
+#endif
+
+namespace Utils {
+	struct SceneLoadingBenchmarkOptions {
+		std::vector<uint32_t> SphereCounts = { 10000, 100000, 1000000 };
+		std::filesystem::path Directory = std::filesystem::temp_directory_path() / "RayTracingBenchmark";
+	};
+
+	struct LoadMeasurement {
+		double Milliseconds = 0.0;
+		double BaselineMegabytes = 0.0;
+		double PeakMegabytes = 0.0;
+		size_t SphereCount = 0;
+	};
+
+	static const char* s_Loaders[] = { "yaml-tree", "yaml-streaming", "binary" };
+
+	static void PrintSceneLoadingBenchmarkUsage() {
+		printf(
+			"Usage: RayTracingBenchmark scene-loading [options]\n"
+			"\n"
+			"Options:\n"
+			"      --spheres <n,n,...>       Sphere counts of the generated scenes (default: 10000,100000,1000000)\n"
+			"      --directory <path>        Where the generated scenes are kept between runs (default: temp directory)\n"
+		);
+	}
+
+	static bool ParseSceneLoadingBenchmarkArguments(int argc, char** argv, SceneLoadingBenchmarkOptions& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (argument == "--spheres" && hasValue) {
+				if (!ParseCountList(argv[++i], options.SphereCounts)) {
+					return false;
+				}
+			} else if (argument == "--directory" && hasValue) {
+				options.Directory = argv[++i];
+			} else {
+				return false;
+			}
+		}
+
+		return !options.SphereCounts.empty();
+	}
+
+	// Largest resident set of this process so far
+	static double GetPeakMemoryMegabytes() {
+#if defined(WL_PLATFORM_WINDOWS)
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return (double)counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+	#if defined(__APPLE__)
+		return (double)usage.ru_maxrss / (1024.0 * 1024.0);
+	#else
+		return (double)usage.ru_maxrss / 1024.0;
+	#endif
+#endif
+	}
+
+	static bool LoadScene(const std::string& loader, const std::filesystem::path& filepath, Scene& scene) {
+		if (loader == "yaml-tree") {
+			SceneSerializer serializer(scene);
+			return serializer.Deserialize(filepath);
+		}
+		if (loader == "yaml-streaming") {
+			SceneStreamingDeserializer deserializer(scene);
+			return deserializer.Deserialize(filepath);
+		}
+		if (loader == "binary") {
+			SceneBinarySerializer serializer(scene);
+			return serializer.Deserialize(filepath);
+		}
+		return false;
+	}
+
+	// Peak memory can only be measured once per process, so every load runs in a fresh copy of the
+	// benchmark started with --measure, which prints its measurement on a single line
+	static int RunMeasurement(const std::string& loader, const std::filesystem::path& filepath) {
+		spdlog::set_level(spdlog::level::warn);
+
+		LoadMeasurement measurement;
+		measurement.BaselineMegabytes = GetPeakMemoryMegabytes();
+
+		Walnut::Timer timer;
+
+		Scene scene;
+		if (!LoadScene(loader, filepath, scene)) {
+			return 1;
+		}
+
+		measurement.Milliseconds = timer.ElapsedMillis();
+		measurement.PeakMegabytes = GetPeakMemoryMegabytes();
+		measurement.SphereCount = scene.Spheres.size();
+
+		printf("%f %f %f %zu\n", measurement.Milliseconds, measurement.BaselineMegabytes, measurement.PeakMegabytes, measurement.SphereCount);
+		return 0;
+	}
+
+	static bool MeasureInChildProcess(const std::string& loader, const std::filesystem::path& filepath, LoadMeasurement& measurement) {
+		std::string command = "\"" + std::string(GetExecutablePath()) + "\" scene-loading --measure " + loader + " \"" + filepath.string() + "\"";
+#if defined(WL_PLATFORM_WINDOWS)
+		// cmd.exe strips the outer quotes of the whole command line
+		command = "\"" + command + "\"";
+#endif
+
+		FILE* pipe = popen(command.c_str(), "r");
+		if (!pipe) {
+			return false;
+		}
+
+		int read = fscanf(pipe, "%lf %lf %lf %zu", &measurement.Milliseconds, &measurement.BaselineMegabytes, &measurement.PeakMegabytes, &measurement.SphereCount);
+		int exitCode = pclose(pipe);
+
+		return read == 4 && exitCode == 0;
+	}
+
+	static bool PrepareScenes(uint32_t sphereCount, const std::filesystem::path& yamlPath, const std::filesystem::path& binaryPath) {
+		if (std::filesystem::exists(yamlPath) && std::filesystem::exists(binaryPath)) {
+			return true;
+		}
+
+		spdlog::info("SceneLoadingBenchmark - Generating scene with {0} spheres", sphereCount);
+
+		Scene scene = SceneGenerator::RandomSpheres(sphereCount);
+
+		SceneSerializer serializer(scene);
+		SceneBinarySerializer binarySerializer(scene);
+		return serializer.Serialize(yamlPath) && binarySerializer.Serialize(binaryPath);
+	}
+}
+
+int RunSceneLoadingBenchmark(int argc, char** argv) {
+	if (argc == 4 && std::string(argv[1]) == "--measure") {
+		return Utils::RunMeasurement(argv[2], argv[3]);
+	}
+
+	Utils::SceneLoadingBenchmarkOptions options;
+	if (!Utils::ParseSceneLoadingBenchmarkArguments(argc, argv, options)) {
+		Utils::PrintSceneLoadingBenchmarkUsage();
+		return 1;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(options.Directory, error);
+
+	printf("\n%-10s %-16s %12s %14s %14s %12s\n", "Spheres", "Loader", "File (MB)", "Load (ms)", "Memory (MB)", "Peak (MB)");
+
+	for (uint32_t sphereCount : options.SphereCounts) {
+		std::string name = "spheres-" + std::to_string(sphereCount);
+		std::filesystem::path yamlPath = options.Directory / (name + ".yaml");
+		std::filesystem::path binaryPath = options.Directory / (name + SceneBinarySerializer::s_Extension);
+
+		if (!Utils::PrepareScenes(sphereCount, yamlPath, binaryPath)) {
+			spdlog::error("SceneLoadingBenchmark - Could not write scenes to {0}", options.Directory.string());
+			return 1;
+		}
+
+		for (const char* loader : Utils::s_Loaders) {
+			const std::filesystem::path& filepath = std::string(loader) == "binary" ? binaryPath : yamlPath;
+			double fileMegabytes = (double)std::filesystem::file_size(filepath) / (1024.0 * 1024.0);
+
+			// The node tree of a million sphere scene can exhaust memory and get the child killed, the other loaders still get measured
+			Utils::LoadMeasurement measurement;
+			if (!Utils::MeasureInChildProcess(loader, filepath, measurement) || measurement.SphereCount != sphereCount) {
+				printf("%-10u %-16s %12.1f %14s %14s %12s\n", sphereCount, loader, fileMegabytes, "failed", "-", "-");
+				fflush(stdout);
+				continue;
+			}
+
+			// Memory is the growth of the peak over what the process used before loading
+			printf("%-10u %-16s %12.1f %14.1f %14.1f %12.1f\n", sphereCount, loader, fileMegabytes, measurement.Milliseconds,
+				measurement.PeakMegabytes - measurement.BaselineMegabytes, measurement.PeakMegabytes);
+			fflush(stdout);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+project "RayTracingCLI"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++17"
+   staticruntime "off"
+
+   -- Headless renderer: only the renderer and scene code, no Walnut application, ImGui or Vulkan
+   files
+   {
+      "src/**.h",
+      "src/**.cpp",
+
+      "../RayTracing/src/Renderer/**.h",
+      "../RayTracing/src/Renderer/**.cpp",
+      "../RayTracing/src/Scene/**.h",
+      "../RayTracing/src/Scene/**.cpp",
+      "../RayTracing/src/Utils/**.h",
+      "../RayTracing/src/Utils/**.cpp",
+   }
+
+   removefiles
+   {
+      "../RayTracing/src/Scene/CameraInput.cpp",
+   }
+
+   includedirs
+   {
+      "../RayTracing/src",
+
+      -- Header-only parts of Walnut (Timer)
+      "../Walnut/Walnut/Source",
+
+      "../Walnut/vendor/glm",
+      "../Walnut/vendor/yaml-cpp/include",
+      "../Walnut/vendor/spdlog/include",
+   }
+
+   defines {
+      "YAML_CPP_STATIC_DEFINE"
+   }
+
+   links
+   {
+      "yaml-cpp"
+   }
+
+   targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+   objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+   filter "system:windows"
+      systemversion "latest"
+      defines { "WL_PLATFORM_WINDOWS" }
+
+   filter "system:linux"
+      links { "pthread" }
+
+   filter "configurations:Debug"
+      defines { "WL_DEBUG" }
+      runtime "Debug"
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "WL_RELEASE" }
+      runtime "Release"
+      optimize "On"
+      symbols "On"
+
+   filter "configurations:Dist"
+      defines { "WL_DIST" }
+      runtime "Release"
+      optimize "On"
+      symbols "Off"
@@ -0,0 +1,291 @@
+#include "Renderer/Renderer.h"
+#include "Renderer/Serializer/RendererSettingsSerializer.h"
+#include "Scene/Camera.h"
+#include "Scene/Scene.h"
+#include "Scene/Serializer/SceneSerializer.h"
+#include "Scene/Serializer/SceneBinarySerializer.h"
+#include "Scene/Serializer/SceneStreamingDeserializer.h"
+#include "Scene/Importer/MeshImporter.h"
+#include "Utils/Profiler.h"
+
+#include "Walnut/Timer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+struct Options {
+	std::filesystem::path ScenePath;
+	std::filesystem::path OutputPath = "output.ppm";
+	std::filesystem::path SettingsPath;
+	std::filesystem::path ConvertPath;
+	std::filesystem::path TracePath;
+
+	uint32_t Width = 1280;
+	uint32_t Height = 720;
+	uint32_t Samples = 64;
+
+	int RayBounces = -1;
+	int ThreadCount = -1;
+
+	bool HasTonemapper = false;
+	Tonemapper::Type TonemapperType = Tonemapper::Type::None;
+	bool HasIntegrator = false;
+	Renderer::Integrator IntegratorType = Renderer::Integrator::PerPixel;
+
+	bool HasCameraPosition = false;
+	glm::vec3 CameraPosition{ 0.0f };
+
+	bool ShowHelp = false;
+};
+
+namespace Utils {
+	static void PrintUsage() {
+		printf(
+			"Usage: RayTracingCLI <scene.yaml|scene.rtscene> [options]\n"
+			"\n"
+			"Options:\n"
+			"  -o, --output <file.ppm>      Output image (default: output.ppm)\n"
+			"  -w, --width <pixels>         Image width (default: 1280)\n"
+			"  -h, --height <pixels>        Image height (default: 720)\n"
+			"  -s, --samples <count>        Accumulated samples per pixel (default: 64)\n"
+			"  -b, --bounces <count>        Ray bounces (default: from settings)\n"
+			"  -t, --threads <count>        Render threads, 0 = all (default: from settings)\n"
+			"      --settings <file.yaml>   Renderer settings file to start from\n"
+			"      --tonemapper <name>      None, sRGB or ACES (default: from settings)\n"
+			"      --integrator <name>      PerPixel or Wavefront (default: from settings)\n"
+			"      --camera <x> <y> <z>     Camera position (default: 0 0 6)\n"
+			"      --convert <file>         Write the scene to <file> instead of rendering, the format\n"
+			"                               follows the extension (.yaml or .rtscene)\n"
+			"      --trace <file.json>      Profile the render and write a Chrome trace\n"
+			"      --help                   Show this message\n"
+		);
+	}
+
+	static bool ParseArguments(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (argument == "--help") {
+				// -h is the height, so help only has the long form
+				options.ShowHelp = true;
+				return true;
+			} else if ((argument == "-o" || argument == "--output") && hasValue) {
+				options.OutputPath = argv[++i];
+			} else if ((argument == "-w" || argument == "--width") && hasValue) {
+				options.Width = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-h" || argument == "--height") && hasValue) {
+				options.Height = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-s" || argument == "--samples") && hasValue) {
+				options.Samples = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+			} else if ((argument == "-b" || argument == "--bounces") && hasValue) {
+				options.RayBounces = std::atoi(argv[++i]);
+			} else if ((argument == "-t" || argument == "--threads") && hasValue) {
+				options.ThreadCount = std::atoi(argv[++i]);
+			} else if (argument == "--settings" && hasValue) {
+				options.SettingsPath = argv[++i];
+			} else if (argument == "--tonemapper" && hasValue) {
+				if (!Tonemapper::TryParseType(argv[++i], options.TonemapperType)) {
+					spdlog::error("RayTracingCLI - Unknown tonemapper: {0}", argv[i]);
+					return false;
+				}
+				options.HasTonemapper = true;
+			} else if (argument == "--integrator" && hasValue) {
+				if (!Renderer::TryParseIntegrator(argv[++i], options.IntegratorType)) {
+					spdlog::error("RayTracingCLI - Unknown integrator: {0}", argv[i]);
+					return false;
+				}
+				options.HasIntegrator = true;
+			} else if (argument == "--convert" && hasValue) {
+				options.ConvertPath = argv[++i];
+			} else if (argument == "--trace" && hasValue) {
+				options.TracePath = argv[++i];
+			} else if (argument == "--camera" && i + 3 < argc) {
+				options.CameraPosition.x = std::strtof(argv[++i], nullptr);
+				options.CameraPosition.y = std::strtof(argv[++i], nullptr);
+				options.CameraPosition.z = std::strtof(argv[++i], nullptr);
+				options.HasCameraPosition = true;
+			} else if (argument[0] != '-' && options.ScenePath.empty()) {
+				options.ScenePath = argument;
+			} else {
+				spdlog::error("RayTracingCLI - Unknown or incomplete argument: {0}", argument);
+				return false;
+			}
+		}
+
+		if (options.ScenePath.empty()) {
+			spdlog::error("RayTracingCLI - No scene file given");
+			return false;
+		}
+
+		if (options.Width == 0 || options.Height == 0 || options.Samples == 0) {
+			spdlog::error("RayTracingCLI - Width, height and samples must be greater than 0");
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool LoadScene(Scene& scene, const std::filesystem::path& filepath) {
+		if (SceneBinarySerializer::IsBinaryScene(filepath)) {
+			SceneBinarySerializer serializer(scene);
+			return serializer.Deserialize(filepath);
+		}
+
+		SceneStreamingDeserializer deserializer(scene);
+		return deserializer.Deserialize(filepath);
+	}
+
+	static bool SaveScene(Scene& scene, const std::filesystem::path& filepath) {
+		if (SceneBinarySerializer::IsBinaryScene(filepath)) {
+			SceneBinarySerializer serializer(scene);
+			return serializer.Serialize(filepath);
+		}
+
+		SceneSerializer serializer(scene);
+		return serializer.Serialize(filepath);
+	}
+
+	static bool WritePPM(const std::filesystem::path& filepath, const uint32_t* imageData, uint32_t width, uint32_t height) {
+		std::ofstream fout(filepath, std::ios::binary);
+		if (!fout) {
+			return false;
+		}
+
+		fout << "P6\n" << width << " " << height << "\n255\n";
+
+		// Row 0 of the image data is the bottom of the picture, PPM starts at the top
+		std::vector<uint8_t> row(width * 3);
+		for (uint32_t y = height; y-- > 0;) {
+			for (uint32_t x = 0; x < width; x++) {
+				uint32_t color = imageData[x + y * width];
+				row[x * 3 + 0] = (uint8_t)(color & 0xff);
+				row[x * 3 + 1] = (uint8_t)((color >> 8) & 0xff);
+				row[x * 3 + 2] = (uint8_t)((color >> 16) & 0xff);
+			}
+
+			fout.write((const char*)row.data(), row.size());
+		}
+
+		return (bool)fout;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!Utils::ParseArguments(argc, argv, options)) {
+		Utils::PrintUsage();
+		return 1;
+	}
+
+	if (options.ShowHelp) {
+		Utils::PrintUsage();
+		return 0;
+	}
+
+	Walnut::Timer loadTimer;
+
+	Scene scene;
+	if (!Utils::LoadScene(scene, options.ScenePath)) {
+		spdlog::error("RayTracingCLI - Could not load scene: {0}", options.ScenePath.string());
+		return 1;
+	}
+
+	spdlog::info("RayTracingCLI - Loaded {0} spheres in {1:.1f}ms", scene.Spheres.size(), loadTimer.ElapsedMillis());
+
+	if (!options.ConvertPath.empty()) {
+		if (!Utils::SaveScene(scene, options.ConvertPath)) {
+			spdlog::error("RayTracingCLI - Could not write scene: {0}", options.ConvertPath.string());
+			return 1;
+		}
+
+		spdlog::info("RayTracingCLI - Scene written to {0}", options.ConvertPath.string());
+		return 0;
+	}
+
+	// Converting only needs the mesh references, rendering needs the triangles
+	if (!scene.Meshes.empty()) {
+		Walnut::Timer meshTimer;
+		MeshImporter::ImportSceneMeshes(scene);
+		spdlog::info("RayTracingCLI - Imported {0} meshes in {1:.1f}ms", scene.Meshes.size(), meshTimer.ElapsedMillis());
+	}
+
+	Renderer renderer;
+
+	if (!options.SettingsPath.empty()) {
+		RendererSettingsSerializer settingsSerializer(renderer.GetSettings());
+		if (!settingsSerializer.Deserialize(options.SettingsPath)) {
+			spdlog::warn("RayTracingCLI - Could not load renderer settings: {0}", options.SettingsPath.string());
+		}
+	}
+
+	Renderer::Settings& settings = renderer.GetSettings();
+	settings.Accumulate = true;
+	settings.FrameTimeBudget = false; // Every Render call has to add exactly one sample to every pixel
+
+	if (options.RayBounces >= 0) {
+		settings.RayBounces = options.RayBounces;
+	}
+
+	if (options.HasTonemapper) {
+		settings.TonemapperType = options.TonemapperType;
+	}
+
+	if (options.HasIntegrator) {
+		settings.IntegratorType = options.IntegratorType;
+	}
+
+	if (options.ThreadCount >= 0) {
+		settings.Multithreading = options.ThreadCount != 1;
+		settings.ThreadCount = options.ThreadCount;
+	}
+
+	Camera camera(45.0f, 0.1f, 1000.0f);
+	if (options.HasCameraPosition) {
+		camera.GetCameraData().Position = options.CameraPosition;
+	}
+
+	renderer.OnResize(options.Width, options.Height);
+	camera.OnResize(options.Width, options.Height);
+	renderer.ResetFrameIndex();
+
+	spdlog::info("RayTracingCLI - Rendering {0} at {1}x{2}, {3} samples", scene.Name, options.Width, options.Height, options.Samples);
+
+	Profiler::SetEnabled(!options.TracePath.empty());
+
+	Walnut::Timer timer;
+
+	for (uint32_t sample = 0; sample < options.Samples; sample++) {
+		renderer.Render(scene, camera);
+	}
+
+	float renderTime = timer.ElapsedMillis();
+
+	spdlog::info("RayTracingCLI - Rendered in {0:.1f}ms ({1:.3f}ms per sample)", renderTime, renderTime / options.Samples);
+	spdlog::info("RayTracingCLI - Average path length: {0:.2f} rays", renderer.GetStats().AveragePathLength);
+
+	if (Profiler::IsEnabled()) {
+		// Collects the whole render as a single frame
+		Profiler::NewFrame();
+
+		for (const Profiler::StageTime& stage : Profiler::GetStageTimes()) {
+			spdlog::info("RayTracingCLI - {0}: {1:.1f}ms, {2} calls", stage.Name, stage.Time, stage.Calls);
+		}
+
+		Profiler::ExportChromeTrace(options.TracePath);
+	}
+
+	if (!Utils::WritePPM(options.OutputPath, renderer.GetImageData(), renderer.GetWidth(), renderer.GetHeight())) {
+		spdlog::error("RayTracingCLI - Could not write image: {0}", options.OutputPath.string());
+		return 1;
+	}
+
+	spdlog::info("RayTracingCLI - Image written to {0}", options.OutputPath.string());
+
+	return 0;
+}